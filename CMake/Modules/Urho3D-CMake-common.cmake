@@ -198,6 +198,7 @@ else ()
 endif ()
 option (URHO3D_PACKAGING "Enable resources packaging support, on Web platform default to 1, on other platforms default to 0" ${WEB})
 option (URHO3D_PROFILING "Enable profiling support" TRUE)
+option (URHO3D_SIZE_CLASS_ALLOCATOR "Enable thread-caching size class allocator for engine containers" TRUE)
 option (URHO3D_LOGGING "Enable logging support" TRUE)
 # Emscripten thread support is yet experimental; default false
 if (NOT WEB)
@@ -370,6 +371,11 @@ if (URHO3D_PROFILING)
     add_definitions (-DURHO3D_PROFILING)
 endif ()
 
+# Enable the size class allocator by default. If disabled, container buffers are allocated directly from the heap.
+if (URHO3D_SIZE_CLASS_ALLOCATOR)
+    add_definitions (-DURHO3D_SIZE_CLASS_ALLOCATOR)
+endif ()
+
 # Enable logging by default. If disabled, LOGXXXX macros become no-ops and the Log subsystem is not instantiated.
 if (URHO3D_LOGGING)
     add_definitions (-DURHO3D_LOGGING)
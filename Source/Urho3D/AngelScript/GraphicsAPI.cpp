@@ -2001,6 +2001,11 @@ static void RegisterOctree(asIScriptEngine* engine)
     engine->RegisterEnumValue("RayQueryLevel", "RAY_TRIANGLE", RAY_TRIANGLE);
     engine->RegisterEnumValue("RayQueryLevel", "RAY_TRIANGLE_UV", RAY_TRIANGLE_UV);
 
+    engine->RegisterEnum("SpatialIndexType");
+    engine->RegisterEnumValue("SpatialIndexType", "SPATIAL_INDEX_OCTREE", SPATIAL_INDEX_OCTREE);
+    engine->RegisterEnumValue("SpatialIndexType", "SPATIAL_INDEX_LOOSE_OCTREE", SPATIAL_INDEX_LOOSE_OCTREE);
+    engine->RegisterEnumValue("SpatialIndexType", "SPATIAL_INDEX_AABB_TREE", SPATIAL_INDEX_AABB_TREE);
+
     engine->RegisterObjectType("RayQueryResult", sizeof(RayQueryResult), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_C);
     engine->RegisterObjectBehaviour("RayQueryResult", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION(ConstructRayQueryResult), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectProperty("RayQueryResult", "Vector3 position", offsetof(RayQueryResult, position_));
@@ -2025,6 +2030,8 @@ static void RegisterOctree(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Octree", "Array<Drawable@>@ GetAllDrawables(uint8 drawableFlags = DRAWABLE_ANY, uint viewMask = DEFAULT_VIEWMASK)", asFUNCTION(OctreeGetAllDrawables), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Octree", "const BoundingBox& get_worldBoundingBox() const", asMETHODPR(Octree, GetWorldBoundingBox, () const, const BoundingBox&), asCALL_THISCALL);
     engine->RegisterObjectMethod("Octree", "uint get_numLevels() const", asMETHOD(Octree, GetNumLevels), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Octree", "void set_spatialIndexType(SpatialIndexType)", asMETHOD(Octree, SetSpatialIndexType), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Octree", "SpatialIndexType get_spatialIndexType() const", asMETHOD(Octree, GetSpatialIndexType), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "Octree@+ get_octree() const", asFUNCTION(SceneGetOctree), asCALL_CDECL_OBJLAST);
     engine->RegisterGlobalFunction("Octree@+ get_octree()", asFUNCTION(GetOctree), asCALL_CDECL);
 }
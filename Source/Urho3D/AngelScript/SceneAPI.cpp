@@ -172,6 +172,37 @@ static CScriptArray* SceneGetNodesWithTag(const String& tag, Scene* ptr)
     return VectorToHandleArray<Node>(nodes, "Array<Node@>");
 }
 
+static CScriptArray* SceneGetNodesWithTags(CScriptArray* required, CScriptArray* optional, CScriptArray* excluded, Scene* ptr)
+{
+    TagQuery query;
+    PODVector<unsigned> tags = ArrayToPODVector<unsigned>(required);
+    for (unsigned i = 0; i < tags.Size(); ++i)
+        query.Require(tags[i]);
+    tags = ArrayToPODVector<unsigned>(optional);
+    for (unsigned i = 0; i < tags.Size(); ++i)
+        query.Optional(tags[i]);
+    tags = ArrayToPODVector<unsigned>(excluded);
+    for (unsigned i = 0; i < tags.Size(); ++i)
+        query.Exclude(tags[i]);
+
+    PODVector<Node*> nodes;
+    for (TagQueryIterator i = ptr->QueryTags(query); !i.IsEnd(); ++i)
+        nodes.Push(*i);
+    return VectorToHandleArray<Node>(nodes, "Array<Node@>");
+}
+
+static CScriptArray* SceneGetComponentsByType(const String& type, Scene* ptr)
+{
+    return VectorToHandleArray<Component>(ptr->GetComponentsByType(StringHash(type)), "Array<Component@>");
+}
+
+static CScriptArray* SceneGetDerivedComponentsByType(const String& type, Scene* ptr)
+{
+    PODVector<Component*> components;
+    ptr->GetDerivedComponentsByType(components, StringHash(type));
+    return VectorToHandleArray<Component>(components, "Array<Component@>");
+}
+
 static bool SceneLoadJSONVectorBuffer(VectorBuffer& buffer, Scene* ptr)
 {
     return ptr->LoadJSON(buffer);
@@ -187,6 +218,16 @@ static bool SceneSaveXML(File* file, const String& indentation, Scene* ptr)
     return file && ptr->SaveXML(*file, indentation);
 }
 
+static bool SceneSavePacked(File* file, Scene* ptr)
+{
+    return file && ptr->SavePacked(*file);
+}
+
+static bool SceneLoadPacked(const String& fileName, Scene* ptr)
+{
+    return ptr->LoadPacked(fileName);
+}
+
 static bool SceneSaveJSON(File* file, const String& indentation, Scene* ptr)
 {
     return file && ptr->SaveJSON(*file, indentation);
@@ -337,6 +378,8 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "bool LoadJSON(VectorBuffer&)", asFUNCTION(SceneLoadJSONVectorBuffer), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "bool SaveJSON(File@+, const String&in indentation = \"\t\")", asFUNCTION(SceneSaveJSON), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "bool SaveJSON(VectorBuffer&, const String&in indentation = \"\t\")", asFUNCTION(SceneSaveJSONVectorBuffer), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Scene", "bool SavePacked(File@+) const", asFUNCTION(SceneSavePacked), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Scene", "bool LoadPacked(const String&in)", asFUNCTION(SceneLoadPacked), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Scene", "bool LoadAsync(File@+, LoadMode mode = LOAD_SCENE_AND_RESOURCES)", asMETHOD(Scene, LoadAsync), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "bool LoadAsyncXML(File@+, LoadMode mode = LOAD_SCENE_AND_RESOURCES)", asMETHOD(Scene, LoadAsyncXML), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void StopAsyncLoading()", asMETHOD(Scene, StopAsyncLoading), asCALL_THISCALL);
@@ -362,11 +405,17 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "void UnregisterAllVars(const String&in)", asMETHOD(Scene, UnregisterAllVars), asCALL_THISCALL);
 
     engine->RegisterObjectMethod("Scene", "Array<Node@>@ GetNodesWithTag(const String&in) const", asFUNCTION(SceneGetNodesWithTag), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Scene", "uint GetTagIndex(const String&in)", asMETHOD(Scene, GetTagIndex), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "const String& GetTagName(uint) const", asMETHOD(Scene, GetTagName), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "Array<Node@>@ GetNodesWithTags(Array<uint>@+, Array<uint>@+, Array<uint>@+) const", asFUNCTION(SceneGetNodesWithTags), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Scene", "Array<Component@>@ GetComponentsByType(const String&in) const", asFUNCTION(SceneGetComponentsByType), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Scene", "Array<Component@>@ GetDerivedComponentsByType(const String&in) const", asFUNCTION(SceneGetDerivedComponentsByType), asCALL_CDECL_OBJLAST);
 
     engine->RegisterObjectMethod("Scene", "Component@+ GetComponent(uint) const", asMETHODPR(Scene, GetComponent, (unsigned) const, Component*), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "Node@+ GetNode(uint) const", asMETHOD(Scene, GetNode), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "const String& GetVarName(StringHash) const", asMETHOD(Scene, GetVarName), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void Update(float)", asMETHOD(Scene, Update), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void UpdateTransforms()", asMETHOD(Scene, UpdateTransforms), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_updateEnabled(bool)", asMETHOD(Scene, SetUpdateEnabled), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "bool get_updateEnabled() const", asMETHOD(Scene, IsUpdateEnabled), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_timeScale(float)", asMETHOD(Scene, SetTimeScale), asCALL_THISCALL);
@@ -382,6 +431,10 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "LoadMode get_asyncLoadMode() const", asMETHOD(Scene, GetAsyncLoadMode), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_asyncLoadingMs(int)", asMETHOD(Scene, SetAsyncLoadingMs), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "int get_asyncLoadingMs() const", asMETHOD(Scene, GetAsyncLoadingMs), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_transformStoreEnabled(bool)", asMETHOD(Scene, SetTransformStoreEnabled), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "bool get_transformStoreEnabled() const", asMETHOD(Scene, IsTransformStoreEnabled), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_deferredDirtyEnabled(bool)", asMETHOD(Scene, SetDeferredDirtyEnabled), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "bool get_deferredDirtyEnabled() const", asMETHOD(Scene, IsDeferredDirtyEnabled), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "uint get_checksum() const", asMETHOD(Scene, GetChecksum), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "const String& get_fileName() const", asMETHOD(Scene, GetFileName), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "Array<PackageFile@>@ get_requiredPackageFiles() const", asFUNCTION(SceneGetRequiredPackageFiles), asCALL_CDECL_OBJLAST);
@@ -283,6 +283,8 @@ void Audio::MixOutput(void* dest, unsigned samples)
         return;
     }
 
+    URHO3D_MEMORY_CATEGORY(MC_AUDIO);
+
     while (samples)
     {
         // If sample count exceeds the fragment (clip buffer) size, split the work
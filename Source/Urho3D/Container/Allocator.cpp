@@ -22,6 +22,11 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Atomic.h"
+#include "../Core/Thread.h"
+
+#include <cstdlib>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -119,4 +124,335 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     allocator->free_ = node;
 }
 
+const char* memoryCategoryNames[] =
+{
+    "General",
+    "Resource",
+    "Scene",
+    "Renderer",
+    "Physics",
+    "UI",
+    "Audio",
+    "Network",
+    0
+};
+
+#ifdef URHO3D_SIZE_CLASS_ALLOCATOR
+/// Number of size classes in 16 byte steps, up to 128 bytes.
+static const unsigned NUM_LINEAR_SIZE_CLASSES = 8;
+/// Number of size classes per doubling of size above 128 bytes.
+static const unsigned SIZE_CLASSES_PER_DOUBLING = 4;
+/// Largest size served from the size classes.
+static const unsigned MAX_SIZE_CLASS_SIZE = 32768;
+/// Number of size classes.
+static const unsigned NUM_SIZE_CLASSES = 40;
+/// Size of memory slabs divided into blocks.
+static const unsigned MEMORY_SLAB_SIZE = 65536;
+/// Bytes of blocks moved at once between a thread cache and the shared pool.
+static const unsigned MEMORY_BATCH_BYTES = 16384;
+#endif
+
+/// Free memory block in a size class.
+struct MemoryBlock
+{
+    /// Next free block.
+    MemoryBlock* next_;
+};
+
+/// Free blocks of one size class.
+struct MemoryBlockList
+{
+    /// First free block.
+    MemoryBlock* free_;
+    /// Number of free blocks.
+    unsigned numFree_;
+};
+
+/// Memory block cache and statistics of a thread.
+struct ThreadMemoryCache
+{
+#ifdef URHO3D_SIZE_CLASS_ALLOCATOR
+    /// Free blocks per size class.
+    MemoryBlockList classes_[NUM_SIZE_CLASSES];
+#endif
+    /// Allocation statistics per category.
+    MemoryCategoryStats categories_[MAX_MEMORY_CATEGORIES];
+    /// Number of frees.
+    long long frees_;
+    /// Number of bytes freed.
+    long long freedBytes_;
+    /// Next cache in the registry.
+    ThreadMemoryCache* next_;
+    /// Released flag. Set when the owning thread has exited, so that the cache can be reused by a new thread.
+    bool released_;
+};
+
+/// Memory cache of the calling thread.
+static URHO3D_THREAD_LOCAL ThreadMemoryCache* currentCache = 0;
+/// Memory category of the calling thread.
+static URHO3D_THREAD_LOCAL int currentCategory = MC_GENERAL;
+/// Registry of all thread caches, for statistics and reuse.
+static ThreadMemoryCache* threadCaches = 0;
+/// Registry lock. The engine Mutex can not be used, as allocations may happen during static initialization.
+static volatile int threadCachesLock = 0;
+
+#ifdef URHO3D_SIZE_CLASS_ALLOCATOR
+/// Shared free blocks per size class.
+static MemoryBlockList sharedClasses[NUM_SIZE_CLASSES];
+/// Locks of the shared size classes.
+static volatile int sharedClassLocks[NUM_SIZE_CLASSES];
+/// Number of kilobytes reserved for size class blocks.
+static volatile int reservedKBytes = 0;
+#endif
+
+static void AcquireSpinLock(volatile int& lock)
+{
+    while (!AtomicCompareExchange(lock, 0, 1))
+    {
+        while (AtomicLoad(lock))
+        {
+        }
+    }
+}
+
+static void ReleaseSpinLock(volatile int& lock)
+{
+    AtomicStore(lock, 0);
+}
+
+static ThreadMemoryCache* GetThreadMemoryCache()
+{
+    ThreadMemoryCache* cache = currentCache;
+    if (cache)
+        return cache;
+
+    AcquireSpinLock(threadCachesLock);
+
+    for (cache = threadCaches; cache; cache = cache->next_)
+    {
+        if (cache->released_)
+        {
+            cache->released_ = false;
+            break;
+        }
+    }
+
+    if (!cache)
+    {
+        // Allocate outside the engine allocator; the cache is zero-initialized by calloc
+        cache = static_cast<ThreadMemoryCache*>(calloc(1, sizeof(ThreadMemoryCache)));
+        cache->next_ = threadCaches;
+        threadCaches = cache;
+    }
+
+    ReleaseSpinLock(threadCachesLock);
+
+    currentCache = cache;
+    return cache;
+}
+
+#ifdef URHO3D_SIZE_CLASS_ALLOCATOR
+static unsigned GetSizeClass(unsigned size)
+{
+    if (size <= 16 * NUM_LINEAR_SIZE_CLASSES)
+        return size ? (size - 1) >> 4 : 0;
+
+    // Above the linear classes, each doubling of size is divided into four classes
+    unsigned value = size - 1;
+    unsigned highBit = 0;
+    while (value >>= 1)
+        ++highBit;
+
+    unsigned step = highBit - 2;
+    return NUM_LINEAR_SIZE_CLASSES + (highBit - 7) * SIZE_CLASSES_PER_DOUBLING + (((size - 1) >> step) & 3);
+}
+
+static unsigned GetSizeClassSize(unsigned sizeClass)
+{
+    if (sizeClass < NUM_LINEAR_SIZE_CLASSES)
+        return (sizeClass + 1) << 4;
+
+    unsigned highBit = 7 + (sizeClass - NUM_LINEAR_SIZE_CLASSES) / SIZE_CLASSES_PER_DOUBLING;
+    unsigned step = (sizeClass - NUM_LINEAR_SIZE_CLASSES) % SIZE_CLASSES_PER_DOUBLING + 1;
+    return (1u << highBit) + (step << (highBit - 2));
+}
+
+static unsigned GetSizeClassBatch(unsigned sizeClass)
+{
+    unsigned batch = MEMORY_BATCH_BYTES / GetSizeClassSize(sizeClass);
+    return batch > 2 ? batch : 2;
+}
+
+static void RefillBlocks(unsigned sizeClass, MemoryBlockList& blocks)
+{
+    unsigned batch = GetSizeClassBatch(sizeClass);
+
+    // Take a batch of blocks from the shared pool
+    MemoryBlockList& shared = sharedClasses[sizeClass];
+    AcquireSpinLock(sharedClassLocks[sizeClass]);
+    while (shared.free_ && blocks.numFree_ < batch)
+    {
+        MemoryBlock* block = shared.free_;
+        shared.free_ = block->next_;
+        --shared.numFree_;
+        block->next_ = blocks.free_;
+        blocks.free_ = block;
+        ++blocks.numFree_;
+    }
+    ReleaseSpinLock(sharedClassLocks[sizeClass]);
+
+    if (blocks.free_)
+        return;
+
+    // Shared pool is empty as well; divide a new slab into blocks
+    unsigned blockSize = GetSizeClassSize(sizeClass);
+    unsigned slabSize = MEMORY_SLAB_SIZE;
+    unsigned char* slab = static_cast<unsigned char*>(malloc(slabSize));
+    if (!slab)
+        return;
+    AtomicAdd(reservedKBytes, (int)(slabSize >> 10));
+
+    for (unsigned offset = 0; offset + blockSize <= slabSize; offset += blockSize)
+    {
+        MemoryBlock* block = reinterpret_cast<MemoryBlock*>(slab + offset);
+        block->next_ = blocks.free_;
+        blocks.free_ = block;
+        ++blocks.numFree_;
+    }
+}
+
+static void ReleaseBlocks(unsigned sizeClass, MemoryBlockList& blocks, unsigned count)
+{
+    if (!count || !blocks.free_)
+        return;
+
+    // Find the last block to release, then link the whole chain to the shared pool at once
+    MemoryBlock* first = blocks.free_;
+    MemoryBlock* last = first;
+    unsigned released = 1;
+    while (released < count && last->next_)
+    {
+        last = last->next_;
+        ++released;
+    }
+    blocks.free_ = last->next_;
+    blocks.numFree_ -= released;
+
+    MemoryBlockList& shared = sharedClasses[sizeClass];
+    AcquireSpinLock(sharedClassLocks[sizeClass]);
+    last->next_ = shared.free_;
+    shared.free_ = first;
+    shared.numFree_ += released;
+    ReleaseSpinLock(sharedClassLocks[sizeClass]);
+}
+#endif
+
+void* AllocateMemory(unsigned size)
+{
+    ThreadMemoryCache* cache = GetThreadMemoryCache();
+    MemoryCategoryStats& stats = cache->categories_[currentCategory];
+    ++stats.allocations_;
+    stats.allocatedBytes_ += size;
+
+#ifdef URHO3D_SIZE_CLASS_ALLOCATOR
+    if (size <= MAX_SIZE_CLASS_SIZE)
+    {
+        unsigned sizeClass = GetSizeClass(size);
+        MemoryBlockList& blocks = cache->classes_[sizeClass];
+        if (!blocks.free_)
+        {
+            RefillBlocks(sizeClass, blocks);
+            if (!blocks.free_)
+                return 0;
+        }
+
+        MemoryBlock* block = blocks.free_;
+        blocks.free_ = block->next_;
+        --blocks.numFree_;
+        return block;
+    }
+#endif
+
+    return new unsigned char[size];
+}
+
+void FreeMemory(void* ptr, unsigned size)
+{
+    if (!ptr)
+        return;
+
+    ThreadMemoryCache* cache = GetThreadMemoryCache();
+    ++cache->frees_;
+    cache->freedBytes_ += size;
+
+#ifdef URHO3D_SIZE_CLASS_ALLOCATOR
+    if (size <= MAX_SIZE_CLASS_SIZE)
+    {
+        // Blocks freed by another thread than the allocating one migrate to this thread's cache
+        unsigned sizeClass = GetSizeClass(size);
+        MemoryBlockList& blocks = cache->classes_[sizeClass];
+        MemoryBlock* block = static_cast<MemoryBlock*>(ptr);
+        block->next_ = blocks.free_;
+        blocks.free_ = block;
+        ++blocks.numFree_;
+
+        unsigned batch = GetSizeClassBatch(sizeClass);
+        if (blocks.numFree_ > 2 * batch)
+            ReleaseBlocks(sizeClass, blocks, batch);
+        return;
+    }
+#endif
+
+    delete[] static_cast<unsigned char*>(ptr);
+}
+
+void ReleaseThreadMemoryCache()
+{
+    ThreadMemoryCache* cache = currentCache;
+    if (!cache)
+        return;
+
+#ifdef URHO3D_SIZE_CLASS_ALLOCATOR
+    for (unsigned i = 0; i < NUM_SIZE_CLASSES; ++i)
+        ReleaseBlocks(i, cache->classes_[i], cache->classes_[i].numFree_);
+#endif
+
+    currentCache = 0;
+    AcquireSpinLock(threadCachesLock);
+    cache->released_ = true;
+    ReleaseSpinLock(threadCachesLock);
+}
+
+void SetMemoryCategory(MemoryCategory category)
+{
+    currentCategory = category;
+}
+
+MemoryCategory GetMemoryCategory()
+{
+    return (MemoryCategory)currentCategory;
+}
+
+void GetMemoryStats(MemoryStats& dest)
+{
+    dest = MemoryStats();
+
+    AcquireSpinLock(threadCachesLock);
+    for (ThreadMemoryCache* cache = threadCaches; cache; cache = cache->next_)
+    {
+        for (unsigned i = 0; i < MAX_MEMORY_CATEGORIES; ++i)
+        {
+            dest.categories_[i].allocations_ += cache->categories_[i].allocations_;
+            dest.categories_[i].allocatedBytes_ += cache->categories_[i].allocatedBytes_;
+        }
+        dest.frees_ += cache->frees_;
+        dest.freedBytes_ += cache->freedBytes_;
+    }
+    ReleaseSpinLock(threadCachesLock);
+
+#ifdef URHO3D_SIZE_CLASS_ALLOCATOR
+    dest.reservedBytes_ = (long long)AtomicLoad(reservedKBytes) << 10;
+#endif
+}
+
 }
@@ -67,6 +67,98 @@ URHO3D_API void* AllocatorReserve(AllocatorBlock* allocator);
 /// Free a node. Does not free any blocks.
 URHO3D_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
 
+/// Memory statistics category. Allocations are attributed to the category active on the allocating thread.
+enum MemoryCategory
+{
+    MC_GENERAL = 0,
+    MC_RESOURCE,
+    MC_SCENE,
+    MC_RENDERER,
+    MC_PHYSICS,
+    MC_UI,
+    MC_AUDIO,
+    MC_NETWORK,
+    MAX_MEMORY_CATEGORIES
+};
+
+/// Memory category names.
+extern URHO3D_API const char* memoryCategoryNames[];
+
+/// Allocation statistics of one memory category.
+struct URHO3D_API MemoryCategoryStats
+{
+    /// Construct.
+    MemoryCategoryStats() :
+        allocations_(0),
+        allocatedBytes_(0)
+    {
+    }
+
+    /// Number of allocations.
+    long long allocations_;
+    /// Number of bytes allocated.
+    long long allocatedBytes_;
+};
+
+/// Engine memory allocation statistics.
+struct URHO3D_API MemoryStats
+{
+    /// Construct.
+    MemoryStats() :
+        frees_(0),
+        freedBytes_(0),
+        reservedBytes_(0)
+    {
+    }
+
+    /// Allocation statistics per category.
+    MemoryCategoryStats categories_[MAX_MEMORY_CATEGORIES];
+    /// Number of frees.
+    long long frees_;
+    /// Number of bytes freed.
+    long long freedBytes_;
+    /// Number of bytes reserved from the operating system for size class blocks.
+    long long reservedBytes_;
+};
+
+/// Allocate memory for engine containers. When the size class allocator is enabled, sizes up to 32 KB are served from thread-local caches without locking. Thread-safe.
+URHO3D_API void* AllocateMemory(unsigned size);
+/// Free memory allocated with AllocateMemory(). The size must be the same as when allocated. Can be freed from any thread.
+URHO3D_API void FreeMemory(void* ptr, unsigned size);
+/// Return cached memory blocks of the calling thread to the shared pool. Called automatically when a Thread exits.
+URHO3D_API void ReleaseThreadMemoryCache();
+/// Set the memory category of the calling thread.
+URHO3D_API void SetMemoryCategory(MemoryCategory category);
+/// Return the memory category of the calling thread.
+URHO3D_API MemoryCategory GetMemoryCategory();
+/// Return allocation statistics summed over all threads. The counts are approximate while other threads are allocating.
+URHO3D_API void GetMemoryStats(MemoryStats& dest);
+
+/// Helper class for setting the memory category of the calling thread for the duration of a scope.
+class URHO3D_API MemoryCategoryScope
+{
+public:
+    /// Construct and set the category.
+    MemoryCategoryScope(MemoryCategory category) :
+        previous_(GetMemoryCategory())
+    {
+        SetMemoryCategory(category);
+    }
+
+    /// Destruct and restore the previous category.
+    ~MemoryCategoryScope()
+    {
+        SetMemoryCategory(previous_);
+    }
+
+private:
+    /// Previous category.
+    MemoryCategory previous_;
+};
+
+/// Attribute allocations in the current scope to a memory category.
+#define URHO3D_MEMORY_CATEGORY(category) Urho3D::MemoryCategoryScope memoryCategoryScope_(category)
+
 /// %Allocator template class. Allocates objects of a specific class.
 template <class T> class Allocator
 {
@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/FlatHashBase.h"
+
+#include <cassert>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+void FlatHashBase::AllocateSlots(unsigned numSlots)
+{
+    assert(numSlots && !(numSlots & (numSlots - 1)));
+
+    FreeSlots();
+    slots_ = static_cast<FlatHashSlot*>(AllocateMemory(numSlots * sizeof(FlatHashSlot)));
+    numSlots_ = numSlots;
+    ResetSlots();
+}
+
+void FlatHashBase::GrowSlots(unsigned numSlots)
+{
+    assert(numSlots && !(numSlots & (numSlots - 1)));
+
+    FlatHashSlot* oldSlots = slots_;
+    unsigned oldNumSlots = numSlots_;
+
+    slots_ = static_cast<FlatHashSlot*>(AllocateMemory(numSlots * sizeof(FlatHashSlot)));
+    numSlots_ = numSlots;
+    ResetSlots();
+
+    for (unsigned i = 0; i < oldNumSlots; ++i)
+    {
+        if (oldSlots[i].index_ != FlatHashSlot::EMPTY)
+            InsertSlot(oldSlots[i].hash_, oldSlots[i].index_);
+    }
+
+    FreeMemory(oldSlots, oldNumSlots * sizeof(FlatHashSlot));
+}
+
+void FlatHashBase::FreeSlots()
+{
+    FreeMemory(slots_, numSlots_ * sizeof(FlatHashSlot));
+    slots_ = 0;
+    numSlots_ = 0;
+}
+
+void FlatHashBase::ResetSlots()
+{
+    for (unsigned i = 0; i < numSlots_; ++i)
+        slots_[i].index_ = FlatHashSlot::EMPTY;
+}
+
+void FlatHashBase::InsertSlot(unsigned hash, unsigned index)
+{
+    unsigned mask = numSlots_ - 1;
+    unsigned slot = HomeSlot(hash);
+    while (slots_[slot].index_ != FlatHashSlot::EMPTY)
+        slot = (slot + 1) & mask;
+
+    slots_[slot].hash_ = hash;
+    slots_[slot].index_ = index;
+}
+
+void FlatHashBase::EraseSlot(unsigned hash, unsigned index)
+{
+    unsigned mask = numSlots_ - 1;
+    unsigned hole = FindSlot(hash, index);
+
+    // Shift back following slots whose home position is not between the hole and their current position
+    unsigned slot = hole;
+    for (;;)
+    {
+        slot = (slot + 1) & mask;
+        if (slots_[slot].index_ == FlatHashSlot::EMPTY)
+            break;
+
+        unsigned home = HomeSlot(slots_[slot].hash_);
+        if (((slot - home) & mask) >= ((slot - hole) & mask))
+        {
+            slots_[hole] = slots_[slot];
+            hole = slot;
+        }
+    }
+
+    slots_[hole].index_ = FlatHashSlot::EMPTY;
+}
+
+void FlatHashBase::MoveSlot(unsigned hash, unsigned oldIndex, unsigned newIndex)
+{
+    slots_[FindSlot(hash, oldIndex)].index_ = newIndex;
+}
+
+unsigned FlatHashBase::FindSlot(unsigned hash, unsigned index) const
+{
+    unsigned mask = numSlots_ - 1;
+    unsigned slot = HomeSlot(hash);
+    while (slots_[slot].index_ != index)
+    {
+        assert(slots_[slot].index_ != FlatHashSlot::EMPTY);
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+}
@@ -0,0 +1,114 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include "../Container/Allocator.h"
+#include "../Container/Hash.h"
+#include "../Container/Swap.h"
+
+namespace Urho3D
+{
+
+/// Open addressing hash table slot.
+struct FlatHashSlot
+{
+    /// Full hash value of the element.
+    unsigned hash_;
+    /// Index of the element in the dense element array, or EMPTY.
+    unsigned index_;
+
+    /// Empty slot marker.
+    static const unsigned EMPTY = 0xffffffff;
+};
+
+/// Flat hash set/map base class. Manages an open addressing (linear probing) index table into a dense element array. The table size is a power of two and the load factor is kept below 3/4.
+/** Note that to prevent extra memory use due to vtable pointer, %FlatHashBase intentionally does not declare a virtual destructor
+    and therefore %FlatHashBase pointers should never be used.
+  */
+class URHO3D_API FlatHashBase
+{
+public:
+    /// Initial amount of slots.
+    static const unsigned MIN_SLOTS = 8;
+
+    /// Construct.
+    FlatHashBase() :
+        slots_(0),
+        numSlots_(0)
+    {
+    }
+
+    /// Return number of slots in the index table.
+    unsigned NumSlots() const { return numSlots_; }
+
+protected:
+    /// Swap the index table with another flat hash set or map.
+    void SwapSlots(FlatHashBase& rhs)
+    {
+        Urho3D::Swap(slots_, rhs.slots_);
+        Urho3D::Swap(numSlots_, rhs.numSlots_);
+    }
+
+    /// Return the home slot of a hash value. Scrambles the hash, as many hash functions (integers, pointers) do not distribute their low bits well.
+    unsigned HomeSlot(unsigned hash) const
+    {
+        unsigned mixed = hash * 2654435769u;
+        return (mixed ^ (mixed >> 16)) & (numSlots_ - 1);
+    }
+
+    /// Return whether the index table needs to grow to hold the given amount of elements.
+    bool NeedGrow(unsigned size) const { return size * 4 > numSlots_ * 3; }
+
+    /// Allocate an empty index table. The number of slots must be a power of two.
+    void AllocateSlots(unsigned numSlots);
+    /// Resize the index table, relinking the existing slots by their stored hash values. The number of slots must be a power of two.
+    void GrowSlots(unsigned numSlots);
+    /// Free the index table.
+    void FreeSlots();
+    /// Mark all slots empty.
+    void ResetSlots();
+    /// Link an element to the index table. The element must not already exist.
+    void InsertSlot(unsigned hash, unsigned index);
+    /// Remove the slot referring to an element index, shifting the following slots of the probe sequence back.
+    void EraseSlot(unsigned hash, unsigned index);
+    /// Change the element index of a slot, when the element has been moved in the dense array.
+    void MoveSlot(unsigned hash, unsigned oldIndex, unsigned newIndex);
+
+    /// Index table.
+    FlatHashSlot* slots_;
+    /// Number of slots, zero or a power of two.
+    unsigned numSlots_;
+
+private:
+    /// Return the slot referring to an element index.
+    unsigned FindSlot(unsigned hash, unsigned index) const;
+};
+
+}
@@ -0,0 +1,412 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Pair.h"
+#include "../Container/Sort.h"
+#include "../Container/Vector.h"
+
+#include <cassert>
+#include <cstring>
+#if URHO3D_CXX11
+#include <initializer_list>
+#endif
+
+namespace Urho3D
+{
+
+/// Open addressing hash map template class. Stores the key-value pairs in a dense array that can be iterated without pointer chasing, and an index table probed linearly. Insertion order is kept until elements are erased: erasing moves the last pair into the erased position. Inserting or erasing invalidates iterators and pointers to values.
+template <class T, class U> class FlatHashMap : public FlatHashBase
+{
+public:
+    typedef T KeyType;
+    typedef U ValueType;
+
+    /// Flat hash map key-value pair. The key must not be modified through iterators.
+    class KeyValue
+    {
+    public:
+        /// Construct with default key.
+        KeyValue() :
+            first_(T())
+        {
+        }
+
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+
+        /// Test for equality with another pair.
+        bool operator ==(const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+
+        /// Test for inequality with another pair.
+        bool operator !=(const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+
+        /// Key.
+        T first_;
+        /// Value.
+        U second_;
+    };
+
+    typedef typename Vector<KeyValue>::Iterator Iterator;
+    typedef typename Vector<KeyValue>::ConstIterator ConstIterator;
+
+    /// Construct empty.
+    FlatHashMap()
+    {
+    }
+
+    /// Construct from another flat hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map)
+    {
+        *this = map;
+    }
+#if URHO3D_CXX11
+    /// Aggregate initialization constructor.
+    FlatHashMap(const std::initializer_list<Pair<T, U>>& list)
+    {
+        for (auto it = list.begin(); it != list.end(); it++)
+        {
+            Insert(*it);
+        }
+    }
+#endif
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        FreeSlots();
+    }
+
+    /// Assign a flat hash map.
+    FlatHashMap& operator =(const FlatHashMap<T, U>& rhs)
+    {
+        if (&rhs != this)
+        {
+            pairs_ = rhs.pairs_;
+            if (rhs.numSlots_)
+            {
+                if (numSlots_ != rhs.numSlots_)
+                    AllocateSlots(rhs.numSlots_);
+                memcpy(slots_, rhs.slots_, numSlots_ * sizeof(FlatHashSlot));
+            }
+            else
+                FreeSlots();
+        }
+        return *this;
+    }
+
+    /// Add-assign a pair.
+    FlatHashMap& operator +=(const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a flat hash map.
+    FlatHashMap& operator +=(const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another flat hash map.
+    bool operator ==(const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another flat hash map.
+    bool operator !=(const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [](const T& key)
+    {
+        unsigned hash = MakeHash(key);
+        unsigned index = FindIndex(key, hash);
+        if (index == FlatHashSlot::EMPTY)
+            index = AddPair(key, U(), hash);
+        return pairs_[index].second_;
+    }
+
+    /// Index the map. Return null if key is not found, does not create a new pair.
+    U* operator [](const T& key) const
+    {
+        unsigned index = FindIndex(key, MakeHash(key));
+        return index != FlatHashSlot::EMPTY ? const_cast<U*>(&pairs_[index].second_) : 0;
+    }
+
+#if URHO3D_CXX11
+    /// Populate the map using variadic template. This handles the base case.
+    FlatHashMap& Populate(const T& key, const U& value)
+    {
+        this->operator [](key) = value;
+        return *this;
+    };
+    /// Populate the map using variadic template.
+    template <typename... Args> FlatHashMap& Populate(const T& key, const U& value, Args... args)
+    {
+        this->operator [](key) = value;
+        return Populate(args...);
+    };
+#endif
+
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        return Begin() + InsertPair(pair.first_, pair.second_);
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        for (ConstIterator it = map.Begin(); it != map.End(); ++it)
+            InsertPair(it->first_, it->second_);
+    }
+
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Begin() + InsertPair(it->first_, it->second_); }
+
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end)
+    {
+        for (ConstIterator it = start; it != end; ++it)
+            InsertPair(it->first_, it->second_);
+    }
+
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        if (!numSlots_)
+            return false;
+
+        unsigned hash = MakeHash(key);
+        unsigned index = FindIndex(key, hash);
+        if (index == FlatHashSlot::EMPTY)
+            return false;
+
+        ErasePair(hash, index);
+        return true;
+    }
+
+    /// Erase a pair by iterator. Return iterator to the next pair, which is at the same position as the last pair is moved into the erased one.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned index = (unsigned)(it - Begin());
+        if (index >= pairs_.Size())
+            return End();
+
+        ErasePair(MakeHash(it->first_), index);
+        return Begin() + index;
+    }
+
+    /// Clear the map. Keeps the allocated memory.
+    void Clear()
+    {
+        pairs_.Clear();
+        ResetSlots();
+    }
+
+    /// Sort pairs. After sorting the map can be iterated in order until elements are inserted or erased.
+    void Sort()
+    {
+        Urho3D::Sort(pairs_.Begin(), pairs_.End(), ComparePairs);
+        RebuildSlots();
+    }
+
+    /// Reserve space for a number of pairs without reallocating.
+    void Reserve(unsigned size)
+    {
+        pairs_.Reserve(size);
+        unsigned numSlots = numSlots_ ? numSlots_ : MIN_SLOTS;
+        while (size * 4 > numSlots * 3)
+            numSlots <<= 1;
+        if (numSlots != numSlots_)
+            GrowSlots(numSlots);
+    }
+
+    /// Swap with another flat hash map.
+    void Swap(FlatHashMap<T, U>& rhs)
+    {
+        pairs_.Swap(rhs.pairs_);
+        SwapSlots(rhs);
+    }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        unsigned index = FindIndex(key, MakeHash(key));
+        return index != FlatHashSlot::EMPTY ? Begin() + index : End();
+    }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        unsigned index = FindIndex(key, MakeHash(key));
+        return index != FlatHashSlot::EMPTY ? Begin() + index : End();
+    }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindIndex(key, MakeHash(key)) != FlatHashSlot::EMPTY; }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->second_);
+        return result;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return pairs_.Begin(); }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return pairs_.Begin(); }
+
+    /// Return iterator to the end.
+    Iterator End() { return pairs_.End(); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return pairs_.End(); }
+
+    /// Return first pair.
+    const KeyValue& Front() const { return pairs_.Front(); }
+
+    /// Return last pair.
+    const KeyValue& Back() const { return pairs_.Back(); }
+
+    /// Return number of pairs.
+    unsigned Size() const { return pairs_.Size(); }
+
+    /// Return whether has no pairs.
+    bool Empty() const { return pairs_.Empty(); }
+
+private:
+    /// Return index of the pair with key, or FlatHashSlot::EMPTY if not found.
+    unsigned FindIndex(const T& key, unsigned hash) const
+    {
+        if (!numSlots_)
+            return FlatHashSlot::EMPTY;
+
+        unsigned mask = numSlots_ - 1;
+        unsigned slot = HomeSlot(hash);
+        for (;;)
+        {
+            const FlatHashSlot& current = slots_[slot];
+            if (current.index_ == FlatHashSlot::EMPTY)
+                return FlatHashSlot::EMPTY;
+            if (current.hash_ == hash && pairs_[current.index_].first_ == key)
+                return current.index_;
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    /// Insert a key and value and return the index of either the new or existing pair. The value of an existing pair is overwritten.
+    unsigned InsertPair(const T& key, const U& value)
+    {
+        unsigned hash = MakeHash(key);
+        unsigned index = FindIndex(key, hash);
+        if (index != FlatHashSlot::EMPTY)
+        {
+            pairs_[index].second_ = value;
+            return index;
+        }
+
+        return AddPair(key, value, hash);
+    }
+
+    /// Add a pair that does not exist yet and return its index.
+    unsigned AddPair(const T& key, const U& value, unsigned hash)
+    {
+        // Grow the index table and element array together to limit element copying
+        unsigned index = pairs_.Size();
+        if (!numSlots_ || NeedGrow(index + 1))
+        {
+            GrowSlots(numSlots_ ? numSlots_ << 1 : MIN_SLOTS);
+            pairs_.Reserve(numSlots_ * 3 / 4);
+        }
+
+        pairs_.Push(KeyValue(key, value));
+        InsertSlot(hash, index);
+        return index;
+    }
+
+    /// Erase the pair at index by moving the last pair into its place.
+    void ErasePair(unsigned hash, unsigned index)
+    {
+        EraseSlot(hash, index);
+
+        unsigned last = pairs_.Size() - 1;
+        if (index != last)
+        {
+            MoveSlot(MakeHash(pairs_[last].first_), last, index);
+            pairs_[index] = pairs_[last];
+        }
+        pairs_.Pop();
+    }
+
+    /// Relink all pairs to the index table.
+    void RebuildSlots()
+    {
+        if (!numSlots_)
+            return;
+
+        ResetSlots();
+        for (unsigned i = 0; i < pairs_.Size(); ++i)
+            InsertSlot(MakeHash(pairs_[i].first_), i);
+    }
+
+    /// Compare two pairs by key.
+    static bool ComparePairs(const KeyValue& lhs, const KeyValue& rhs) { return lhs.first_ < rhs.first_; }
+
+    /// Key-value pairs.
+    Vector<KeyValue> pairs_;
+};
+
+}
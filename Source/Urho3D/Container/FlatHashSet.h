@@ -0,0 +1,305 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/FlatHashBase.h"
+#include "../Container/Sort.h"
+#include "../Container/Vector.h"
+
+#include <cassert>
+#include <cstring>
+#if URHO3D_CXX11
+#include <initializer_list>
+#endif
+
+namespace Urho3D
+{
+
+/// Open addressing hash set template class. Stores the keys in a dense array that can be iterated without pointer chasing, and an index table probed linearly. Insertion order is kept until keys are erased: erasing moves the last key into the erased position. Inserting or erasing invalidates iterators.
+template <class T> class FlatHashSet : public FlatHashBase
+{
+public:
+    typedef T KeyType;
+    typedef typename Vector<T>::ConstIterator Iterator;
+    typedef typename Vector<T>::ConstIterator ConstIterator;
+
+    /// Construct empty.
+    FlatHashSet()
+    {
+    }
+
+    /// Construct from another flat hash set.
+    FlatHashSet(const FlatHashSet<T>& set)
+    {
+        *this = set;
+    }
+#if URHO3D_CXX11
+    /// Aggregate initialization constructor.
+    FlatHashSet(const std::initializer_list<T>& list)
+    {
+        for (auto it = list.begin(); it != list.end(); it++)
+        {
+            Insert(*it);
+        }
+    }
+#endif
+    /// Destruct.
+    ~FlatHashSet()
+    {
+        FreeSlots();
+    }
+
+    /// Assign a flat hash set.
+    FlatHashSet& operator =(const FlatHashSet<T>& rhs)
+    {
+        if (&rhs != this)
+        {
+            keys_ = rhs.keys_;
+            if (rhs.numSlots_)
+            {
+                if (numSlots_ != rhs.numSlots_)
+                    AllocateSlots(rhs.numSlots_);
+                memcpy(slots_, rhs.slots_, numSlots_ * sizeof(FlatHashSlot));
+            }
+            else
+                FreeSlots();
+        }
+        return *this;
+    }
+
+    /// Add-assign a value.
+    FlatHashSet& operator +=(const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a flat hash set.
+    FlatHashSet& operator +=(const FlatHashSet<T>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another flat hash set.
+    bool operator ==(const FlatHashSet<T>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            if (!rhs.Contains(*i))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another flat hash set.
+    bool operator !=(const FlatHashSet<T>& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        unsigned hash = MakeHash(key);
+        unsigned index = FindIndex(key, hash);
+        if (index == FlatHashSlot::EMPTY)
+            index = AddKey(key, hash);
+        return Begin() + index;
+    }
+
+    /// Insert a key. Return an iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const T& key, bool& exists)
+    {
+        unsigned hash = MakeHash(key);
+        unsigned index = FindIndex(key, hash);
+        exists = index != FlatHashSlot::EMPTY;
+        if (!exists)
+            index = AddKey(key, hash);
+        return Begin() + index;
+    }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet<T>& set)
+    {
+        for (ConstIterator it = set.Begin(); it != set.End(); ++it)
+            Insert(*it);
+    }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        if (!numSlots_)
+            return false;
+
+        unsigned hash = MakeHash(key);
+        unsigned index = FindIndex(key, hash);
+        if (index == FlatHashSlot::EMPTY)
+            return false;
+
+        EraseKey(hash, index);
+        return true;
+    }
+
+    /// Erase a key by iterator. Return iterator to the next key, which is at the same position as the last key is moved into the erased one.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned index = (unsigned)(it - Begin());
+        if (index >= keys_.Size())
+            return End();
+
+        EraseKey(MakeHash(*it), index);
+        return Begin() + index;
+    }
+
+    /// Clear the set. Keeps the allocated memory.
+    void Clear()
+    {
+        keys_.Clear();
+        ResetSlots();
+    }
+
+    /// Sort keys. After sorting the set can be iterated in order until keys are inserted or erased.
+    void Sort()
+    {
+        Urho3D::Sort(keys_.Begin(), keys_.End());
+        RebuildSlots();
+    }
+
+    /// Reserve space for a number of keys without reallocating.
+    void Reserve(unsigned size)
+    {
+        keys_.Reserve(size);
+        unsigned numSlots = numSlots_ ? numSlots_ : MIN_SLOTS;
+        while (size * 4 > numSlots * 3)
+            numSlots <<= 1;
+        if (numSlots != numSlots_)
+            GrowSlots(numSlots);
+    }
+
+    /// Swap with another flat hash set.
+    void Swap(FlatHashSet<T>& rhs)
+    {
+        keys_.Swap(rhs.keys_);
+        SwapSlots(rhs);
+    }
+
+    /// Return iterator to the key, or end iterator if not found.
+    Iterator Find(const T& key) const
+    {
+        unsigned index = FindIndex(key, MakeHash(key));
+        return index != FlatHashSlot::EMPTY ? Begin() + index : End();
+    }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return FindIndex(key, MakeHash(key)) != FlatHashSlot::EMPTY; }
+
+    /// Return the keys as a vector.
+    const Vector<T>& Keys() const { return keys_; }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return keys_.Begin(); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return keys_.End(); }
+
+    /// Return first key.
+    const T& Front() const { return keys_.Front(); }
+
+    /// Return last key.
+    const T& Back() const { return keys_.Back(); }
+
+    /// Return number of keys.
+    unsigned Size() const { return keys_.Size(); }
+
+    /// Return whether has no keys.
+    bool Empty() const { return keys_.Empty(); }
+
+private:
+    /// Return index of the key, or FlatHashSlot::EMPTY if not found.
+    unsigned FindIndex(const T& key, unsigned hash) const
+    {
+        if (!numSlots_)
+            return FlatHashSlot::EMPTY;
+
+        unsigned mask = numSlots_ - 1;
+        unsigned slot = HomeSlot(hash);
+        for (;;)
+        {
+            const FlatHashSlot& current = slots_[slot];
+            if (current.index_ == FlatHashSlot::EMPTY)
+                return FlatHashSlot::EMPTY;
+            if (current.hash_ == hash && keys_[current.index_] == key)
+                return current.index_;
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    /// Add a key that does not exist yet and return its index.
+    unsigned AddKey(const T& key, unsigned hash)
+    {
+        // Grow the index table and element array together to limit element copying
+        unsigned index = keys_.Size();
+        if (!numSlots_ || NeedGrow(index + 1))
+        {
+            GrowSlots(numSlots_ ? numSlots_ << 1 : MIN_SLOTS);
+            keys_.Reserve(numSlots_ * 3 / 4);
+        }
+
+        keys_.Push(key);
+        InsertSlot(hash, index);
+        return index;
+    }
+
+    /// Erase the key at index by moving the last key into its place.
+    void EraseKey(unsigned hash, unsigned index)
+    {
+        EraseSlot(hash, index);
+
+        unsigned last = keys_.Size() - 1;
+        if (index != last)
+        {
+            MoveSlot(MakeHash(keys_[last]), last, index);
+            keys_[index] = keys_[last];
+        }
+        keys_.Pop();
+    }
+
+    /// Relink all keys to the index table.
+    void RebuildSlots()
+    {
+        if (!numSlots_)
+            return;
+
+        ResetSlots();
+        for (unsigned i = 0; i < keys_.Size(); ++i)
+            InsertSlot(MakeHash(keys_[i]), i);
+    }
+
+    /// Keys.
+    Vector<T> keys_;
+};
+
+}
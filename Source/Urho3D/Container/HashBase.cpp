@@ -29,10 +29,9 @@ namespace Urho3D
 
 void HashBase::AllocateBuckets(unsigned size, unsigned numBuckets)
 {
-    if (ptrs_)
-        delete[] ptrs_;
+    FreeBuckets();
 
-    HashNodeBase** ptrs = new HashNodeBase* [numBuckets + 2];
+    HashNodeBase** ptrs = static_cast<HashNodeBase**>(AllocateMemory((unsigned)((numBuckets + 2) * sizeof(HashNodeBase*))));
     unsigned* data = reinterpret_cast<unsigned*>(ptrs);
     data[0] = size;
     data[1] = numBuckets;
@@ -41,6 +40,15 @@ void HashBase::AllocateBuckets(unsigned size, unsigned numBuckets)
     ResetPtrs();
 }
 
+void HashBase::FreeBuckets()
+{
+    if (!ptrs_)
+        return;
+
+    FreeMemory(ptrs_, (unsigned)((NumBuckets() + 2) * sizeof(HashNodeBase*)));
+    ptrs_ = 0;
+}
+
 void HashBase::ResetPtrs()
 {
     // Reset bucket pointers
@@ -133,6 +133,8 @@ public:
 protected:
     /// Allocate bucket head pointers + room for size and bucket count variables.
     void AllocateBuckets(unsigned size, unsigned numBuckets);
+    /// Free the bucket pointers.
+    void FreeBuckets();
 
     /// Reset bucket head pointers.
     void ResetPtrs();
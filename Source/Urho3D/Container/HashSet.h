@@ -211,7 +211,7 @@ public:
         Clear();
         FreeNode(Tail());
         AllocatorUninitialize(allocator_);
-        delete[] ptrs_;
+        FreeBuckets();
     }
 
     /// Assign a hash set.
@@ -0,0 +1,275 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Vector.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Paged table of object pointers indexed by ID, for IDs allocated mostly sequentially from a base ID. Lookup, insertion and erasure are constant time array accesses through a three-level page table; pages are allocated on demand and freed when they become empty, so that sparse IDs cost only the pages they touch.
+template <class T> class IDTable
+{
+public:
+    /// Bits of the ID offset within a page.
+    static const unsigned PAGE_BITS = 9;
+    /// Bits of the page index within a directory.
+    static const unsigned DIRECTORY_BITS = 9;
+    /// Number of entries in a page.
+    static const unsigned PAGE_SIZE = 1 << PAGE_BITS;
+    /// Number of pages in a directory.
+    static const unsigned DIRECTORY_SIZE = 1 << DIRECTORY_BITS;
+
+    /// Iterator over the non-null entries in ID order. Inserting or erasing invalidates iterators.
+    class ConstIterator
+    {
+    public:
+        /// Construct.
+        ConstIterator(const IDTable<T>* table, unsigned offset) :
+            table_(table),
+            offset_(offset)
+        {
+        }
+
+        /// Return the object.
+        T* operator *() const { return table_->FindOffset(offset_); }
+        /// Point to the object.
+        T* operator ->() const { return table_->FindOffset(offset_); }
+        /// Test for equality with another iterator.
+        bool operator ==(const ConstIterator& rhs) const { return offset_ == rhs.offset_; }
+        /// Test for inequality with another iterator.
+        bool operator !=(const ConstIterator& rhs) const { return offset_ != rhs.offset_; }
+
+        /// Preincrement to the next non-null entry.
+        ConstIterator& operator ++()
+        {
+            offset_ = table_->NextOffset(offset_ + 1);
+            return *this;
+        }
+
+        /// Return the ID of the object.
+        unsigned GetID() const { return table_->firstID_ + offset_; }
+
+    private:
+        /// Table.
+        const IDTable<T>* table_;
+        /// Offset of the current entry from the first ID.
+        unsigned offset_;
+    };
+
+    /// Construct empty with the first ID of the range.
+    IDTable(unsigned firstID) :
+        firstID_(firstID),
+        size_(0)
+    {
+    }
+
+    /// Destruct.
+    ~IDTable()
+    {
+        Clear();
+    }
+
+    /// Return the object with the ID, or null if not found.
+    T* Find(unsigned id) const { return id >= firstID_ ? FindOffset(id - firstID_) : 0; }
+
+    /// Return whether an object with the ID exists.
+    bool Contains(unsigned id) const { return Find(id) != 0; }
+
+    /// Insert an object, replacing any existing object with the same ID. The ID must not be below the first ID of the range.
+    void Insert(unsigned id, T* object)
+    {
+        assert(id >= firstID_ && object);
+        unsigned offset = id - firstID_;
+        unsigned dirIndex = offset >> (PAGE_BITS + DIRECTORY_BITS);
+        if (dirIndex >= directories_.Size())
+        {
+            unsigned oldSize = directories_.Size();
+            directories_.Resize(dirIndex + 1);
+            for (unsigned i = oldSize; i <= dirIndex; ++i)
+                directories_[i] = 0;
+        }
+
+        Directory*& dir = directories_[dirIndex];
+        if (!dir)
+        {
+            dir = new Directory();
+            memset(dir, 0, sizeof(Directory));
+        }
+        Page*& page = dir->pages_[(offset >> PAGE_BITS) & (DIRECTORY_SIZE - 1)];
+        if (!page)
+        {
+            page = new Page();
+            memset(page, 0, sizeof(Page));
+            ++dir->count_;
+        }
+
+        T*& entry = page->entries_[offset & (PAGE_SIZE - 1)];
+        if (!entry)
+        {
+            ++page->count_;
+            ++size_;
+        }
+        entry = object;
+    }
+
+    /// Erase an object by ID. Return true if was found.
+    bool Erase(unsigned id)
+    {
+        if (id < firstID_)
+            return false;
+        unsigned offset = id - firstID_;
+        unsigned dirIndex = offset >> (PAGE_BITS + DIRECTORY_BITS);
+        if (dirIndex >= directories_.Size() || !directories_[dirIndex])
+            return false;
+
+        Directory*& dir = directories_[dirIndex];
+        Page*& page = dir->pages_[(offset >> PAGE_BITS) & (DIRECTORY_SIZE - 1)];
+        if (!page)
+            return false;
+        T*& entry = page->entries_[offset & (PAGE_SIZE - 1)];
+        if (!entry)
+            return false;
+
+        entry = 0;
+        --size_;
+        // Free the page and directory when they become empty
+        if (!--page->count_)
+        {
+            delete page;
+            page = 0;
+            if (!--dir->count_)
+            {
+                delete dir;
+                dir = 0;
+            }
+        }
+        return true;
+    }
+
+    /// Erase all objects and free the pages.
+    void Clear()
+    {
+        for (unsigned i = 0; i < directories_.Size(); ++i)
+        {
+            Directory* dir = directories_[i];
+            if (!dir)
+                continue;
+            for (unsigned j = 0; j < DIRECTORY_SIZE; ++j)
+                delete dir->pages_[j];
+            delete dir;
+        }
+        directories_.Clear();
+        size_ = 0;
+    }
+
+    /// Return iterator to the object with the lowest ID.
+    ConstIterator Begin() const { return ConstIterator(this, NextOffset(0)); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(this, EndOffset()); }
+
+    /// Return number of objects.
+    unsigned Size() const { return size_; }
+
+    /// Return whether the table is empty.
+    bool Empty() const { return size_ == 0; }
+
+private:
+    /// Page of entries.
+    struct Page
+    {
+        /// Entries.
+        T* entries_[PAGE_SIZE];
+        /// Number of non-null entries.
+        unsigned count_;
+    };
+
+    /// Directory of pages.
+    struct Directory
+    {
+        /// Pages.
+        Page* pages_[DIRECTORY_SIZE];
+        /// Number of allocated pages.
+        unsigned count_;
+    };
+
+    /// Prevent copy construction.
+    IDTable(const IDTable<T>& rhs);
+    /// Prevent assignment.
+    IDTable<T>& operator =(const IDTable<T>& rhs);
+
+    /// Return the object at an offset from the first ID, or null if not found.
+    T* FindOffset(unsigned offset) const
+    {
+        unsigned dirIndex = offset >> (PAGE_BITS + DIRECTORY_BITS);
+        if (dirIndex >= directories_.Size())
+            return 0;
+        Directory* dir = directories_[dirIndex];
+        if (!dir)
+            return 0;
+        Page* page = dir->pages_[(offset >> PAGE_BITS) & (DIRECTORY_SIZE - 1)];
+        return page ? page->entries_[offset & (PAGE_SIZE - 1)] : 0;
+    }
+
+    /// Return the offset of the first non-null entry at or after an offset, or the end offset if none.
+    unsigned NextOffset(unsigned offset) const
+    {
+        unsigned endOffset = EndOffset();
+        while (offset < endOffset)
+        {
+            Directory* dir = directories_[offset >> (PAGE_BITS + DIRECTORY_BITS)];
+            if (!dir)
+            {
+                offset = ((offset >> (PAGE_BITS + DIRECTORY_BITS)) + 1) << (PAGE_BITS + DIRECTORY_BITS);
+                continue;
+            }
+            Page* page = dir->pages_[(offset >> PAGE_BITS) & (DIRECTORY_SIZE - 1)];
+            if (!page)
+            {
+                offset = ((offset >> PAGE_BITS) + 1) << PAGE_BITS;
+                continue;
+            }
+            if (page->entries_[offset & (PAGE_SIZE - 1)])
+                return offset;
+            ++offset;
+        }
+        return endOffset;
+    }
+
+    /// Return the offset past the last directory.
+    unsigned EndOffset() const { return directories_.Size() << (PAGE_BITS + DIRECTORY_BITS); }
+
+    /// Directories of pages, indexed by the high bits of the ID offset.
+    PODVector<Directory*> directories_;
+    /// First ID of the range.
+    unsigned firstID_;
+    /// Number of objects.
+    unsigned size_;
+};
+
+}
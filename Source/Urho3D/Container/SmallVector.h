@@ -0,0 +1,382 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Allocator.h"
+#include "../Container/VectorBase.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// %Vector template class for POD types with space for N elements inside the object. Only allocates dynamic memory when grown past N elements. Unlike PODVector the object itself may not be moved with memcpy.
+template <class T, unsigned N> class SmallVector
+{
+public:
+    typedef RandomAccessIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+
+    /// Construct empty.
+    SmallVector() :
+        buffer_(inline_),
+        size_(0),
+        capacity_(N)
+    {
+    }
+
+    /// Construct with initial size.
+    explicit SmallVector(unsigned size) :
+        buffer_(inline_),
+        size_(0),
+        capacity_(N)
+    {
+        Resize(size);
+    }
+
+    /// Construct with initial data.
+    SmallVector(const T* data, unsigned size) :
+        buffer_(inline_),
+        size_(0),
+        capacity_(N)
+    {
+        Resize(size);
+        CopyElements(buffer_, data, size);
+    }
+
+    /// Construct from another vector.
+    SmallVector(const SmallVector<T, N>& vector) :
+        buffer_(inline_),
+        size_(0),
+        capacity_(N)
+    {
+        *this = vector;
+    }
+
+    /// Destruct.
+    ~SmallVector()
+    {
+        if (buffer_ != inline_)
+            FreeMemory(buffer_, (unsigned)(capacity_ * sizeof(T)));
+    }
+
+    /// Assign from another vector.
+    SmallVector<T, N>& operator =(const SmallVector<T, N>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Resize(rhs.size_);
+            CopyElements(buffer_, rhs.buffer_, rhs.size_);
+        }
+        return *this;
+    }
+
+    /// Add-assign an element.
+    SmallVector<T, N>& operator +=(const T& rhs)
+    {
+        Push(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another vector.
+    bool operator ==(const SmallVector<T, N>& rhs) const
+    {
+        if (rhs.size_ != size_)
+            return false;
+
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            if (buffer_[i] != rhs.buffer_[i])
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another vector.
+    bool operator !=(const SmallVector<T, N>& rhs) const { return !(*this == rhs); }
+
+    /// Return element at index.
+    T& operator [](unsigned index)
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return const element at index.
+    const T& operator [](unsigned index) const
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return element at index.
+    T& At(unsigned index)
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return const element at index.
+    const T& At(unsigned index) const
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Add an element at the end.
+    void Push(const T& value)
+    {
+        if (size_ == capacity_)
+            Reserve(capacity_ + ((capacity_ + 1) >> 1));
+        buffer_[size_++] = value;
+    }
+
+    /// Remove the last element.
+    void Pop()
+    {
+        if (size_)
+            --size_;
+    }
+
+    /// Insert an element at position.
+    void Insert(unsigned pos, const T& value)
+    {
+        if (pos > size_)
+            pos = size_;
+
+        unsigned oldSize = size_;
+        Resize(size_ + 1);
+        MoveRange(pos + 1, pos, oldSize - pos);
+        buffer_[pos] = value;
+    }
+
+    /// Insert an element by iterator.
+    Iterator Insert(const Iterator& dest, const T& value)
+    {
+        unsigned pos = (unsigned)(dest - Begin());
+        Insert(pos, value);
+
+        return Begin() + pos;
+    }
+
+    /// Insert a vector partially by iterators.
+    Iterator Insert(const Iterator& dest, const ConstIterator& start, const ConstIterator& end)
+    {
+        return Insert(dest, start.ptr_, end.ptr_);
+    }
+
+    /// Insert elements.
+    Iterator Insert(const Iterator& dest, const T* start, const T* end)
+    {
+        unsigned pos = (unsigned)(dest - Begin());
+        if (pos > size_)
+            pos = size_;
+        unsigned length = (unsigned)(end - start);
+        Resize(size_ + length);
+        MoveRange(pos + length, pos, size_ - pos - length);
+        CopyElements(buffer_ + pos, start, length);
+
+        return Begin() + pos;
+    }
+
+    /// Erase a range of elements.
+    void Erase(unsigned pos, unsigned length = 1)
+    {
+        // Return if the range is illegal
+        if (!length || pos + length > size_)
+            return;
+
+        MoveRange(pos, pos + length, size_ - pos - length);
+        size_ -= length;
+    }
+
+    /// Erase an element by iterator. Return iterator to the next element.
+    Iterator Erase(const Iterator& it)
+    {
+        unsigned pos = (unsigned)(it - Begin());
+        if (pos >= size_)
+            return End();
+        Erase(pos);
+
+        return Begin() + pos;
+    }
+
+    /// Erase an element if found.
+    bool Remove(const T& value)
+    {
+        Iterator i = Find(value);
+        if (i != End())
+        {
+            Erase(i);
+            return true;
+        }
+        else
+            return false;
+    }
+
+    /// Clear the vector. Keeps the capacity.
+    void Clear() { size_ = 0; }
+
+    /// Resize the vector.
+    void Resize(unsigned newSize)
+    {
+        if (newSize > capacity_)
+        {
+            unsigned newCapacity = capacity_;
+            while (newCapacity < newSize)
+                newCapacity += (newCapacity + 1) >> 1;
+            Reserve(newCapacity);
+        }
+
+        size_ = newSize;
+    }
+
+    /// Set new capacity. Returns to the inline storage if the elements fit there.
+    void Reserve(unsigned newCapacity)
+    {
+        if (newCapacity < size_)
+            newCapacity = size_;
+        if (newCapacity < N)
+            newCapacity = N;
+        if (newCapacity == capacity_)
+            return;
+
+        T* newBuffer = newCapacity > N ? static_cast<T*>(AllocateMemory((unsigned)(newCapacity * sizeof(T)))) : inline_;
+        CopyElements(newBuffer, buffer_, size_);
+        if (buffer_ != inline_)
+            FreeMemory(buffer_, (unsigned)(capacity_ * sizeof(T)));
+        buffer_ = newBuffer;
+        capacity_ = newCapacity;
+    }
+
+    /// Reallocate so that no extra memory is used.
+    void Compact() { Reserve(size_); }
+
+    /// Return iterator to value, or to the end if not found.
+    Iterator Find(const T& value)
+    {
+        Iterator it = Begin();
+        while (it != End() && *it != value)
+            ++it;
+        return it;
+    }
+
+    /// Return const iterator to value, or to the end if not found.
+    ConstIterator Find(const T& value) const
+    {
+        ConstIterator it = Begin();
+        while (it != End() && *it != value)
+            ++it;
+        return it;
+    }
+
+    /// Return whether contains a specific value.
+    bool Contains(const T& value) const { return Find(value) != End(); }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(buffer_); }
+
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(buffer_); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(buffer_ + size_); }
+
+    /// Return const iterator to the end.
+    ConstIterator End() const { return ConstIterator(buffer_ + size_); }
+
+    /// Return first element.
+    T& Front() { return buffer_[0]; }
+
+    /// Return const first element.
+    const T& Front() const { return buffer_[0]; }
+
+    /// Return last element.
+    T& Back()
+    {
+        assert(size_);
+        return buffer_[size_ - 1];
+    }
+
+    /// Return const last element.
+    const T& Back() const
+    {
+        assert(size_);
+        return buffer_[size_ - 1];
+    }
+
+    /// Return the element buffer.
+    T* Buffer() { return buffer_; }
+
+    /// Return the const element buffer.
+    const T* Buffer() const { return buffer_; }
+
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+
+    /// Return capacity of vector.
+    unsigned Capacity() const { return capacity_; }
+
+    /// Return whether vector is empty.
+    bool Empty() const { return size_ == 0; }
+
+    /// Return whether the elements are stored inline without dynamic allocation.
+    bool IsInline() const { return buffer_ == inline_; }
+
+private:
+    /// Move a range of elements within the vector.
+    void MoveRange(unsigned dest, unsigned src, unsigned count)
+    {
+        if (count)
+            memmove(buffer_ + dest, buffer_ + src, count * sizeof(T));
+    }
+
+    /// Copy elements from one buffer to another.
+    static void CopyElements(T* dest, const T* src, unsigned count)
+    {
+        if (count)
+            memcpy(dest, src, count * sizeof(T));
+    }
+
+    /// Element buffer, points to the inline storage until grown past it.
+    T* buffer_;
+    /// Number of elements.
+    unsigned size_;
+    /// Capacity, N while using the inline storage.
+    unsigned capacity_;
+    /// Inline storage.
+    T inline_[N];
+};
+
+template <class T, unsigned N> typename Urho3D::SmallVector<T, N>::ConstIterator begin(const Urho3D::SmallVector<T, N>& v) { return v.Begin(); }
+
+template <class T, unsigned N> typename Urho3D::SmallVector<T, N>::ConstIterator end(const Urho3D::SmallVector<T, N>& v) { return v.End(); }
+
+template <class T, unsigned N> typename Urho3D::SmallVector<T, N>::Iterator begin(Urho3D::SmallVector<T, N>& v) { return v.Begin(); }
+
+template <class T, unsigned N> typename Urho3D::SmallVector<T, N>::Iterator end(Urho3D::SmallVector<T, N>& v) { return v.End(); }
+
+}
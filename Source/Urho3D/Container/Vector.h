@@ -83,7 +83,7 @@ public:
     ~Vector()
     {
         Clear();
-        delete[] buffer_;
+        FreeBuffer(buffer_, (unsigned)(capacity_ * sizeof(T)));
     }
 
     /// Assign from another vector.
@@ -351,19 +351,19 @@ public:
         if (newCapacity != capacity_)
         {
             T* newBuffer = 0;
-            capacity_ = newCapacity;
 
-            if (capacity_)
+            if (newCapacity)
             {
-                newBuffer = reinterpret_cast<T*>(AllocateBuffer((unsigned)(capacity_ * sizeof(T))));
+                newBuffer = reinterpret_cast<T*>(AllocateBuffer((unsigned)(newCapacity * sizeof(T))));
                 // Move the data into the new buffer
                 ConstructElements(newBuffer, Buffer(), size_);
             }
 
             // Delete the old buffer
             DestructElements(Buffer(), size_);
-            delete[] buffer_;
+            FreeBuffer(buffer_, (unsigned)(capacity_ * sizeof(T)));
             buffer_ = reinterpret_cast<unsigned char*>(newBuffer);
+            capacity_ = newCapacity;
         }
     }
 
@@ -455,22 +455,24 @@ private:
             // Allocate new buffer if necessary and copy the current elements
             if (newSize > capacity_)
             {
-                if (!capacity_)
-                    capacity_ = newSize;
+                unsigned newCapacity = capacity_;
+                if (!newCapacity)
+                    newCapacity = newSize;
                 else
                 {
-                    while (capacity_ < newSize)
-                        capacity_ += (capacity_ + 1) >> 1;
+                    while (newCapacity < newSize)
+                        newCapacity += (newCapacity + 1) >> 1;
                 }
 
-                unsigned char* newBuffer = AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
+                unsigned char* newBuffer = AllocateBuffer((unsigned)(newCapacity * sizeof(T)));
                 if (buffer_)
                 {
                     ConstructElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
                     DestructElements(Buffer(), size_);
-                    delete[] buffer_;
+                    FreeBuffer(buffer_, (unsigned)(capacity_ * sizeof(T)));
                 }
                 buffer_ = newBuffer;
+                capacity_ = newCapacity;
             }
 
             // Initialize the new elements
@@ -564,7 +566,7 @@ public:
     /// Destruct.
     ~PODVector()
     {
-        delete[] buffer_;
+        FreeBuffer(buffer_, (unsigned)(capacity_ * sizeof(T)));
     }
 
     /// Assign from another vector.
@@ -824,22 +826,24 @@ public:
     {
         if (newSize > capacity_)
         {
-            if (!capacity_)
-                capacity_ = newSize;
+            unsigned newCapacity = capacity_;
+            if (!newCapacity)
+                newCapacity = newSize;
             else
             {
-                while (capacity_ < newSize)
-                    capacity_ += (capacity_ + 1) >> 1;
+                while (newCapacity < newSize)
+                    newCapacity += (newCapacity + 1) >> 1;
             }
 
-            unsigned char* newBuffer = AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
+            unsigned char* newBuffer = AllocateBuffer((unsigned)(newCapacity * sizeof(T)));
             // Move the data into the new buffer and delete the old
             if (buffer_)
             {
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
-                delete[] buffer_;
+                FreeBuffer(buffer_, (unsigned)(capacity_ * sizeof(T)));
             }
             buffer_ = newBuffer;
+            capacity_ = newCapacity;
         }
 
         size_ = newSize;
@@ -854,18 +858,18 @@ public:
         if (newCapacity != capacity_)
         {
             unsigned char* newBuffer = 0;
-            capacity_ = newCapacity;
 
-            if (capacity_)
+            if (newCapacity)
             {
-                newBuffer = AllocateBuffer((unsigned)(capacity_ * sizeof(T)));
+                newBuffer = AllocateBuffer((unsigned)(newCapacity * sizeof(T)));
                 // Move the data into the new buffer
                 CopyElements(reinterpret_cast<T*>(newBuffer), Buffer(), size_);
             }
 
             // Delete the old buffer
-            delete[] buffer_;
+            FreeBuffer(buffer_, (unsigned)(capacity_ * sizeof(T)));
             buffer_ = newBuffer;
+            capacity_ = newCapacity;
         }
     }
 
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Allocator.h"
 #include "../Container/VectorBase.h"
 
 #include "../DebugNew.h"
@@ -31,7 +32,12 @@ namespace Urho3D
 
 unsigned char* VectorBase::AllocateBuffer(unsigned size)
 {
-    return new unsigned char[size];
+    return static_cast<unsigned char*>(AllocateMemory(size));
+}
+
+void VectorBase::FreeBuffer(unsigned char* buffer, unsigned size)
+{
+    FreeMemory(buffer, size);
 }
 
 }
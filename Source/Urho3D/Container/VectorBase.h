@@ -262,7 +262,10 @@ public:
     }
 
 protected:
+    /// Allocate a buffer.
     static unsigned char* AllocateBuffer(unsigned size);
+    /// Free a buffer. The size must be the same as when allocated.
+    static void FreeBuffer(unsigned char* buffer, unsigned size);
 
     /// Size of vector.
     unsigned size_;
@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Urho3D
+{
+
+/// Issue a full memory barrier.
+inline void AtomicFence()
+{
+#ifdef _MSC_VER
+    // Interlocked operations act as full barriers
+    long barrier = 0;
+    _InterlockedExchange(&barrier, 1);
+#else
+    __sync_synchronize();
+#endif
+}
+
+/// Load an integer with acquire semantics.
+inline int AtomicLoad(const volatile int& value)
+{
+#ifdef _MSC_VER
+    // MSVC gives volatile accesses acquire / release semantics
+    return value;
+#else
+    return __atomic_load_n(&value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Store an integer with release semantics.
+inline void AtomicStore(volatile int& value, int newValue)
+{
+#ifdef _MSC_VER
+    value = newValue;
+#else
+    __atomic_store_n(&value, newValue, __ATOMIC_RELEASE);
+#endif
+}
+
+/// Load a pointer with acquire semantics.
+template <class T> inline T* AtomicLoadPtr(T* const volatile& ptr)
+{
+#ifdef _MSC_VER
+    return ptr;
+#else
+    return __atomic_load_n(&ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/// Store a pointer with release semantics.
+template <class T> inline void AtomicStorePtr(T* volatile& ptr, T* newPtr)
+{
+#ifdef _MSC_VER
+    ptr = newPtr;
+#else
+    __atomic_store_n(&ptr, newPtr, __ATOMIC_RELEASE);
+#endif
+}
+
+/// Exchange a pointer and return the previous value. Full barrier.
+template <class T> inline T* AtomicExchangePtr(T* volatile& ptr, T* newPtr)
+{
+#ifdef _MSC_VER
+    return (T*)_InterlockedExchangePointer((void* volatile*)&ptr, newPtr);
+#else
+    return __sync_lock_test_and_set(&ptr, newPtr);
+#endif
+}
+
+/// Compare a pointer to the expected value and replace with the new value if equal. Return true if the exchange happened. Full barrier.
+template <class T> inline bool AtomicCompareExchangePtr(T* volatile& ptr, T* expected, T* newPtr)
+{
+#ifdef _MSC_VER
+    return _InterlockedCompareExchangePointer((void* volatile*)&ptr, newPtr, expected) == expected;
+#else
+    return __sync_bool_compare_and_swap(&ptr, expected, newPtr);
+#endif
+}
+
+/// Compare an integer to the expected value and replace with the new value if equal. Return true if the exchange happened. Full barrier.
+inline bool AtomicCompareExchange(volatile int& value, int expected, int newValue)
+{
+#ifdef _MSC_VER
+    return _InterlockedCompareExchange((volatile long*)&value, (long)newValue, (long)expected) == (long)expected;
+#else
+    return __sync_bool_compare_and_swap(&value, expected, newValue);
+#endif
+}
+
+/// Add to an integer and return the new value. Full barrier.
+inline int AtomicAdd(volatile int& value, int delta)
+{
+#ifdef _MSC_VER
+    return (int)_InterlockedExchangeAdd((volatile long*)&value, (long)delta) + delta;
+#else
+    return __sync_add_and_fetch(&value, delta);
+#endif
+}
+
+}
@@ -82,6 +82,9 @@ Context::~Context()
     for (PODVector<VariantMap*>::Iterator i = eventDataMaps_.Begin(); i != eventDataMaps_.End(); ++i)
         delete *i;
     eventDataMaps_.Clear();
+    for (PODVector<VariantMap*>::Iterator i = typedEventDataMaps_.Begin(); i != typedEventDataMaps_.End(); ++i)
+        delete *i;
+    typedEventDataMaps_.Clear();
 }
 
 SharedPtr<Object> Context::CreateObject(StringHash objectType)
@@ -136,7 +139,14 @@ void Context::RegisterAttribute(StringHash objectType, const AttributeInfo& attr
         return;
     }
 
-    attributes_[objectType].Push(attr);
+    Vector<AttributeInfo>& infos = attributes_[objectType];
+    infos.Push(attr);
+
+    // If names collide, the first attribute is found, as in a linear search
+    HashMap<StringHash, unsigned>& indices = attributeIndices_[objectType];
+    StringHash nameHash(attr.name_);
+    if (!indices.Contains(nameHash))
+        indices[nameHash] = infos.Size() - 1;
 
     if (attr.mode_ & AM_NET)
         networkAttributes_[objectType].Push(attr);
@@ -146,6 +156,7 @@ void Context::RemoveAttribute(StringHash objectType, const char* name)
 {
     RemoveNamedAttribute(attributes_, objectType, name);
     RemoveNamedAttribute(networkAttributes_, objectType, name);
+    UpdateAttributeIndices(objectType);
 }
 
 void Context::UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue)
@@ -157,7 +168,11 @@ void Context::UpdateAttributeDefaultValue(StringHash objectType, const char* nam
 
 VariantMap& Context::GetEventDataMap()
 {
-    unsigned nestingLevel = eventSenders_.Size();
+    return GetEventDataMap(eventSenders_.Size());
+}
+
+VariantMap& Context::GetEventDataMap(unsigned nestingLevel)
+{
     while (eventDataMaps_.Size() < nestingLevel + 1)
         eventDataMaps_.Push(new VariantMap());
 
@@ -166,6 +181,20 @@ VariantMap& Context::GetEventDataMap()
     return ret;
 }
 
+VariantMap& Context::GetTypedEventDataMap(unsigned nestingLevel)
+{
+    while (typedEventDataMaps_.Size() < nestingLevel + 1)
+        typedEventDataMaps_.Push(new VariantMap());
+
+    VariantMap& ret = *typedEventDataMaps_[nestingLevel];
+    ret.Clear();
+    return ret;
+}
+
+void Context::SendPostedEvents()
+{
+    eventQueue_.SendEvents();
+}
 
 void Context::CopyBaseAttributes(StringHash baseType, StringHash derivedType)
 {
@@ -186,6 +215,8 @@ void Context::CopyBaseAttributes(StringHash baseType, StringHash derivedType)
             if (attr.mode_ & AM_NET)
                 networkAttributes_[derivedType].Push(attr);
         }
+
+        UpdateAttributeIndices(derivedType);
     }
 }
 
@@ -232,6 +263,13 @@ AttributeInfo* Context::GetAttribute(StringHash objectType, const char* name)
 
     Vector<AttributeInfo>& infos = i->second_;
 
+    unsigned index = GetAttributeIndex(objectType, StringHash(name));
+    if (index == M_MAX_UNSIGNED)
+        return 0;
+    if (!infos[index].name_.Compare(name, true))
+        return &infos[index];
+
+    // Matched only by case-insensitive hash, search for the exact name
     for (Vector<AttributeInfo>::Iterator j = infos.Begin(); j != infos.End(); ++j)
     {
         if (!j->name_.Compare(name, true))
@@ -241,6 +279,35 @@ AttributeInfo* Context::GetAttribute(StringHash objectType, const char* name)
     return 0;
 }
 
+unsigned Context::GetAttributeIndex(StringHash objectType, StringHash name) const
+{
+    HashMap<StringHash, HashMap<StringHash, unsigned> >::ConstIterator i = attributeIndices_.Find(objectType);
+    if (i == attributeIndices_.End())
+        return M_MAX_UNSIGNED;
+
+    HashMap<StringHash, unsigned>::ConstIterator j = i->second_.Find(name);
+    return j != i->second_.End() ? j->second_ : M_MAX_UNSIGNED;
+}
+
+void Context::UpdateAttributeIndices(StringHash objectType)
+{
+    HashMap<StringHash, Vector<AttributeInfo> >::ConstIterator i = attributes_.Find(objectType);
+    if (i == attributes_.End())
+    {
+        attributeIndices_.Erase(objectType);
+        return;
+    }
+
+    HashMap<StringHash, unsigned>& indices = attributeIndices_[objectType];
+    indices.Clear();
+    for (unsigned j = 0; j < i->second_.Size(); ++j)
+    {
+        StringHash nameHash(i->second_[j].name_);
+        if (!indices.Contains(nameHash))
+            indices[nameHash] = j;
+    }
+}
+
 void Context::AddEventReceiver(Object* receiver, StringHash eventType)
 {
     eventReceivers_[eventType].Insert(receiver);
@@ -253,6 +320,8 @@ void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash even
 
 void Context::RemoveEventSender(Object* sender)
 {
+    eventQueue_.RemoveSender(sender);
+
     HashMap<Object*, HashMap<StringHash, HashSet<Object*> > >::Iterator i = specificEventReceivers_.Find(sender);
     if (i != specificEventReceivers_.End())
     {
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Core/Attribute.h"
+#include "../Core/EventQueue.h"
 #include "../Core/Object.h"
 #include "../Container/HashSet.h"
 
@@ -63,6 +64,8 @@ public:
     void UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
+    /// Send events posted from any thread. Called by the engine at the start of each frame. Call only from the main thread.
+    void SendPostedEvents();
 
     /// Copy base class attributes to derived class.
     void CopyBaseAttributes(StringHash baseType, StringHash derivedType);
@@ -112,6 +115,8 @@ public:
     const String& GetTypeName(StringHash objectType) const;
     /// Return a specific attribute description for an object, or null if not found.
     AttributeInfo* GetAttribute(StringHash objectType, const char* name);
+    /// Return the index of an attribute description by name hash, or M_MAX_UNSIGNED if not found. As name hashes are case-insensitive, the name should be compared after a match.
+    unsigned GetAttributeIndex(StringHash objectType, StringHash name) const;
     /// Template version of returning a subsystem.
     template <class T> T* GetSubsystem() const;
     /// Template version of returning a specific attribute description.
@@ -166,6 +171,12 @@ private:
     /// Remove event receiver from non-specific events.
     void RemoveEventReceiver(Object* receiver, StringHash eventType);
 
+    /// Rebuild the attribute name hash index of an object type.
+    void UpdateAttributeIndices(StringHash objectType);
+    /// Return a preallocated map for event data at a specific event nesting level.
+    VariantMap& GetEventDataMap(unsigned nestingLevel);
+    /// Return a preallocated map for converting typed event data at a specific event nesting level. Separate from the maps returned by GetEventDataMap(), which the sender may still be filling.
+    VariantMap& GetTypedEventDataMap(unsigned nestingLevel);
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
 
@@ -183,6 +194,8 @@ private:
     HashMap<StringHash, Vector<AttributeInfo> > attributes_;
     /// Network replication attribute descriptions per object type.
     HashMap<StringHash, Vector<AttributeInfo> > networkAttributes_;
+    /// Attribute description indices by name hash per object type.
+    HashMap<StringHash, HashMap<StringHash, unsigned> > attributeIndices_;
     /// Event receivers for non-specific events.
     HashMap<StringHash, HashSet<Object*> > eventReceivers_;
     /// Event receivers for specific senders' events.
@@ -191,6 +204,10 @@ private:
     PODVector<Object*> eventSenders_;
     /// Event data stack.
     PODVector<VariantMap*> eventDataMaps_;
+    /// Converted typed event data stack.
+    PODVector<VariantMap*> typedEventDataMaps_;
+    /// Events posted from any thread.
+    EventQueue eventQueue_;
     /// Active event handler. Not stored in a stack for performance reasons; is needed only in esoteric cases.
     EventHandler* eventHandler_;
     /// Object categories.
@@ -32,35 +32,41 @@ URHO3D_EVENT(E_BEGINFRAME, BeginFrame)
 {
     URHO3D_PARAM(P_FRAMENUMBER, FrameNumber);      // unsigned
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    URHO3D_EVENT_DATA_2(E_BEGINFRAME, unsigned, frameNumber_, P_FRAMENUMBER, float, timeStep_, P_TIMESTEP);
 }
 
 /// Application-wide logic update event.
 URHO3D_EVENT(E_UPDATE, Update)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    URHO3D_EVENT_DATA_1(E_UPDATE, float, timeStep_, P_TIMESTEP);
 }
 
 /// Application-wide logic post-update event.
 URHO3D_EVENT(E_POSTUPDATE, PostUpdate)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    URHO3D_EVENT_DATA_1(E_POSTUPDATE, float, timeStep_, P_TIMESTEP);
 }
 
 /// Render update event.
 URHO3D_EVENT(E_RENDERUPDATE, RenderUpdate)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    URHO3D_EVENT_DATA_1(E_RENDERUPDATE, float, timeStep_, P_TIMESTEP);
 }
 
 /// Post-render update event.
 URHO3D_EVENT(E_POSTRENDERUPDATE, PostRenderUpdate)
 {
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    URHO3D_EVENT_DATA_1(E_POSTRENDERUPDATE, float, timeStep_, P_TIMESTEP);
 }
 
 /// Frame end event.
 URHO3D_EVENT(E_ENDFRAME, EndFrame)
 {
+    URHO3D_EVENT_DATA_0(E_ENDFRAME);
 }
 
 }
@@ -0,0 +1,300 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Atomic.h"
+#include "../Core/EventQueue.h"
+#include "../Core/Object.h"
+#include "../Core/Thread.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Event storage owned by one posting thread. The owner takes events without synchronization and the main thread returns
+/// sent events to a separate lock-free stack, which the owner claims as a whole once its own free list runs out.
+struct PostedEventPool
+{
+    /// Construct.
+    PostedEventPool(ThreadID threadID) :
+        threadID_(threadID),
+        free_(0),
+        returned_(0)
+    {
+    }
+
+    /// Destruct. Delete all events allocated by the pool.
+    ~PostedEventPool()
+    {
+        for (unsigned i = 0; i < events_.Size(); ++i)
+            delete events_[i];
+    }
+
+    /// Owner thread ID.
+    ThreadID threadID_;
+    /// Free events. Accessed only by the owner thread.
+    PostedEvent* free_;
+    /// Events returned by the main thread.
+    PostedEvent* volatile returned_;
+    /// All events allocated by the pool.
+    PODVector<PostedEvent*> events_;
+};
+
+/// Pool of the calling thread.
+static URHO3D_THREAD_LOCAL PostedEventPool* currentPool = 0;
+/// Identifier of the queue that owns the calling thread's pool.
+static URHO3D_THREAD_LOCAL unsigned currentPoolQueueId = 0;
+/// Identifier for the next queue.
+static unsigned nextQueueId = 1;
+
+EventQueue::EventQueue() :
+    head_(&stub_),
+    tail_(&stub_),
+    numEvents_(0),
+    numTombstones_(0),
+    id_(nextQueueId++)
+{
+}
+
+EventQueue::~EventQueue()
+{
+    for (unsigned i = 0; i < pools_.Size(); ++i)
+        delete pools_[i];
+}
+
+void EventQueue::Post(Object* sender, StringHash eventType, const VariantMap* eventData)
+{
+    PostedEvent* event = Allocate();
+    event->sender_ = sender;
+    event->eventType_ = eventType;
+    if (eventData)
+        event->eventData_ = *eventData;
+
+    AtomicAdd(numEvents_, 1);
+    Push(event);
+}
+
+void EventQueue::SendEvents()
+{
+    // Events posted by the handlers, or a nested call from a handler, are left to the next call
+    if (!HasEvents() || !sending_.Empty())
+        return;
+
+    Collect();
+    sending_.Swap(collected_);
+
+    for (unsigned i = 0; i < sending_.Size(); ++i)
+    {
+        // A sender destroyed outside the main thread meanwhile is cleared by collecting its tombstone
+        if (AtomicLoad(numTombstones_))
+            Collect();
+
+        PostedEvent* event = sending_[i];
+        // The sender is cleared if it is destroyed by an earlier event's handler
+        if (event->sender_)
+            event->sender_->SendEvent(event->eventType_, event->eventData_);
+        Release(event);
+    }
+
+    sending_.Clear();
+}
+
+void EventQueue::RemoveSender(Object* sender)
+{
+    if (!HasEvents())
+        return;
+
+    // The collected and sending lists belong to the main thread. Elsewhere queue a tombstone behind the sender's events
+    // instead. A new object at the same address can only post after it, so its events are kept
+    if (!Thread::IsMainThread())
+    {
+        PostedEvent* event = Allocate();
+        event->sender_ = sender;
+        event->tombstone_ = true;
+
+        AtomicAdd(numEvents_, 1);
+        AtomicAdd(numTombstones_, 1);
+        Push(event);
+        return;
+    }
+
+    Collect();
+    DiscardSender(sender);
+}
+
+bool EventQueue::HasEvents() const
+{
+    return AtomicLoad(numEvents_) > 0;
+}
+
+PostedEvent* EventQueue::Allocate()
+{
+    PostedEventPool* pool = GetThreadPool();
+
+    PostedEvent* event = pool->free_;
+    if (!event)
+        event = pool->free_ = AtomicExchangePtr(pool->returned_, (PostedEvent*)0);
+    if (event)
+        pool->free_ = event->next_;
+    else
+    {
+        event = new PostedEvent();
+        event->pool_ = pool;
+        pool->events_.Push(event);
+    }
+
+    return event;
+}
+
+void EventQueue::DiscardSender(Object* sender)
+{
+    for (unsigned i = 0; i < sending_.Size(); ++i)
+    {
+        if (sending_[i]->sender_ == sender)
+            sending_[i]->sender_ = 0;
+    }
+
+    for (unsigned i = 0; i < collected_.Size();)
+    {
+        PostedEvent* event = collected_[i];
+        if (event->sender_ == sender)
+        {
+            Release(event);
+            collected_.Erase(i);
+        }
+        else
+            ++i;
+    }
+}
+
+void EventQueue::Push(PostedEvent* event)
+{
+    AtomicStorePtr(event->next_, (PostedEvent*)0);
+    PostedEvent* prev = AtomicExchangePtr(head_, event);
+    // Between the exchange and this store the queue appears to end at the previous event
+    AtomicStorePtr(prev->next_, event);
+}
+
+PostedEvent* EventQueue::Pop()
+{
+    PostedEvent* tail = tail_;
+    PostedEvent* next = AtomicLoadPtr(tail->next_);
+
+    if (tail == &stub_)
+    {
+        if (!next)
+            return 0;
+        tail_ = tail = next;
+        next = AtomicLoadPtr(tail->next_);
+    }
+
+    if (next)
+    {
+        tail_ = next;
+        return tail;
+    }
+
+    // The last event can be taken only after re-linking the stub behind it, unless a producer is linking another one
+    if (tail != AtomicLoadPtr(head_))
+        return 0;
+    Push(&stub_);
+
+    next = AtomicLoadPtr(tail->next_);
+    if (next)
+    {
+        tail_ = next;
+        return tail;
+    }
+
+    return 0;
+}
+
+void EventQueue::Collect()
+{
+    while (PostedEvent* event = Pop())
+    {
+        if (event->tombstone_)
+        {
+            DiscardSender(event->sender_);
+            Release(event);
+            AtomicAdd(numTombstones_, -1);
+        }
+        else
+            collected_.Push(event);
+    }
+}
+
+void EventQueue::Release(PostedEvent* event)
+{
+    event->sender_ = 0;
+    event->tombstone_ = false;
+    event->eventData_.Clear();
+
+    PostedEventPool* pool = event->pool_;
+    for (;;)
+    {
+        PostedEvent* head = AtomicLoadPtr(pool->returned_);
+        event->next_ = head;
+        if (AtomicCompareExchangePtr(pool->returned_, head, event))
+            break;
+    }
+
+    AtomicAdd(numEvents_, -1);
+}
+
+PostedEventPool* EventQueue::GetThreadPool()
+{
+    if (currentPoolQueueId == id_)
+        return currentPool;
+
+    ThreadID threadID = Thread::GetCurrentThreadID();
+    PostedEventPool* pool = 0;
+
+    {
+        MutexLock lock(poolsMutex_);
+
+        // Reuse the pool of an exited thread with the same ID, as the ID can not be reused while the thread is alive
+        for (unsigned i = 0; i < pools_.Size(); ++i)
+        {
+            if (pools_[i]->threadID_ == threadID)
+            {
+                pool = pools_[i];
+                break;
+            }
+        }
+
+        if (!pool)
+        {
+            pool = new PostedEventPool(threadID);
+            pools_.Push(pool);
+        }
+    }
+
+    currentPool = pool;
+    currentPoolQueueId = id_;
+    return pool;
+}
+
+}
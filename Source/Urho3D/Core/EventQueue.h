@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Core/Mutex.h"
+#include "../Core/Variant.h"
+
+namespace Urho3D
+{
+
+class Object;
+struct PostedEventPool;
+
+/// Event posted from any thread, waiting to be sent from the main thread.
+struct PostedEvent
+{
+    /// Construct.
+    PostedEvent() :
+        next_(0),
+        sender_(0),
+        pool_(0),
+        tombstone_(false)
+    {
+    }
+
+    /// Next event in the queue or free list.
+    PostedEvent* volatile next_;
+    /// Sender. Null if the sender has been destroyed.
+    Object* sender_;
+    /// Event type.
+    StringHash eventType_;
+    /// Event data. Cleared before reuse so that the map keeps its allocated nodes.
+    VariantMap eventData_;
+    /// Pool of the posting thread.
+    PostedEventPool* pool_;
+    /// Whether this is not an event but a notice that the sender was destroyed outside the main thread. Earlier events from the sender are discarded when it is collected.
+    bool tombstone_;
+};
+
+/// Queue of events posted from any thread and sent from the main thread. Multiple producers, single consumer, lock-free.
+class URHO3D_API EventQueue
+{
+public:
+    /// Construct.
+    EventQueue();
+    /// Destruct. Pending events are discarded.
+    ~EventQueue();
+
+    /// Post an event. Can be called from any thread. Does not allocate once the calling thread's pool has warmed up.
+    void Post(Object* sender, StringHash eventType, const VariantMap* eventData);
+    /// Send all events posted so far. Call only from the main thread.
+    void SendEvents();
+    /// Discard pending events from a sender. Called on the sender's destruction. Outside the main thread the events are discarded before the main thread sends its next event.
+    void RemoveSender(Object* sender);
+
+    /// Return whether there may be events waiting to be sent.
+    bool HasEvents() const;
+
+private:
+    /// Link an event to the queue.
+    void Push(PostedEvent* event);
+    /// Take an event from the calling thread's pool, allocating if the pool is empty.
+    PostedEvent* Allocate();
+    /// Unlink the oldest event from the queue. Return null if empty or if the next event is still being linked. Main thread only.
+    PostedEvent* Pop();
+    /// Move all available events from the queue to the main thread's list and apply tombstones. Main thread only.
+    void Collect();
+    /// Discard the collected events from a sender and clear it from the events being sent. Main thread only.
+    void DiscardSender(Object* sender);
+    /// Return an event to the pool of its posting thread. Main thread only.
+    void Release(PostedEvent* event);
+    /// Return the calling thread's pool, creating it if necessary.
+    PostedEventPool* GetThreadPool();
+
+    /// Queue head, where producers link new events.
+    PostedEvent* volatile head_;
+    /// Queue tail, where the main thread takes events.
+    PostedEvent* tail_;
+    /// Placeholder event that keeps the queue non-empty.
+    PostedEvent stub_;
+    /// Number of events posted but not yet sent or discarded.
+    volatile int numEvents_;
+    /// Number of tombstones posted but not yet collected.
+    volatile int numTombstones_;
+    /// Events taken from the queue by the main thread, in posting order.
+    PODVector<PostedEvent*> collected_;
+    /// Events being sent.
+    PODVector<PostedEvent*> sending_;
+    /// Per-thread event pools.
+    PODVector<PostedEventPool*> pools_;
+    /// Pool list mutex. Locked only when a thread posts for the first time.
+    Mutex poolsMutex_;
+    /// Identifier for matching the thread-local pool pointer.
+    unsigned id_;
+};
+
+}
@@ -0,0 +1,220 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/FrameAllocator.h"
+#include "../Core/WorkQueue.h"
+
+#include <cstring>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned DEFAULT_FRAME_BLOCK_SIZE = 65536;
+static const unsigned FRAME_ALIGNMENT = 16;
+
+static inline unsigned AlignFrameSize(unsigned size)
+{
+    return (size + FRAME_ALIGNMENT - 1) & ~(FRAME_ALIGNMENT - 1);
+}
+
+/// Sub-arena of the frame allocator. Allocated separately for each thread to avoid false sharing.
+struct FrameArena
+{
+    /// Construct.
+    FrameArena() :
+        block_(0),
+        data_(0),
+        blockSize_(0),
+        used_(0),
+        frameUsed_(0),
+        reserved_(0)
+    {
+    }
+
+    /// Destruct. Free all blocks.
+    ~FrameArena()
+    {
+        FreeBlocks();
+    }
+
+    /// Allocate a new current block. The previous block is kept until the next reset.
+    void AllocateBlock(unsigned size)
+    {
+        if (block_)
+            retiredBlocks_.Push(block_);
+
+        block_ = new unsigned char[size + FRAME_ALIGNMENT];
+        data_ = reinterpret_cast<unsigned char*>(((size_t)block_ + FRAME_ALIGNMENT - 1) & ~(size_t)(FRAME_ALIGNMENT - 1));
+        blockSize_ = size;
+        used_ = 0;
+        reserved_ += size;
+    }
+
+    /// Free all blocks.
+    void FreeBlocks()
+    {
+        for (unsigned i = 0; i < retiredBlocks_.Size(); ++i)
+            delete[] retiredBlocks_[i];
+        retiredBlocks_.Clear();
+        delete[] block_;
+        block_ = 0;
+        data_ = 0;
+        blockSize_ = 0;
+        used_ = 0;
+        reserved_ = 0;
+    }
+
+    /// Current block.
+    unsigned char* block_;
+    /// Aligned start of the current block.
+    unsigned char* data_;
+    /// Size of the current block.
+    unsigned blockSize_;
+    /// Bytes used from the current block.
+    unsigned used_;
+    /// Bytes allocated since the last reset, in all blocks.
+    unsigned frameUsed_;
+    /// Bytes reserved in all blocks.
+    unsigned reserved_;
+    /// Blocks that became full during the frame.
+    PODVector<unsigned char*> retiredBlocks_;
+};
+
+FrameAllocator::FrameAllocator(Context* context) :
+    Object(context),
+    blockSize_(DEFAULT_FRAME_BLOCK_SIZE)
+{
+    SetNumThreads(1);
+
+    SubscribeToEvent(E_ENDFRAME, URHO3D_TYPED_HANDLER(FrameAllocator, HandleEndFrame));
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        delete arenas_[i];
+}
+
+void FrameAllocator::SetNumThreads(unsigned numThreads)
+{
+    while (arenas_.Size() < numThreads)
+        arenas_.Push(new FrameArena());
+}
+
+void FrameAllocator::SetBlockSize(unsigned size)
+{
+    blockSize_ = AlignFrameSize(Max(size, FRAME_ALIGNMENT));
+}
+
+void* FrameAllocator::Allocate(unsigned size, unsigned threadIndex)
+{
+    assert(threadIndex < arenas_.Size());
+
+    FrameArena* arena = arenas_[threadIndex];
+    size = AlignFrameSize(size);
+    if (arena->used_ + size > arena->blockSize_)
+        arena->AllocateBlock(Max(size, blockSize_));
+
+    void* ptr = arena->data_ + arena->used_;
+    arena->used_ += size;
+    arena->frameUsed_ += size;
+    return ptr;
+}
+
+void* FrameAllocator::Reallocate(void* ptr, unsigned oldSize, unsigned newSize, unsigned threadIndex)
+{
+    if (!ptr)
+        return Allocate(newSize, threadIndex);
+
+    assert(threadIndex < arenas_.Size());
+
+    FrameArena* arena = arenas_[threadIndex];
+    oldSize = AlignFrameSize(oldSize);
+    newSize = AlignFrameSize(newSize);
+    if (newSize <= oldSize)
+        return ptr;
+
+    // Grow in place if the allocation is the last one in the current block and there is room
+    unsigned char* bytes = static_cast<unsigned char*>(ptr);
+    if (bytes + oldSize == arena->data_ + arena->used_ && arena->used_ - oldSize + newSize <= arena->blockSize_)
+    {
+        arena->used_ += newSize - oldSize;
+        arena->frameUsed_ += newSize - oldSize;
+        return ptr;
+    }
+
+    void* newPtr = Allocate(newSize, threadIndex);
+    memcpy(newPtr, ptr, oldSize);
+    return newPtr;
+}
+
+void FrameAllocator::Reset()
+{
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+    {
+        FrameArena* arena = arenas_[i];
+
+        // If the arena overflowed, replace its blocks with one block that fits the whole frame
+        if (arena->retiredBlocks_.Size())
+        {
+            unsigned frameUsed = arena->frameUsed_;
+            arena->FreeBlocks();
+            arena->AllocateBlock(Max(AlignFrameSize(frameUsed + frameUsed / 4), blockSize_));
+        }
+
+        arena->used_ = 0;
+        arena->frameUsed_ = 0;
+    }
+}
+
+unsigned FrameAllocator::GetUsedBytes() const
+{
+    unsigned total = 0;
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        total += arenas_[i]->frameUsed_;
+    return total;
+}
+
+unsigned FrameAllocator::GetReservedBytes() const
+{
+    unsigned total = 0;
+    for (unsigned i = 0; i < arenas_.Size(); ++i)
+        total += arenas_[i]->reserved_;
+    return total;
+}
+
+void FrameAllocator::HandleEndFrame(StringHash eventType, const EndFrame::Data& eventData)
+{
+    Reset();
+
+    // Worker threads may have been created after construction; make sure each has a sub-arena for the next frame
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue)
+        SetNumThreads(queue->GetNumThreads() + 1);
+}
+
+}
@@ -0,0 +1,180 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Core/CoreEvents.h"
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+
+struct FrameArena;
+
+/// Linear allocator for transient data that lives until the end of the frame. Has a sub-arena for each thread index of the WorkQueue (0 is the main thread), so that worker threads can allocate without locking. All allocations are released at once on the end frame event; memory is kept and reused on the next frame.
+class URHO3D_API FrameAllocator : public Object
+{
+    URHO3D_OBJECT(FrameAllocator, Object);
+
+public:
+    /// Construct.
+    FrameAllocator(Context* context);
+    /// Destruct. Free all memory.
+    ~FrameAllocator();
+
+    /// Set number of sub-arenas, normally the worker thread count plus one for the main thread. Can only be increased, and not while other threads are allocating.
+    void SetNumThreads(unsigned numThreads);
+    /// Set the minimum size of memory blocks in bytes.
+    void SetBlockSize(unsigned size);
+    /// Allocate memory from the sub-arena of a thread. The memory is 16-byte aligned and valid until the end of the frame.
+    void* Allocate(unsigned size, unsigned threadIndex = 0);
+    /// Grow an allocation made from the sub-arena of a thread, in place if it was the last allocation. Return the possibly moved memory.
+    void* Reallocate(void* ptr, unsigned oldSize, unsigned newSize, unsigned threadIndex = 0);
+    /// Release all allocations. Called automatically at the end of frame. Sub-arenas that overflowed their memory during the frame are resized to fit the whole frame.
+    void Reset();
+
+    /// Allocate an uninitialized array. Only for types that need no construction or destruction.
+    template <class T> T* AllocateArray(unsigned count, unsigned threadIndex = 0)
+    {
+        return static_cast<T*>(Allocate(count * sizeof(T), threadIndex));
+    }
+
+    /// Return number of sub-arenas.
+    unsigned GetNumThreads() const { return arenas_.Size(); }
+
+    /// Return minimum size of memory blocks.
+    unsigned GetBlockSize() const { return blockSize_; }
+
+    /// Return bytes allocated since the last reset, in all sub-arenas.
+    unsigned GetUsedBytes() const;
+    /// Return bytes reserved from the heap, in all sub-arenas.
+    unsigned GetReservedBytes() const;
+
+private:
+    /// Handle end of frame. Reset the allocator.
+    void HandleEndFrame(StringHash eventType, const EndFrame::Data& eventData);
+
+    /// Sub-arenas.
+    PODVector<FrameArena*> arenas_;
+    /// Minimum size of memory blocks.
+    unsigned blockSize_;
+};
+
+/// Growable array of POD elements allocated from a FrameAllocator. Must be assigned a sub-arena each frame with SetAllocator() before pushing elements. Copies share the same memory.
+template <class T> class FrameVector
+{
+public:
+    typedef RandomAccessIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+
+    /// Construct empty.
+    FrameVector() :
+        buffer_(0),
+        size_(0),
+        capacity_(0),
+        allocator_(0),
+        threadIndex_(0)
+    {
+    }
+
+    /// Set the allocator and sub-arena to allocate from, and clear. The previous contents are discarded.
+    void SetAllocator(FrameAllocator* allocator, unsigned threadIndex = 0)
+    {
+        buffer_ = 0;
+        size_ = 0;
+        capacity_ = 0;
+        allocator_ = allocator;
+        threadIndex_ = threadIndex;
+    }
+
+    /// Add an element at the end.
+    void Push(const T& value)
+    {
+        if (size_ == capacity_)
+            Reserve(capacity_ ? capacity_ << 1 : 8);
+        buffer_[size_++] = value;
+    }
+
+    /// Set new capacity. Can only grow.
+    void Reserve(unsigned newCapacity)
+    {
+        if (newCapacity <= capacity_)
+            return;
+
+        assert(allocator_);
+        if (buffer_)
+            buffer_ = static_cast<T*>(allocator_->Reallocate(buffer_, capacity_ * sizeof(T), newCapacity * sizeof(T), threadIndex_));
+        else
+            buffer_ = allocator_->AllocateArray<T>(newCapacity, threadIndex_);
+        capacity_ = newCapacity;
+    }
+
+    /// Remove all elements. The memory is kept until the allocator is reset.
+    void Clear() { size_ = 0; }
+
+    /// Return element at index.
+    T& operator [](unsigned index)
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return const element at index.
+    const T& operator [](unsigned index) const
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(buffer_); }
+
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(buffer_); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(buffer_ + size_); }
+
+    /// Return const iterator to the end.
+    ConstIterator End() const { return ConstIterator(buffer_ + size_); }
+
+    /// Return number of elements.
+    unsigned Size() const { return size_; }
+
+    /// Return whether has no elements.
+    bool Empty() const { return size_ == 0; }
+
+private:
+    /// Element buffer.
+    T* buffer_;
+    /// Number of elements.
+    unsigned size_;
+    /// Capacity of the buffer.
+    unsigned capacity_;
+    /// Allocator.
+    FrameAllocator* allocator_;
+    /// Sub-arena index.
+    unsigned threadIndex_;
+};
+
+}
@@ -85,42 +85,37 @@ Object::~Object()
 
 void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData)
 {
+    EventHandler* handler = SelectEventHandler(sender, eventType);
+    if (!handler)
+        return;
+
     // Make a copy of the context pointer in case the object is destroyed during event handler invocation
     Context* context = context_;
-    EventHandler* specific = 0;
-    EventHandler* nonSpecific = 0;
-
-    EventHandler* handler = eventHandlers_.First();
-    while (handler)
-    {
-        if (handler->GetEventType() == eventType)
-        {
-            if (!handler->GetSender())
-                nonSpecific = handler;
-            else if (handler->GetSender() == sender)
-            {
-                specific = handler;
-                break;
-            }
-        }
-        handler = eventHandlers_.Next(handler);
-    }
+    context->SetEventHandler(handler);
+    handler->Invoke(eventData);
+    context->SetEventHandler(0);
+}
 
-    // Specific event handlers have priority, so if found, invoke first
-    if (specific)
-    {
-        context->SetEventHandler(specific);
-        specific->Invoke(eventData);
-        context->SetEventHandler(0);
+void Object::OnTypedEvent(Object* sender, StringHash eventType, TypedEventData& eventData)
+{
+    EventHandler* handler = SelectEventHandler(sender, eventType);
+    if (!handler)
         return;
-    }
 
-    if (nonSpecific)
+    Context* context = context_;
+    context->SetEventHandler(handler);
+    if (!handler->InvokeTyped(eventData.data_))
     {
-        context->SetEventHandler(nonSpecific);
-        nonSpecific->Invoke(eventData);
-        context->SetEventHandler(0);
+        // Convert to a VariantMap for the first handler that needs one, and reuse it for the rest. Each nesting level has
+        // its own map, so that nested events can not overwrite it
+        if (!eventData.eventData_)
+        {
+            eventData.eventData_ = &context->GetTypedEventDataMap(context->eventSenders_.Size() - 1);
+            eventData.toVariantMap_(eventData.data_, *eventData.eventData_);
+        }
+        handler->Invoke(*eventData.eventData_);
     }
+    context->SetEventHandler(0);
 }
 
 bool Object::IsTypeOf(StringHash type)
@@ -296,6 +291,11 @@ void Object::SendEvent(StringHash eventType)
 }
 
 void Object::SendEvent(StringHash eventType, VariantMap& eventData)
+{
+    SendEvent(eventType, &eventData, 0);
+}
+
+void Object::SendEvent(StringHash eventType, VariantMap* eventData, TypedEventData* typedData)
 {
     if (!Thread::IsMainThread())
     {
@@ -323,7 +323,10 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
                 next = *i;
 
             unsigned oldSize = group->Size();
-            receiver->OnEvent(this, eventType, eventData);
+            if (typedData)
+                receiver->OnTypedEvent(this, eventType, *typedData);
+            else
+                receiver->OnEvent(this, eventType, *eventData);
 
             // If self has been destroyed as a result of event handling, exit
             if (self.Expired())
@@ -356,7 +359,10 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
                     next = *i;
 
                 unsigned oldSize = group->Size();
-                receiver->OnEvent(this, eventType, eventData);
+                if (typedData)
+                    receiver->OnTypedEvent(this, eventType, *typedData);
+                else
+                    receiver->OnEvent(this, eventType, *eventData);
 
                 if (self.Expired())
                 {
@@ -382,7 +388,10 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
                 if (!processed.Contains(receiver))
                 {
                     unsigned oldSize = group->Size();
-                    receiver->OnEvent(this, eventType, eventData);
+                    if (typedData)
+                        receiver->OnTypedEvent(this, eventType, *typedData);
+                    else
+                        receiver->OnEvent(this, eventType, *eventData);
 
                     if (self.Expired())
                     {
@@ -400,6 +409,16 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     context->EndSendEvent();
 }
 
+void Object::PostEvent(StringHash eventType)
+{
+    context_->eventQueue_.Post(this, eventType, 0);
+}
+
+void Object::PostEvent(StringHash eventType, const VariantMap& eventData)
+{
+    context_->eventQueue_.Post(this, eventType, &eventData);
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     return context_->GetEventDataMap();
@@ -460,6 +479,27 @@ const String& Object::GetCategory() const
     return String::EMPTY;
 }
 
+EventHandler* Object::SelectEventHandler(Object* sender, StringHash eventType) const
+{
+    EventHandler* nonSpecific = 0;
+
+    EventHandler* handler = eventHandlers_.First();
+    while (handler)
+    {
+        if (handler->GetEventType() == eventType)
+        {
+            // Specific event handlers have priority
+            if (!handler->GetSender())
+                nonSpecific = handler;
+            else if (handler->GetSender() == sender)
+                return handler;
+        }
+        handler = eventHandlers_.Next(handler);
+    }
+
+    return nonSpecific;
+}
+
 EventHandler* Object::FindEventHandler(StringHash eventType, EventHandler** previous) const
 {
     EventHandler* handler = eventHandlers_.First();
@@ -34,6 +34,31 @@ namespace Urho3D
 class Context;
 class EventHandler;
 
+/// Event data of a typed event being sent. Converted to a VariantMap only when a handler needs one.
+struct TypedEventData
+{
+    /// Construct.
+    TypedEventData(const void* data, void (*toVariantMap)(const void*, VariantMap&)) :
+        data_(data),
+        toVariantMap_(toVariantMap),
+        eventData_(0)
+    {
+    }
+
+    /// Event struct.
+    const void* data_;
+    /// Function to fill a VariantMap from the event struct.
+    void (*toVariantMap_)(const void*, VariantMap&);
+    /// Converted event data. Null until a handler needs it.
+    VariantMap* eventData_;
+};
+
+/// Fill a VariantMap from a typed event struct.
+template <class T> void TypedEventToVariantMap(const void* data, VariantMap& eventData)
+{
+    static_cast<const T*>(data)->ToVariantMap(eventData);
+}
+
 /// Type info.
 class URHO3D_API TypeInfo
 {
@@ -136,6 +161,16 @@ public:
     void SendEvent(StringHash eventType);
     /// Send event with parameters to all subscribers.
     void SendEvent(StringHash eventType, VariantMap& eventData);
+    /// Send typed event to all subscribers. Typed handlers receive the struct as is, other handlers receive a VariantMap that is filled once on demand.
+    template <class T> void SendTypedEvent(const T& eventData)
+    {
+        TypedEventData typedData(&eventData, &TypedEventToVariantMap<T>);
+        SendEvent(T::GetEventType(), (VariantMap*)0, &typedData);
+    }
+    /// Post event to be sent to all subscribers from the main thread at the start of the next frame. Can be called from any thread.
+    void PostEvent(StringHash eventType);
+    /// Post event with parameters to be sent to all subscribers from the main thread at the start of the next frame. The parameters are copied. Can be called from any thread.
+    void PostEvent(StringHash eventType, const VariantMap& eventData);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap() const;
 #if URHO3D_CXX11
@@ -178,6 +213,12 @@ protected:
     Context* context_;
 
 private:
+    /// Send event with either parameters or typed event data to all subscribers.
+    void SendEvent(StringHash eventType, VariantMap* eventData, TypedEventData* typedData);
+    /// Handle typed event.
+    void OnTypedEvent(Object* sender, StringHash eventType, TypedEventData& eventData);
+    /// Return the handler to invoke for an event, preferring a handler specific to the sender. Return null if none.
+    EventHandler* SelectEventHandler(Object* sender, StringHash eventType) const;
     /// Find the first event handler with no specific sender.
     EventHandler* FindEventHandler(StringHash eventType, EventHandler** previous = 0) const;
     /// Find the first event handler with specific sender.
@@ -266,6 +307,8 @@ public:
 
     /// Invoke event handler function.
     virtual void Invoke(VariantMap& eventData) = 0;
+    /// Invoke event handler function with a typed event struct. Return false if the handler accepts only a VariantMap.
+    virtual bool InvokeTyped(const void* eventData) { return false; }
     /// Return a unique copy of the event handler.
     virtual EventHandler* Clone() const = 0;
 
@@ -324,6 +367,68 @@ private:
     HandlerFunctionPtr function_;
 };
 
+/// Template implementation of the event handler invoke helper for typed events (stores a function pointer of specific class.)
+template <class T, class U> class TypedEventHandlerImpl : public EventHandler
+{
+public:
+    typedef void (T::*HandlerFunctionPtr)(StringHash, const U&);
+
+    /// Construct with receiver and function pointers and userdata.
+    TypedEventHandlerImpl(T* receiver, HandlerFunctionPtr function, void* userData = 0) :
+        EventHandler(receiver, userData),
+        function_(function)
+    {
+        assert(function_);
+    }
+
+    /// Invoke event handler function. Used when the event is sent with a VariantMap.
+    virtual void Invoke(VariantMap& eventData)
+    {
+        U data;
+        data.FromVariantMap(eventData);
+        T* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(eventType_, data);
+    }
+
+    /// Invoke event handler function with a typed event struct.
+    virtual bool InvokeTyped(const void* eventData)
+    {
+        T* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(eventType_, *static_cast<const U*>(eventData));
+        return true;
+    }
+
+    /// Return a unique copy of the event handler.
+    virtual EventHandler* Clone() const
+    {
+        return new TypedEventHandlerImpl(static_cast<T*>(receiver_), function_, userData_);
+    }
+
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
+/// Construct a typed event handler. Used by the URHO3D_TYPED_HANDLER macro to deduce the event struct type.
+template <class T, class U> EventHandler* MakeTypedEventHandler(T* receiver, void (T::*function)(StringHash, const U&), void* userData = 0)
+{
+    return new TypedEventHandlerImpl<T, U>(receiver, function, userData);
+}
+
+/// Read a typed event parameter from a VariantMap. Leave default-constructed if missing.
+template <class T> void GetEventParam(const VariantMap& eventData, StringHash paramID, T& dest)
+{
+    VariantMap::ConstIterator i = eventData.Find(paramID);
+    dest = i != eventData.End() ? i->second_.Get<T>() : T();
+}
+
+/// Read a typed event parameter pointing to a RefCounted subclass from a VariantMap. Set to null if missing.
+template <class T> void GetEventParam(const VariantMap& eventData, StringHash paramID, T*& dest)
+{
+    VariantMap::ConstIterator i = eventData.Find(paramID);
+    dest = i != eventData.End() ? static_cast<T*>(i->second_.GetPtr()) : 0;
+}
+
 #if URHO3D_CXX11
 /// Template implementation of the event handler invoke helper (std::function instance).
 class EventHandler11Impl : public EventHandler
@@ -360,9 +465,39 @@ private:
 #define URHO3D_EVENT(eventID, eventName) static const Urho3D::StringHash eventID(#eventName); namespace eventName
 /// Describe an event's parameter hash ID. Should be used inside an event namespace.
 #define URHO3D_PARAM(paramID, paramName) static const Urho3D::StringHash paramID(#paramName)
+/// Describe the typed event struct of an event without parameters. Should be used inside the event namespace.
+#define URHO3D_EVENT_DATA_0(eventID) struct Data \
+{ \
+    static Urho3D::StringHash GetEventType() { return eventID; } \
+    template <class T> void ToVariantMap(T&) const { } \
+    template <class T> void FromVariantMap(const T&) { } \
+}
+/// Describe the typed event struct of an event with one parameter. Should be used inside the event namespace after the parameter IDs.
+#define URHO3D_EVENT_DATA_1(eventID, type1, member1, paramID1) struct Data \
+{ \
+    static Urho3D::StringHash GetEventType() { return eventID; } \
+    template <class T> void ToVariantMap(T& eventData) const { eventData[paramID1] = member1; } \
+    template <class T> void FromVariantMap(const T& eventData) { Urho3D::GetEventParam(eventData, paramID1, member1); } \
+    type1 member1; \
+}
+/// Describe the typed event struct of an event with two parameters. Should be used inside the event namespace after the parameter IDs.
+#define URHO3D_EVENT_DATA_2(eventID, type1, member1, paramID1, type2, member2, paramID2) struct Data \
+{ \
+    static Urho3D::StringHash GetEventType() { return eventID; } \
+    template <class T> void ToVariantMap(T& eventData) const { eventData[paramID1] = member1; eventData[paramID2] = member2; } \
+    template <class T> void FromVariantMap(const T& eventData) \
+    { \
+        Urho3D::GetEventParam(eventData, paramID1, member1); \
+        Urho3D::GetEventParam(eventData, paramID2, member2); \
+    } \
+    type1 member1; \
+    type2 member2; \
+}
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function.
 #define URHO3D_HANDLER(className, function) (new Urho3D::EventHandlerImpl<className>(this, &className::function))
 /// Convenience macro to construct an EventHandler that points to a receiver object and its member function, and also defines a userdata pointer.
 #define URHO3D_HANDLER_USERDATA(className, function, userData) (new Urho3D::EventHandlerImpl<className>(this, &className::function, userData))
+/// Convenience macro to construct an EventHandler that points to a receiver object and its member function taking a typed event struct.
+#define URHO3D_TYPED_HANDLER(className, function) (Urho3D::MakeTypedEventHandler<className>(this, &className::function))
 
 }
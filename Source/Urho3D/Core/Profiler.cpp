@@ -22,8 +22,10 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Atomic.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../IO/Serializer.h"
 
 #include <cstdio>
 
@@ -35,12 +37,38 @@ namespace Urho3D
 static const int LINE_MAX_LENGTH = 256;
 static const int NAME_MAX_LENGTH = 30;
 
+/// Capture buffer of the calling thread.
+static URHO3D_THREAD_LOCAL ProfilerThread* currentThread = 0;
+/// Identifier of the profiler that owns the calling thread's capture buffer.
+static URHO3D_THREAD_LOCAL unsigned currentThreadProfilerId = 0;
+/// Identifier for the next profiler.
+static unsigned nextProfilerId = 1;
+
+static void WriteText(Serializer& dest, const String& text)
+{
+    dest.Write(text.CString(), text.Length());
+}
+
+static String EscapeTraceName(const char* name)
+{
+    String escaped(name);
+    escaped.Replace("\\", "\\\\");
+    escaped.Replace("\"", "\\\"");
+    return escaped;
+}
+
 Profiler::Profiler(Context* context) :
     Object(context),
     current_(0),
     root_(0),
     intervalFrames_(0),
-    totalFrames_(0)
+    totalFrames_(0),
+    capturing_(false),
+    captureGeneration_(0),
+    captureEventsPerThread_(DEFAULT_PROFILER_CAPTURE_EVENTS),
+    captureFrames_(0),
+    capturedFrames_(0),
+    id_(nextProfilerId++)
 {
     root_ = new ProfilerBlock(0, "Root");
     current_ = root_;
@@ -50,6 +78,9 @@ Profiler::~Profiler()
 {
     delete root_;
     root_ = 0;
+
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        delete threads_[i];
 }
 
 void Profiler::BeginFrame()
@@ -57,6 +88,17 @@ void Profiler::BeginFrame()
     // End the previous frame if any
     EndFrame();
 
+    if (capturing_)
+    {
+        if (captureFrames_ && capturedFrames_ >= captureFrames_)
+            EndCapture();
+        else
+        {
+            ++capturedFrames_;
+            RecordEvent(PE_FRAME, 0);
+        }
+    }
+
     BeginBlock("RunFrame");
 }
 
@@ -80,6 +122,97 @@ void Profiler::BeginInterval()
     intervalFrames_ = 0;
 }
 
+void Profiler::BeginCapture(unsigned numFrames, unsigned maxEventsPerThread)
+{
+    capturing_ = false;
+
+    captureEventsPerThread_ = Max(maxEventsPerThread, 2U);
+    captureFrames_ = numFrames;
+    capturedFrames_ = 0;
+    captureTimer_.Reset();
+    // Threads reset their own buffers when they see the new generation
+    AtomicAdd(captureGeneration_, 1);
+
+    // Make sure the main thread is listed first
+    GetCurrentThread();
+    capturing_ = true;
+}
+
+void Profiler::EndCapture()
+{
+    capturing_ = false;
+}
+
+void Profiler::SetThreadName(const String& name)
+{
+    ProfilerThread* thread = GetCurrentThread();
+
+    MutexLock lock(threadsMutex_);
+    thread->name_ = name;
+}
+
+bool Profiler::SaveTrace(Serializer& dest) const
+{
+    MutexLock lock(threadsMutex_);
+
+    int generation = AtomicLoad(captureGeneration_);
+    bool first = true;
+
+    WriteText(dest, "{\"traceEvents\":[\n");
+
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+    {
+        const ProfilerThread* thread = threads_[i];
+        if (AtomicLoad(thread->generation_) != generation)
+            continue;
+
+        String tid(thread->index_);
+        String line = String(first ? "" : ",\n") + "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid +
+            ",\"args\":{\"name\":\"" + EscapeTraceName(thread->name_.CString()) + "\"}}";
+        WriteText(dest, line);
+        first = false;
+
+        // Events are published by the count, so the events up to it are complete even if the thread is still recording
+        unsigned numEvents = (unsigned)AtomicLoad(thread->numEvents_);
+        unsigned openBlocks = 0;
+        long long lastTime = 0;
+
+        for (unsigned j = 0; j < numEvents; ++j)
+        {
+            const ProfilerEvent& event = thread->events_[j];
+            String ts(event.time_);
+            lastTime = event.time_;
+
+            switch (event.type_)
+            {
+            case PE_BEGIN:
+                line = ",\n{\"name\":\"" + EscapeTraceName(event.name_) + "\",\"ph\":\"B\",\"ts\":" + ts + ",\"pid\":1,\"tid\":" + tid + "}";
+                ++openBlocks;
+                break;
+
+            case PE_END:
+                line = ",\n{\"ph\":\"E\",\"ts\":" + ts + ",\"pid\":1,\"tid\":" + tid + "}";
+                --openBlocks;
+                break;
+
+            case PE_FRAME:
+                line = ",\n{\"name\":\"" + String(event.name_) + "\",\"ph\":\"i\",\"s\":\"g\",\"ts\":" + ts + ",\"pid\":1,\"tid\":" +
+                    tid + "}";
+                break;
+            }
+
+            WriteText(dest, line);
+        }
+
+        // Close blocks that were still open when the capture ended
+        while (openBlocks--)
+            WriteText(dest, ",\n{\"ph\":\"E\",\"ts\":" + String(lastTime) + ",\"pid\":1,\"tid\":" + tid + "}");
+    }
+
+    WriteText(dest, "\n]}\n");
+    return true;
+}
+
 String Profiler::PrintData(bool showUnused, bool showTotal, unsigned maxDepth) const
 {
     String output;
@@ -156,4 +289,90 @@ void Profiler::PrintData(ProfilerBlock* block, String& output, unsigned depth, u
         PrintData(*i, output, depth, maxDepth, showUnused, showTotal);
 }
 
+void Profiler::RecordEvent(ProfilerEventType type, const char* name)
+{
+    ProfilerThread* thread = GetCurrentThread();
+
+    int generation = AtomicLoad(captureGeneration_);
+    if (thread->generation_ != generation)
+    {
+        // First event of a new capture. Only this thread writes to the buffer, so it can be reset here
+        thread->events_.Resize(captureEventsPerThread_);
+        thread->openBlocks_ = 0;
+        thread->skippedBlocks_ = 0;
+        thread->droppedEvents_ = 0;
+        AtomicStore(thread->numEvents_, 0);
+        AtomicStore(thread->generation_, generation);
+    }
+
+    unsigned numEvents = (unsigned)thread->numEvents_;
+    unsigned capacity = thread->events_.Size();
+
+    switch (type)
+    {
+    case PE_BEGIN:
+        // Always keep room for ending the blocks already recorded, so that the timeline stays balanced
+        if (numEvents + thread->openBlocks_ + 2 > capacity)
+        {
+            ++thread->skippedBlocks_;
+            ++thread->droppedEvents_;
+            return;
+        }
+        ++thread->openBlocks_;
+        break;
+
+    case PE_END:
+        if (thread->skippedBlocks_)
+        {
+            --thread->skippedBlocks_;
+            ++thread->droppedEvents_;
+            return;
+        }
+        // Ignore ends of blocks that began before the capture
+        if (!thread->openBlocks_)
+            return;
+        --thread->openBlocks_;
+        break;
+
+    case PE_FRAME:
+        if (numEvents + thread->openBlocks_ + 1 > capacity)
+        {
+            ++thread->droppedEvents_;
+            return;
+        }
+        break;
+    }
+
+    ProfilerEvent& event = thread->events_[numEvents];
+    event.time_ = captureTimer_.GetUSec(false);
+    event.type_ = type;
+    if (type == PE_FRAME)
+        sprintf(event.name_, "Frame %u", capturedFrames_);
+    else if (name)
+    {
+        strncpy(event.name_, name, PROFILER_EVENT_NAME_LENGTH - 1);
+        event.name_[PROFILER_EVENT_NAME_LENGTH - 1] = 0;
+    }
+    else
+        event.name_[0] = 0;
+
+    AtomicStore(thread->numEvents_, (int)(numEvents + 1));
+}
+
+ProfilerThread* Profiler::GetCurrentThread()
+{
+    if (currentThreadProfilerId == id_)
+        return currentThread;
+
+    MutexLock lock(threadsMutex_);
+
+    unsigned index = threads_.Size();
+    ProfilerThread* thread = new ProfilerThread(Thread::IsMainThread() ? String("Main") : "Thread " + String(index), index);
+    threads_.Push(thread);
+
+    currentThread = thread;
+    currentThreadProfilerId = id_;
+    return thread;
+}
+
 }
@@ -23,12 +23,72 @@
 #pragma once
 
 #include "../Container/Str.h"
+#include "../Core/Mutex.h"
 #include "../Core/Thread.h"
 #include "../Core/Timer.h"
 
 namespace Urho3D
 {
 
+class Serializer;
+
+/// Maximum length of a block name in captured profiling events, including the terminating zero.
+static const unsigned PROFILER_EVENT_NAME_LENGTH = 40;
+/// Default maximum number of captured profiling events per thread.
+static const unsigned DEFAULT_PROFILER_CAPTURE_EVENTS = 65536;
+
+/// Captured profiling event type.
+enum ProfilerEventType
+{
+    PE_BEGIN = 0,
+    PE_END,
+    PE_FRAME
+};
+
+/// Profiling event captured for the trace timeline.
+struct ProfilerEvent
+{
+    /// Time since the capture began in microseconds.
+    long long time_;
+    /// Event type.
+    ProfilerEventType type_;
+    /// Block name, truncated if too long.
+    char name_[PROFILER_EVENT_NAME_LENGTH];
+};
+
+/// Captured profiling events of one thread. Written only by the thread itself, so recording needs no locking.
+struct ProfilerThread
+{
+    /// Construct.
+    ProfilerThread(const String& name, unsigned index) :
+        name_(name),
+        index_(index),
+        generation_(0),
+        numEvents_(0),
+        openBlocks_(0),
+        skippedBlocks_(0),
+        droppedEvents_(0)
+    {
+    }
+
+    /// Thread name shown in the trace.
+    String name_;
+    /// Thread index shown in the trace.
+    unsigned index_;
+    /// Capture the events belong to.
+    volatile int generation_;
+    /// Event storage. Sized on the first event of a capture.
+    PODVector<ProfilerEvent> events_;
+    /// Number of recorded events. Published after the event has been written.
+    volatile int numEvents_;
+    /// Recorded begin events without a matching end.
+    unsigned openBlocks_;
+    /// Begin events dropped due to a full buffer, whose end events must also be dropped.
+    unsigned skippedBlocks_;
+    /// Number of events dropped due to a full buffer.
+    unsigned droppedEvents_;
+};
+
 /// Profiling data for one block in the profiling tree.
 class URHO3D_API ProfilerBlock
 {
@@ -182,7 +242,9 @@ public:
     /// Begin timing a profiling block.
     void BeginBlock(const char* name)
     {
-        // Profiler supports only the main thread currently
+        // Blocks from all threads are captured to the trace, but the block tree supports only the main thread
+        if (capturing_)
+            RecordEvent(PE_BEGIN, name);
         if (!Thread::IsMainThread())
             return;
         
@@ -193,6 +255,8 @@ public:
     /// End timing the current profiling block.
     void EndBlock()
     {
+        if (capturing_)
+            RecordEvent(PE_END, 0);
         if (!Thread::IsMainThread())
             return;
         
@@ -209,6 +273,19 @@ public:
     void EndFrame();
     /// Begin a new interval.
     void BeginInterval();
+    /// Begin capturing profiling blocks from all threads to a timeline. Stop automatically after the specified number of frames, or continue until EndCapture() if zero. Previously captured events are discarded.
+    void BeginCapture(unsigned numFrames = 0, unsigned maxEventsPerThread = DEFAULT_PROFILER_CAPTURE_EVENTS);
+    /// Stop capturing.
+    void EndCapture();
+    /// Set the name of the calling thread for the captured timeline.
+    void SetThreadName(const String& name);
+    /// Save the captured timeline in the Chrome trace event JSON format, which can be opened in chrome://tracing or Perfetto. Return true if successful.
+    bool SaveTrace(Serializer& dest) const;
+    
+    /// Return whether is capturing.
+    bool IsCapturing() const { return capturing_; }
+    /// Return number of frames captured so far.
+    unsigned GetCapturedFrames() const { return capturedFrames_; }
     
     /// Return profiling data as text output.
     String PrintData(bool showUnused = false, bool showTotal = false, unsigned maxDepth = M_MAX_UNSIGNED) const;
@@ -220,6 +297,10 @@ public:
 private:
     /// Return profiling data as text output for a specified profiling block.
     void PrintData(ProfilerBlock* block, String& output, unsigned depth, unsigned maxDepth, bool showUnused, bool showTotal) const;
+    /// Record a captured event in the calling thread's buffer.
+    void RecordEvent(ProfilerEventType type, const char* name);
+    /// Return the calling thread's capture buffer, creating it if necessary.
+    ProfilerThread* GetCurrentThread();
     
     /// Current profiling block.
     ProfilerBlock* current_;
@@ -229,6 +310,24 @@ private:
     unsigned intervalFrames_;
     /// Total frames.
     unsigned totalFrames_;
+    /// Per-thread capture buffers.
+    Vector<ProfilerThread*> threads_;
+    /// Mutex for registering threads.
+    mutable Mutex threadsMutex_;
+    /// Timer for captured event timestamps.
+    HiresTimer captureTimer_;
+    /// Capturing flag.
+    volatile bool capturing_;
+    /// Capture generation. Incremented on each BeginCapture() so that the threads can reset their buffers themselves.
+    volatile int captureGeneration_;
+    /// Maximum captured events per thread.
+    unsigned captureEventsPerThread_;
+    /// Frames to capture, or zero for unlimited.
+    unsigned captureFrames_;
+    /// Frames captured so far.
+    unsigned capturedFrames_;
+    /// Unique identifier of this profiler, to validate the thread-local buffer pointers.
+    unsigned id_;
 };
 
 /// Helper class for automatically beginning and ending a profiling block
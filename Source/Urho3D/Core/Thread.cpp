@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Allocator.h"
 #include "../Core/Thread.h"
 
 #ifdef _WIN32
@@ -42,6 +43,7 @@ DWORD WINAPI ThreadFunctionStatic(void* data)
 {
     Thread* thread = static_cast<Thread*>(data);
     thread->ThreadFunction();
+    ReleaseThreadMemoryCache();
     return 0;
 }
 
@@ -51,6 +53,7 @@ void* ThreadFunctionStatic(void* data)
 {
     Thread* thread = static_cast<Thread*>(data);
     thread->ThreadFunction();
+    ReleaseThreadMemoryCache();
     pthread_exit((void*)0);
     return 0;
 }
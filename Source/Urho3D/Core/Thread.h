@@ -35,6 +35,13 @@ typedef pthread_t ThreadID;
 typedef unsigned ThreadID;
 #endif
 
+/// Storage class specifier for thread-local variables of POD type.
+#ifdef _MSC_VER
+#define URHO3D_THREAD_LOCAL __declspec(thread)
+#else
+#define URHO3D_THREAD_LOCAL __thread
+#endif
+
 namespace Urho3D
 {
 
@@ -118,12 +118,10 @@ void Time::BeginFrame(float timeStep)
         URHO3D_PROFILE(BeginFrame);
 
         // Frame begin event
-        using namespace BeginFrame;
-
-        VariantMap& eventData = GetEventDataMap();
-        eventData[P_FRAMENUMBER] = frameNumber_;
-        eventData[P_TIMESTEP] = timeStep_;
-        SendEvent(E_BEGINFRAME, eventData);
+        BeginFrame::Data eventData;
+        eventData.frameNumber_ = frameNumber_;
+        eventData.timeStep_ = timeStep_;
+        SendTypedEvent(eventData);
     }
 }
 
@@ -133,7 +131,7 @@ void Time::EndFrame()
         URHO3D_PROFILE(EndFrame);
 
         // Frame end event
-        SendEvent(E_ENDFRAME);
+        SendTypedEvent(EndFrame::Data());
     }
 
     Profiler* profiler = GetSubsystem<Profiler>();
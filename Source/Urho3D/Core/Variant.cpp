@@ -573,15 +573,15 @@ void Variant::SetType(VariantType newType)
         break;
 
     case VAR_MATRIX3:
-        delete reinterpret_cast<Matrix3*>(value_.ptr_);
+        FreeMemory(value_.ptr_, sizeof(Matrix3));
         break;
 
     case VAR_MATRIX3X4:
-        delete reinterpret_cast<Matrix3x4*>(value_.ptr_);
+        FreeMemory(value_.ptr_, sizeof(Matrix3x4));
         break;
 
     case VAR_MATRIX4:
-        delete reinterpret_cast<Matrix4*>(value_.ptr_);
+        FreeMemory(value_.ptr_, sizeof(Matrix4));
         break;
 
     default:
@@ -625,15 +625,15 @@ void Variant::SetType(VariantType newType)
         break;
 
     case VAR_MATRIX3:
-        value_.ptr_ = new Matrix3();
+        value_.ptr_ = new(AllocateMemory(sizeof(Matrix3))) Matrix3();
         break;
 
     case VAR_MATRIX3X4:
-        value_.ptr_ = new Matrix3x4();
+        value_.ptr_ = new(AllocateMemory(sizeof(Matrix3x4))) Matrix3x4();
         break;
 
     case VAR_MATRIX4:
-        value_.ptr_ = new Matrix4();
+        value_.ptr_ = new(AllocateMemory(sizeof(Matrix4))) Matrix4();
         break;
 
     default:
@@ -741,6 +741,31 @@ template <> const Matrix4& Variant::Get<const Matrix4&>() const
     return GetMatrix4();
 }
 
+template <> const ResourceRef& Variant::Get<const ResourceRef&>() const
+{
+    return GetResourceRef();
+}
+
+template <> const ResourceRefList& Variant::Get<const ResourceRefList&>() const
+{
+    return GetResourceRefList();
+}
+
+template <> const VariantVector& Variant::Get<const VariantVector&>() const
+{
+    return GetVariantVector();
+}
+
+template <> const StringVector& Variant::Get<const StringVector&>() const
+{
+    return GetStringVector();
+}
+
+template <> const VariantMap& Variant::Get<const VariantMap&>() const
+{
+    return GetVariantMap();
+}
+
 template <> ResourceRef Variant::Get<ResourceRef>() const
 {
     return GetResourceRef();
@@ -1190,6 +1190,16 @@ template <> URHO3D_API const Matrix3x4& Variant::Get<const Matrix3x4&>() const;
 
 template <> URHO3D_API const Matrix4& Variant::Get<const Matrix4&>() const;
 
+template <> URHO3D_API const ResourceRef& Variant::Get<const ResourceRef&>() const;
+
+template <> URHO3D_API const ResourceRefList& Variant::Get<const ResourceRefList&>() const;
+
+template <> URHO3D_API const VariantVector& Variant::Get<const VariantVector&>() const;
+
+template <> URHO3D_API const StringVector& Variant::Get<const StringVector&>() const;
+
+template <> URHO3D_API const VariantMap& Variant::Get<const VariantMap&>() const;
+
 template <> URHO3D_API ResourceRef Variant::Get<ResourceRef>() const;
 
 template <> URHO3D_API ResourceRefList Variant::Get<ResourceRefList>() const;
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Atomic.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
@@ -31,6 +32,26 @@
 namespace Urho3D
 {
 
+/// Work item has not been added to the queue.
+static const int WORKITEM_IDLE = 0;
+/// Work item is waiting in a deque or for its dependencies.
+static const int WORKITEM_QUEUED = 1;
+/// Work item has been taken by a thread for execution.
+static const int WORKITEM_RUNNING = 2;
+/// Work item was removed while still referenced by a deque or a dependency.
+static const int WORKITEM_REMOVED = 3;
+/// Removed work item has been discarded from the deque by a thread and can be reused.
+static const int WORKITEM_DISCARDED = 4;
+
+/// Initial capacity of a work deque. Must be a power of two.
+static const unsigned WORK_DEQUE_INITIAL_SIZE = 64;
+/// Maximum number of work items per thread for parallel loops. More items balance the load better when the cost per element varies.
+static const unsigned PARALLEL_FOR_ITEMS_PER_THREAD = 4;
+/// Minimum measured duration of a parallel loop work item, to keep the scheduling overhead small.
+static const float PARALLEL_FOR_MIN_ITEM_USEC = 25.0f;
+/// Weight of the latest measurement in the smoothed cost per element.
+static const float PARALLEL_FOR_STATS_BLEND = 0.1f;
+
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
@@ -47,6 +68,11 @@ public:
     {
         // Init FPU state first
         InitFPU();
+#ifdef URHO3D_PROFILING
+        Profiler* profiler = owner_->GetSubsystem<Profiler>();
+        if (profiler)
+            profiler->SetThreadName("Worker " + String(index_));
+#endif
         owner_->ProcessItems(index_);
     }
 
@@ -60,8 +86,202 @@ private:
     unsigned index_;
 };
 
+/// Lock-free ring buffer of work item pointers. Pushed to only by the main thread, taken from by any thread.
+class WorkDeque
+{
+public:
+    /// Construct.
+    WorkDeque() :
+        head_(0),
+        tail_(0),
+        ring_(new Ring(WORK_DEQUE_INITIAL_SIZE))
+    {
+    }
+
+    /// Destruct.
+    ~WorkDeque()
+    {
+        delete ring_;
+        for (unsigned i = 0; i < retiredRings_.Size(); ++i)
+            delete retiredRings_[i];
+    }
+
+    /// Push a work item. Grow the ring if full. Called only by the main thread.
+    void Push(WorkItem* item)
+    {
+        unsigned tail = (unsigned)tail_;
+        unsigned head = (unsigned)AtomicLoad(head_);
+        Ring* ring = ring_;
+
+        if (tail - head > ring->mask_)
+        {
+            // Copy the live range to a larger ring. Threads may still be reading the old ring, so retire it instead
+            // of deleting. The same absolute index holds the same item in both rings
+            Ring* newRing = new Ring((ring->mask_ + 1) * 2);
+            for (unsigned i = head; i != tail; ++i)
+                newRing->items_[i & newRing->mask_] = ring->items_[i & ring->mask_];
+            retiredRings_.Push(ring);
+            AtomicStorePtr(ring_, newRing);
+            ring = newRing;
+        }
+
+        ring->items_[tail & ring->mask_] = item;
+        AtomicStore(tail_, (int)(tail + 1));
+    }
+
+    /// Take the oldest work item. Return null if empty. Can be called from any thread.
+    WorkItem* Take()
+    {
+        for (;;)
+        {
+            int head = AtomicLoad(head_);
+            int tail = AtomicLoad(tail_);
+            if ((int)((unsigned)tail - (unsigned)head) <= 0)
+                return 0;
+
+            // The slot may be overwritten after the head has moved on, in which case the exchange fails and the read is discarded
+            Ring* ring = AtomicLoadPtr(ring_);
+            WorkItem* item = ring->items_[(unsigned)head & ring->mask_];
+            if (AtomicCompareExchange(head_, head, (int)((unsigned)head + 1)))
+                return item;
+        }
+    }
+
+    /// Return whether is empty.
+    bool IsEmpty() const { return (int)((unsigned)AtomicLoad(tail_) - (unsigned)AtomicLoad(head_)) <= 0; }
+
+private:
+    /// Ring buffer storage.
+    struct Ring
+    {
+        /// Construct with power of two size.
+        Ring(unsigned size) :
+            mask_(size - 1),
+            items_(new WorkItem*[size])
+        {
+        }
+
+        /// Destruct.
+        ~Ring()
+        {
+            delete[] items_;
+        }
+
+        /// Index mask.
+        unsigned mask_;
+        /// Work item pointers.
+        WorkItem** items_;
+    };
+
+    /// Index of the next item to take. Advanced by any thread.
+    volatile int head_;
+    /// Padding to keep the consumer and producer indices on separate cache lines.
+    char padding_[64];
+    /// Index of the next free slot. Advanced only by the main thread.
+    volatile int tail_;
+    /// Current ring buffer.
+    Ring* volatile ring_;
+    /// Ring buffers replaced by growing, kept alive until destruction.
+    PODVector<Ring*> retiredRings_;
+};
+
+/// Work deques for one priority level. Each worker thread owns a deque filled by the main thread, and each thread including
+/// the main thread owns a deque for the work items it releases by finishing their last dependency.
+class WorkLane
+{
+public:
+    /// Construct with priority and number of worker threads.
+    WorkLane(unsigned priority, unsigned numThreads) :
+        priority_(priority),
+        waiting_(0)
+    {
+        SetNumThreads(numThreads);
+    }
+
+    /// Destruct.
+    ~WorkLane()
+    {
+        for (unsigned i = 0; i < deques_.Size(); ++i)
+            delete deques_[i];
+        for (unsigned i = 0; i < releaseDeques_.Size(); ++i)
+            delete releaseDeques_[i];
+    }
+
+    /// Add deques for the specified number of worker threads. Must not be called while worker threads are running.
+    void SetNumThreads(unsigned numThreads)
+    {
+        while (deques_.Size() < Max(numThreads, 1U))
+            deques_.Push(new WorkDeque());
+        while (releaseDeques_.Size() < numThreads + 1)
+            releaseDeques_.Push(new WorkDeque());
+    }
+
+    /// Take a work item, starting from the deques owned by the thread and stealing from the others. Return null if all are empty.
+    WorkItem* Take(unsigned threadIndex)
+    {
+        // Prefer the thread's own released items, as their dependencies' results are likely still in cache
+        WorkItem* item = releaseDeques_[threadIndex]->Take();
+        if (item)
+            return item;
+
+        unsigned numDeques = deques_.Size();
+        unsigned own = threadIndex ? (threadIndex - 1) % numDeques : 0;
+        for (unsigned i = 0; i < numDeques; ++i)
+        {
+            item = deques_[(own + i) % numDeques]->Take();
+            if (item)
+                return item;
+        }
+
+        unsigned numReleaseDeques = releaseDeques_.Size();
+        for (unsigned i = 1; i < numReleaseDeques; ++i)
+        {
+            item = releaseDeques_[(threadIndex + i) % numReleaseDeques]->Take();
+            if (item)
+                return item;
+        }
+
+        return 0;
+    }
+
+    /// Return whether all deques are empty.
+    bool IsEmpty() const
+    {
+        for (unsigned i = 0; i < deques_.Size(); ++i)
+        {
+            if (!deques_[i]->IsEmpty())
+                return false;
+        }
+        for (unsigned i = 0; i < releaseDeques_.Size(); ++i)
+        {
+            if (!releaseDeques_[i]->IsEmpty())
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Return whether all deques are empty and no work items are waiting for dependencies.
+    bool IsIdle() const
+    {
+        // Released items are pushed before the waiting count is decremented, so check the count first
+        return AtomicLoad(waiting_) == 0 && IsEmpty();
+    }
+
+    /// Priority of the work items in this lane. Written only by the main thread.
+    volatile unsigned priority_;
+    /// Number of work items waiting for dependencies that will be pushed to this lane.
+    volatile int waiting_;
+    /// Deques filled by the main thread, one per worker thread.
+    PODVector<WorkDeque*> deques_;
+    /// Deques filled by the thread that finishes the last dependency, one per thread including the main thread.
+    PODVector<WorkDeque*> releaseDeques_;
+};
+
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
+    numLanes_(0),
+    nextDeque_(0),
     shutDown_(false),
     pausing_(false),
     paused_(false),
@@ -81,6 +301,9 @@ WorkQueue::~WorkQueue()
 
     for (unsigned i = 0; i < threads_.Size(); ++i)
         threads_[i]->Stop();
+
+    for (int i = 0; i < numLanes_; ++i)
+        delete lanes_[i];
 }
 
 void WorkQueue::CreateThreads(unsigned numThreads)
@@ -94,6 +317,10 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     // Start threads in paused mode
     Pause();
 
+    // Give each thread its own deque in the lanes that already exist
+    for (int i = 0; i < numLanes_; ++i)
+        lanes_[i]->SetNumThreads(numThreads);
+
     for (unsigned i = 0; i < numThreads; ++i)
     {
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
@@ -138,30 +365,68 @@ void WorkQueue::AddWorkItem(SharedPtr<WorkItem> item)
     workItems_.Push(item);
     item->completed_ = false;
 
-    // Make sure worker threads' list is safe to modify
-    if (threads_.Size() && !paused_)
-        queueMutex_.Acquire();
-
-    // Find position for new item
-    if (queue_.Empty())
-        queue_.Push(item);
-    else
+    // If the item was removed but a deque still holds it, requeue it in place instead of pushing it twice
+    List<SharedPtr<WorkItem> >::Iterator i = removedItems_.Find(item);
+    if (i != removedItems_.End())
     {
-        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
+        removedItems_.Erase(i);
+        if (AtomicCompareExchange(item->state_, WORKITEM_REMOVED, WORKITEM_QUEUED))
         {
-            if ((*i)->priority_ <= item->priority_)
-            {
-                queue_.Insert(i, item);
-                break;
-            }
+            if (threads_.Size())
+                Resume();
+            return;
         }
+
+        // A thread has already discarded the deque entry. Only a pushed item can be discarded, so its dependencies
+        // have finished, and it can be queued anew like an unused item
+        ResetDependencies(item);
+    }
+
+    AtomicStore(item->state_, WORKITEM_QUEUED);
+
+    // If dependencies are still unfinished, the thread finishing the last one pushes the item. Register it to the lane
+    // first so that the lane can not be recycled meanwhile
+    WorkLane* lane = GetLane(item->priority_);
+    item->lane_ = lane;
+    AtomicAdd(lane->waiting_, 1);
+    if (AtomicAdd(item->pendingDependencies_, -1) == 0)
+    {
+        // Distribute the items round-robin to the worker threads' deques. Idle threads will steal from the others
+        lane->deques_[nextDeque_++ % lane->deques_.Size()]->Push(item);
+        AtomicAdd(lane->waiting_, -1);
     }
 
     if (threads_.Size())
+        Resume();
+}
+
+void WorkQueue::AddDependency(SharedPtr<WorkItem> item, SharedPtr<WorkItem> dependency)
+{
+    if (!item || !dependency || item == dependency)
+    {
+        URHO3D_LOGERROR("Null or self work item dependency");
+        return;
+    }
+
+    if (item->state_ != WORKITEM_IDLE)
+    {
+        URHO3D_LOGERROR("Dependencies must be added before the work item is added to the queue");
+        return;
+    }
+
+    // The dependency may be finishing in a worker thread right now. If it has already released its dependents, there is
+    // nothing to wait for
+    while (!AtomicCompareExchange(dependency->dependentsLock_, 0, 1))
     {
-        queueMutex_.Release();
-        paused_ = false;
     }
+
+    if (!dependency->dependentsClosed_)
+    {
+        dependency->dependents_.Push(item);
+        AtomicAdd(item->pendingDependencies_, 1);
+    }
+
+    AtomicStore(dependency->dependentsLock_, 0);
 }
 
 bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
@@ -169,20 +434,18 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
     if (!item)
         return false;
 
-    MutexLock lock(queueMutex_);
-
     // Can only remove successfully if the item was not yet taken by threads for execution
-    List<WorkItem*>::Iterator i = queue_.Find(item.Get());
-    if (i != queue_.End())
+    List<SharedPtr<WorkItem> >::Iterator i = workItems_.Find(item);
+    if (i != workItems_.End() && AtomicCompareExchange(item->state_, WORKITEM_QUEUED, WORKITEM_REMOVED))
     {
-        List<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(item);
-        if (j != workItems_.End())
-        {
-            queue_.Erase(i);
-            ReturnToPool(item);
-            workItems_.Erase(j);
-            return true;
-        }
+        // The deque or a dependency still refers to the item, so it can not be reused until a thread has discarded it.
+        // Discarding releases the dependents like finishing would, so remove them too as they would otherwise execute
+        // without their dependency's results
+        removedItems_.Push(item);
+        workItems_.Erase(i);
+        for (unsigned j = 0; j < item->dependents_.Size(); ++j)
+            RemoveWorkItem(item->dependents_[j]);
+        return true;
     }
 
     return false;
@@ -190,23 +453,12 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
 
 unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
 {
-    MutexLock lock(queueMutex_);
     unsigned removed = 0;
 
     for (Vector<SharedPtr<WorkItem> >::ConstIterator i = items.Begin(); i != items.End(); ++i)
     {
-        List<WorkItem*>::Iterator j = queue_.Find(i->Get());
-        if (j != queue_.End())
-        {
-            List<SharedPtr<WorkItem> >::Iterator k = workItems_.Find(*i);
-            if (k != workItems_.End())
-            {
-                queue_.Erase(j);
-                ReturnToPool(*k);
-                workItems_.Erase(k);
-                ++removed;
-            }
-        }
+        if (RemoveWorkItem(*i))
+            ++removed;
     }
 
     return removed;
@@ -229,8 +481,8 @@ void WorkQueue::Resume()
 {
     if (paused_)
     {
-        queueMutex_.Release();
         paused_ = false;
+        queueMutex_.Release();
     }
 }
 
@@ -240,51 +492,121 @@ void WorkQueue::Complete(unsigned priority)
     completing_ = true;
 
     if (threads_.Size())
-    {
         Resume();
 
-        // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.Empty())
-        {
-            queueMutex_.Acquire();
-            if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
-            {
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
-            }
-            else
-            {
-                queueMutex_.Release();
-                break;
-            }
-        }
+    // Take work items also in the main thread until queue empty or no high-priority items anymore
+    for (;;)
+    {
+        WorkItem* item = TakeItem(0, priority);
+        if (!item)
+            break;
+        ExecuteItem(item, 0);
+    }
 
+    if (threads_.Size())
+    {
         // Wait for threaded work to complete
         while (!IsCompleted(priority))
         {
         }
 
         // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.Empty())
+        if (IsQueueEmpty())
             Pause();
     }
-    else
+
+    PurgeCompleted(priority);
+    completing_ = false;
+}
+
+void WorkQueue::CompleteItems(const Vector<SharedPtr<WorkItem> >& items)
+{
+    if (items.Empty())
+        return;
+
+    // May be called while already completing, for example from a work function executing in the main thread
+    bool wasCompleting = completing_;
+    completing_ = true;
+
+    if (threads_.Size())
+        Resume();
+
+    unsigned priority = M_MAX_UNSIGNED;
+    for (unsigned i = 0; i < items.Size(); ++i)
+        priority = Min(priority, items[i]->priority_);
+
+    // Help in the main thread until the items have finished. Work of lower priority is left to the worker threads
+    unsigned numCompleted = 0;
+    while (numCompleted < items.Size())
     {
-        // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.Empty() && queue_.Front()->priority_ >= priority)
+        if (items[numCompleted]->completed_)
+        {
+            ++numCompleted;
+            continue;
+        }
+
+        WorkItem* item = TakeItem(0, priority);
+        // Without worker threads, the items may be waiting for a dependency of lower priority, which only the main thread
+        // can execute
+        if (!item && threads_.Empty())
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            item = TakeItem(0, 0);
+            // Nothing else can release the items, so they would never finish
+            assert(item);
+            if (!item)
+            {
+                URHO3D_LOGERROR("Work items can not be completed, as their dependencies have not been queued");
+                break;
+            }
         }
+        if (item)
+            ExecuteItem(item, 0);
     }
 
-    PurgeCompleted(priority);
-    completing_ = false;
+    if (threads_.Size() && IsQueueEmpty())
+        Pause();
+
+    for (unsigned i = 0; i < items.Size(); ++i)
+    {
+        if (!items[i]->completed_)
+            continue;
+        List<SharedPtr<WorkItem> >::Iterator j = workItems_.Find(items[i]);
+        if (j != workItems_.End())
+            PurgeItem(j);
+    }
+
+    completing_ = wasCompleting;
+}
+
+unsigned WorkQueue::GetNumParallelWorkItems(unsigned numElements, const ParallelForStats* stats) const
+{
+    if (!numElements)
+        return 0;
+    if (threads_.Empty())
+        return 1;
+
+    // Without a measurement, give each thread including the main thread one work item
+    unsigned numThreads = threads_.Size() + 1;
+    if (!stats || stats->usecPerElement_ <= 0.0f)
+        return Min(numElements, numThreads);
+
+    // Otherwise make the work items as small as possible for load balancing, but large enough to be worth scheduling
+    unsigned minElementsPerItem = Max((unsigned)(PARALLEL_FOR_MIN_ITEM_USEC / stats->usecPerElement_), 1U);
+    unsigned maxItems = Min(numThreads * PARALLEL_FOR_ITEMS_PER_THREAD, numElements);
+    return Clamp(numElements / minElementsPerItem, 1U, maxItems);
+}
+
+void WorkQueue::UpdateParallelForStats(ParallelForStats& stats, unsigned numElements, long long usec) const
+{
+    if (!numElements)
+        return;
+
+    // All threads including the main thread were busy for the duration, so this overestimates rather than underestimates
+    float usecPerElement = (float)usec * (threads_.Size() + 1) / numElements;
+    if (stats.usecPerElement_ > 0.0f)
+        stats.usecPerElement_ = Lerp(stats.usecPerElement_, usecPerElement, PARALLEL_FOR_STATS_BLEND);
+    else
+        stats.usecPerElement_ = usecPerElement;
 }
 
 bool WorkQueue::IsCompleted(unsigned priority) const
@@ -309,30 +631,155 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
 
         if (pausing_ && !wasActive)
             Time::Sleep(0);
-        else
+        else if (paused_)
         {
+            // Block until resumed
             queueMutex_.Acquire();
-            if (!queue_.Empty())
+            queueMutex_.Release();
+        }
+        else
+        {
+            WorkItem* item = TakeItem(threadIndex, 0);
+            if (item)
             {
                 wasActive = true;
-
-                WorkItem* item = queue_.Front();
-                queue_.PopFront();
-                queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
+                ExecuteItem(item, threadIndex);
             }
             else
             {
                 wasActive = false;
-
-                queueMutex_.Release();
                 Time::Sleep(0);
             }
         }
     }
 }
 
+WorkItem* WorkQueue::TakeItem(unsigned threadIndex, unsigned priority)
+{
+    for (;;)
+    {
+        // Find the highest priority lane with queued items
+        int numLanes = AtomicLoad(numLanes_);
+        WorkLane* best = 0;
+        unsigned bestPriority = 0;
+
+        for (int i = 0; i < numLanes; ++i)
+        {
+            WorkLane* lane = lanes_[i];
+            unsigned lanePriority = lane->priority_;
+            if (lanePriority >= priority && (!best || lanePriority > bestPriority) && !lane->IsEmpty())
+            {
+                best = lane;
+                bestPriority = lanePriority;
+            }
+        }
+
+        if (!best)
+            return 0;
+
+        WorkItem* item = best->Take(threadIndex);
+        if (!item)
+            continue;
+
+        if (AtomicCompareExchange(item->state_, WORKITEM_QUEUED, WORKITEM_RUNNING))
+            return item;
+
+        // The item was removed after being queued. Let the main thread know the deque no longer refers to it
+        ReleaseDependents(item, threadIndex);
+        AtomicStore(item->state_, WORKITEM_DISCARDED);
+    }
+}
+
+void WorkQueue::ExecuteItem(WorkItem* item, unsigned threadIndex)
+{
+    {
+        URHO3D_PROFILE(ExecuteWorkItem);
+        item->workFunction_(item, threadIndex);
+    }
+    ReleaseDependents(item, threadIndex);
+    // Make the results visible before flagging completion
+    AtomicFence();
+    item->completed_ = true;
+}
+
+void WorkQueue::ReleaseDependents(WorkItem* item, unsigned threadIndex)
+{
+    // After closing, the main thread no longer modifies the dependents list
+    while (!AtomicCompareExchange(item->dependentsLock_, 0, 1))
+    {
+    }
+    item->dependentsClosed_ = true;
+    AtomicStore(item->dependentsLock_, 0);
+
+    for (unsigned i = 0; i < item->dependents_.Size(); ++i)
+    {
+        WorkItem* dependent = item->dependents_[i].Get();
+        if (AtomicAdd(dependent->pendingDependencies_, -1) == 0)
+        {
+            WorkLane* lane = dependent->lane_;
+            lane->releaseDeques_[threadIndex]->Push(dependent);
+            AtomicAdd(lane->waiting_, -1);
+        }
+    }
+}
+
+void WorkQueue::ResetDependencies(WorkItem* item)
+{
+    item->dependents_.Clear();
+    item->dependentsClosed_ = false;
+    item->pendingDependencies_ = 1;
+    item->lane_ = 0;
+    item->state_ = WORKITEM_IDLE;
+}
+
+WorkLane* WorkQueue::GetLane(unsigned priority)
+{
+    for (;;)
+    {
+        for (int i = 0; i < numLanes_; ++i)
+        {
+            if (lanes_[i]->priority_ == priority)
+                return lanes_[i];
+        }
+
+        if (numLanes_ < (int)MAX_WORK_LANES)
+        {
+            lanes_[numLanes_] = new WorkLane(priority, Max(threads_.Size(), 1U));
+            AtomicStore(numLanes_, numLanes_ + 1);
+            return lanes_[numLanes_ - 1];
+        }
+
+        // All lanes in use: recycle an idle one. Threads holding a stale priority value are harmless, as they will
+        // only take the items of the recycled lane in a slightly wrong order
+        for (int i = 0; i < numLanes_; ++i)
+        {
+            if (lanes_[i]->IsIdle())
+            {
+                lanes_[i]->priority_ = priority;
+                AtomicFence();
+                return lanes_[i];
+            }
+        }
+
+        // No empty lanes either: help complete queued work in the main thread until one frees up
+        WorkItem* item = TakeItem(0, 0);
+        if (item)
+            ExecuteItem(item, 0);
+    }
+}
+
+bool WorkQueue::IsQueueEmpty() const
+{
+    int numLanes = AtomicLoad(numLanes_);
+    for (int i = 0; i < numLanes; ++i)
+    {
+        if (!lanes_[i]->IsIdle())
+            return false;
+    }
+
+    return true;
+}
+
 void WorkQueue::PurgeCompleted(unsigned priority)
 {
     // Purge completed work items and send completion events. Do not signal items lower than priority threshold,
@@ -341,24 +788,41 @@ void WorkQueue::PurgeCompleted(unsigned priority)
     for (List<SharedPtr<WorkItem> >::Iterator i = workItems_.Begin(); i != workItems_.End();)
     {
         if ((*i)->completed_ && (*i)->priority_ >= priority)
-        {
-            if ((*i)->sendEvent_)
-            {
-                using namespace WorkItemCompleted;
-
-                VariantMap& eventData = GetEventDataMap();
-                eventData[P_ITEM] = i->Get();
-                SendEvent(E_WORKITEMCOMPLETED, eventData);
-            }
+            i = PurgeItem(i);
+        else
+            ++i;
+    }
 
+    // Return removed items to the pool once the deques no longer refer to them
+    for (List<SharedPtr<WorkItem> >::Iterator i = removedItems_.Begin(); i != removedItems_.End();)
+    {
+        if (AtomicLoad((*i)->state_) == WORKITEM_DISCARDED)
+        {
+            ResetDependencies(*i);
             ReturnToPool(*i);
-            i = workItems_.Erase(i);
+            i = removedItems_.Erase(i);
         }
         else
             ++i;
     }
 }
 
+List<SharedPtr<WorkItem> >::Iterator WorkQueue::PurgeItem(List<SharedPtr<WorkItem> >::Iterator i)
+{
+    if ((*i)->sendEvent_)
+    {
+        using namespace WorkItemCompleted;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_ITEM] = i->Get();
+        SendEvent(E_WORKITEMCOMPLETED, eventData);
+    }
+
+    ResetDependencies(*i);
+    ReturnToPool(*i);
+    return workItems_.Erase(i);
+}
+
 void WorkQueue::PurgePool()
 {
     unsigned currentSize = poolItems_.Size();
@@ -395,18 +859,18 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.Empty() && !queue_.Empty())
+    if (threads_.Empty() && !IsQueueEmpty())
     {
         URHO3D_PROFILE(CompleteWorkNonthreaded);
 
         HiresTimer timer;
 
-        while (!queue_.Empty() && timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000)
+        while (timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = TakeItem(0, 0);
+            if (!item)
+                break;
+            ExecuteItem(item, 0);
         }
     }
 
@@ -25,6 +25,7 @@
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
+#include "../Core/Timer.h"
 
 namespace Urho3D
 {
@@ -36,6 +37,10 @@ URHO3D_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 }
 
 class WorkerThread;
+class WorkLane;
+
+/// Maximum number of distinct work item priorities that can be queued simultaneously.
+static const unsigned MAX_WORK_LANES = 16;
 
 /// Work queue item.
 struct WorkItem : public RefCounted
@@ -48,7 +53,12 @@ public:
         priority_(0),
         sendEvent_(false),
         completed_(false),
-        pooled_(false)
+        pooled_(false),
+        state_(0),
+        pendingDependencies_(1),
+        dependentsLock_(0),
+        dependentsClosed_(false),
+        lane_(0)
     {
     }
 
@@ -68,7 +78,33 @@ public:
     volatile bool completed_;
 
 private:
+    /// Pooled flag.
     bool pooled_;
+    /// Queue state, used to claim the item from the lock-free work deques.
+    volatile int state_;
+    /// Number of unfinished dependencies, plus one until the item has been added to the queue.
+    volatile int pendingDependencies_;
+    /// Work items waiting for this item to finish.
+    Vector<SharedPtr<WorkItem> > dependents_;
+    /// Spin lock for adding dependents while the item may be finishing in another thread.
+    volatile int dependentsLock_;
+    /// Whether the item has finished and released its dependents. No more dependents can be added.
+    bool dependentsClosed_;
+    /// Lane the item will be pushed to when its dependencies finish.
+    WorkLane* lane_;
+};
+
+/// Adaptive chunking state for parallel loops. Keep one per call site so that the measured cost per element carries over between calls.
+struct ParallelForStats
+{
+    /// Construct.
+    ParallelForStats() :
+        usecPerElement_(0.0f)
+    {
+    }
+
+    /// Smoothed cost of processing one element in microseconds. Zero until measured.
+    float usecPerElement_;
 };
 
 /// Work queue subsystem for multithreading.
@@ -88,9 +124,11 @@ public:
     void CreateThreads(unsigned numThreads);
     /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
     SharedPtr<WorkItem> GetFreeItem();
-    /// Add a work item and resume worker threads.
+    /// Add a work item and resume worker threads. If the item has dependencies, it is held back until they have finished.
     void AddWorkItem(SharedPtr<WorkItem> item);
-    /// Remove a work item before it has started executing. Return true if successfully removed.
+    /// Make a work item wait for another to finish before it can execute. Must be called before the item is added to the queue, but the dependency may already be queued or executing.
+    void AddDependency(SharedPtr<WorkItem> item, SharedPtr<WorkItem> dependency);
+    /// Remove a work item before it has started executing. Work items depending on it are removed as well. Return true if successfully removed.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
     unsigned RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items);
@@ -100,6 +138,61 @@ public:
     void Resume();
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
+    /// Finish the specified work items and return them to the pool, without waiting for other work. Main thread will also execute work with at least the items' priority, or any work if there are no worker threads. The items must not be removed.
+    void CompleteItems(const Vector<SharedPtr<WorkItem> >& items);
+
+    /// Split a range of elements into work items for the worker threads and the main thread and add them without waiting for completion. The work function receives each sub-range in start_ and end_. The number of work items adapts to the thread count and to the cost per element measured in stats, if given. The added items are appended to addedItems, if given. Return the number of work items added.
+    template <class T> unsigned AddParallelWorkItems(RandomAccessIterator<T> start, RandomAccessIterator<T> end, void (* workFunction)(const WorkItem*, unsigned), void* aux,
+        const ParallelForStats* stats = 0, unsigned priority = M_MAX_UNSIGNED, Vector<SharedPtr<WorkItem> >* addedItems = 0)
+    {
+        unsigned numElements = (unsigned)(end - start);
+        unsigned numItems = GetNumParallelWorkItems(numElements, stats);
+        if (!numItems)
+            return 0;
+
+        // Spread the remainder so that the work item sizes differ by at most one element
+        unsigned elementsPerItem = numElements / numItems;
+        unsigned remainder = numElements % numItems;
+        for (unsigned i = 0; i < numItems; ++i)
+        {
+            RandomAccessIterator<T> itemEnd = start + (elementsPerItem + (i < remainder ? 1 : 0));
+
+            SharedPtr<WorkItem> item = GetFreeItem();
+            item->priority_ = priority;
+            item->workFunction_ = workFunction;
+            item->aux_ = aux;
+            item->start_ = start.ptr_;
+            item->end_ = itemEnd.ptr_;
+            AddWorkItem(item);
+            if (addedItems)
+                addedItems->Push(item);
+
+            start = itemEnd;
+        }
+
+        return numItems;
+    }
+
+    /// Execute a work function over a range of elements in parallel and wait for completion of its own work items. The work function receives each sub-range in start_ and end_. If stats is given, the cost per element is measured to size the work items on subsequent calls.
+    template <class T> void ParallelFor(RandomAccessIterator<T> start, RandomAccessIterator<T> end, void (* workFunction)(const WorkItem*, unsigned), void* aux,
+        ParallelForStats* stats = 0, unsigned priority = M_MAX_UNSIGNED)
+    {
+        HiresTimer timer;
+        Vector<SharedPtr<WorkItem> > items;
+        if (AddParallelWorkItems(start, end, workFunction, aux, stats, priority, &items))
+            CompleteItems(items);
+        if (stats)
+            UpdateParallelForStats(*stats, (unsigned)(end - start), timer.GetUSec(false));
+    }
+
+    /// Execute a work function over a range of elements in parallel like ParallelFor(). The work function accumulates into the element of threadResults matching its thread index, which the caller must have sized to the number of threads plus one and reset. Afterward combine the per-thread results into the first element.
+    template <class T, class R> void ParallelReduce(RandomAccessIterator<T> start, RandomAccessIterator<T> end, void (* workFunction)(const WorkItem*, unsigned), void* aux,
+        Vector<R>& threadResults, void (* combine)(R&, const R&), ParallelForStats* stats = 0, unsigned priority = M_MAX_UNSIGNED)
+    {
+        ParallelFor(start, end, workFunction, aux, stats, priority);
+        for (unsigned i = 1; i < threadResults.Size(); ++i)
+            combine(threadResults[0], threadResults[i]);
+    }
 
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
@@ -110,6 +203,8 @@ public:
     /// Return number of worker threads.
     unsigned GetNumThreads() const { return threads_.Size(); }
 
+    /// Return the number of work items a parallel loop over the specified number of elements will be split into.
+    unsigned GetNumParallelWorkItems(unsigned numElements, const ParallelForStats* stats = 0) const;
     /// Return whether all work with at least the specified priority is finished.
     bool IsCompleted(unsigned priority) const;
     /// Return whether the queue is currently completing work in the main thread.
@@ -124,8 +219,24 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Take the highest priority queued item which has at least the specified priority. Take first from the thread's own deque, then steal from the others. Return null if none.
+    WorkItem* TakeItem(unsigned threadIndex, unsigned priority);
+    /// Execute a taken work item, release its dependents and flag it completed.
+    void ExecuteItem(WorkItem* item, unsigned threadIndex);
+    /// Close the dependents list of a finished or discarded work item and queue the dependents that have no unfinished dependencies left.
+    void ReleaseDependents(WorkItem* item, unsigned threadIndex);
+    /// Reset the dependency state of a work item that has left the queue. Called only by the main thread.
+    void ResetDependencies(WorkItem* item);
+    /// Return the lane for a priority, creating or recycling a lane if necessary. Called only by the main thread.
+    WorkLane* GetLane(unsigned priority);
+    /// Return whether no work items are waiting in the deques or for their dependencies.
+    bool IsQueueEmpty() const;
+    /// Update the measured cost per element of a parallel loop from its total duration.
+    void UpdateParallelForStats(ParallelForStats& stats, unsigned numElements, long long usec) const;
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
+    /// Send the completion event of a work item if necessary, return it to the pool and erase it from the work item collection. Return the next iterator.
+    List<SharedPtr<WorkItem> >::Iterator PurgeItem(List<SharedPtr<WorkItem> >::Iterator i);
     /// Purge the pool to reduce allocation where its unneeded.
     void PurgePool();
     /// Return a work item to the pool.
@@ -139,16 +250,22 @@ private:
     List<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
     List<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems.)
-    List<WorkItem*> queue_;
-    /// Worker queue mutex.
+    /// Removed work items that may still be referenced by the deques. Returned to the pool once a thread has discarded them. Accessed only by the main thread.
+    List<SharedPtr<WorkItem> > removedItems_;
+    /// Priority lanes, each holding a lock-free work deque per worker thread. Queued pointers are guaranteed to be valid (point to workItems or removedItems.)
+    WorkLane* lanes_[MAX_WORK_LANES];
+    /// Number of lanes in use.
+    volatile int numLanes_;
+    /// Deque index to push the next work item to.
+    unsigned nextDeque_;
+    /// Pause mutex. Worker threads only contend for it while the queue is paused.
     Mutex queueMutex_;
     /// Shutting down flag.
     volatile bool shutDown_;
     /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
     volatile bool pausing_;
     /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
-    bool paused_;
+    volatile bool paused_;
     /// Completing work in the main thread flag.
     bool completing_;
     /// Tolerance for the shared pool before it begins to deallocate.
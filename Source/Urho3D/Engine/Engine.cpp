@@ -25,6 +25,7 @@
 #include "../Audio/Audio.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/FrameAllocator.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
 #include "../Core/WorkQueue.h"
@@ -115,6 +116,7 @@ Engine::Engine(Context* context) :
     // Create subsystems which do not depend on engine initialization or startup parameters
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
+    context_->RegisterSubsystem(new FrameAllocator(context_));
 #ifdef URHO3D_PROFILING
     context_->RegisterSubsystem(new Profiler(context_));
 #endif
@@ -203,6 +205,7 @@ bool Engine::Initialize(const VariantMap& parameters)
     if (numThreads)
     {
         GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+        GetSubsystem<FrameAllocator>()->SetNumThreads(numThreads + 1);
 
         URHO3D_LOGINFOF("Created %u worker thread%s", numThreads, numThreads > 1 ? "s" : "");
     }
@@ -447,6 +450,7 @@ void Engine::RunFrame()
     Audio* audio = GetSubsystem<Audio>();
 
     time->BeginFrame(timeStep_);
+    context_->SendPostedEvents();
 
     // If pause when minimized -mode is in use, stop updates and audio as necessary
     if (pauseMinimized_ && input->IsMinimized())
@@ -634,20 +638,24 @@ void Engine::Update()
     URHO3D_PROFILE(Update);
 
     // Logic update event
-    using namespace Update;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_TIMESTEP] = timeStep_;
-    SendEvent(E_UPDATE, eventData);
+    Update::Data updateData;
+    updateData.timeStep_ = timeStep_;
+    SendTypedEvent(updateData);
 
     // Logic post-update event
-    SendEvent(E_POSTUPDATE, eventData);
+    PostUpdate::Data postUpdateData;
+    postUpdateData.timeStep_ = timeStep_;
+    SendTypedEvent(postUpdateData);
 
     // Rendering update event
-    SendEvent(E_RENDERUPDATE, eventData);
+    RenderUpdate::Data renderUpdateData;
+    renderUpdateData.timeStep_ = timeStep_;
+    SendTypedEvent(renderUpdateData);
 
     // Post-render update event
-    SendEvent(E_POSTRENDERUPDATE, eventData);
+    PostRenderUpdate::Data postRenderUpdateData;
+    postRenderUpdateData.timeStep_ = timeStep_;
+    SendTypedEvent(postRenderUpdateData);
 }
 
 void Engine::Render()
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/SmallVector.h"
 #include "../Graphics/Model.h"
 #include "../Graphics/Skeleton.h"
 #include "../Graphics/StaticModel.h"
@@ -221,8 +222,8 @@ private:
     Vector<PODVector<unsigned> > geometryBoneMappings_;
     /// Subgeometry skinning matrices, used if more bones than skinning shader can manage.
     Vector<PODVector<Matrix3x4> > geometrySkinMatrices_;
-    /// Subgeometry skinning matrix pointers, if more bones than skinning shader can manage.
-    Vector<PODVector<Matrix3x4*> > geometrySkinMatrixPtrs_;
+    /// Subgeometry skinning matrix pointers, if more bones than skinning shader can manage. A bone is usually shared by only a few subgeometries.
+    Vector<SmallVector<Matrix3x4*, 2> > geometrySkinMatrixPtrs_;
     /// Bounding box calculated from bones.
     BoundingBox boneBoundingBox_;
     /// Attribute buffer.
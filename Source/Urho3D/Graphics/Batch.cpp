@@ -80,6 +80,118 @@ inline bool CompareBatchGroupOrder(BatchGroup* lhs, BatchGroup* rhs)
     return lhs->renderOrder_ < rhs->renderOrder_;
 }
 
+/// Batch count from which the batch sorts switch from comparison sort to radix sort.
+static const unsigned MIN_RADIX_SORT_BATCHES = 512;
+
+/// Batch sort order.
+enum BatchSortOrder
+{
+    BATCH_SORT_STATE = 0,
+    BATCH_SORT_FRONT_TO_BACK,
+    BATCH_SORT_BACK_TO_FRONT
+};
+
+/// Convert a float to an unsigned integer with the same order.
+inline unsigned long long GetFloatSortKey(float value)
+{
+    union
+    {
+        float f;
+        unsigned u;
+    } bits;
+    bits.f = value;
+    // Negative zero compares equal to zero, so must get the same key
+    if (!(bits.u & 0x7fffffff))
+        bits.u = 0;
+    return (bits.u & 0x80000000) ? ~bits.u : (bits.u | 0x80000000);
+}
+
+/// Sort batches by least significant digit radix sort of their keys, skipping the bytes that are the same for all batches.
+static void RadixSortBatches(PODVector<Batch*>& batches, PODVector<BatchSortKey>& keys, PODVector<BatchSortKey>& temp,
+    BatchSortOrder order)
+{
+    unsigned numBatches = batches.Size();
+    keys.Resize(numBatches);
+    temp.Resize(numBatches);
+
+    // Build the keys from render order, distance and state. The distance and state fields are ordered by precedence
+    BatchSortKey* src = &keys[0];
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        Batch* batch = batches[i];
+        unsigned long long renderOrder = batch->renderOrder_;
+        unsigned long long distance = GetFloatSortKey(batch->distance_);
+        unsigned long long sortKey = batch->sortKey_;
+        BatchSortKey& key = src[i];
+        key.batch_ = batch;
+
+        switch (order)
+        {
+        case BATCH_SORT_STATE:
+            key.high_ = (renderOrder << 56) | (sortKey >> 8);
+            key.low_ = (sortKey << 56) | (distance << 24);
+            break;
+
+        case BATCH_SORT_FRONT_TO_BACK:
+            key.high_ = (renderOrder << 56) | (distance << 24) | (sortKey >> 40);
+            key.low_ = sortKey << 24;
+            break;
+
+        case BATCH_SORT_BACK_TO_FRONT:
+            key.high_ = (renderOrder << 56) | ((distance ^ 0xffffffff) << 24) | (sortKey >> 40);
+            key.low_ = sortKey << 24;
+            break;
+        }
+    }
+
+    unsigned counts[16][256];
+    memset(counts, 0, sizeof counts);
+    for (unsigned i = 0; i < numBatches; ++i)
+    {
+        unsigned long long low = src[i].low_;
+        unsigned long long high = src[i].high_;
+        for (unsigned j = 0; j < 8; ++j)
+        {
+            ++counts[j][(low >> (j * 8)) & 0xff];
+            ++counts[j + 8][(high >> (j * 8)) & 0xff];
+        }
+    }
+
+    BatchSortKey* dest = &temp[0];
+    for (unsigned j = 0; j < 16; ++j)
+    {
+        unsigned* count = counts[j];
+        unsigned long long word = j < 8 ? src[0].low_ : src[0].high_;
+        unsigned shift = (j & 7) * 8;
+        if (count[(word >> shift) & 0xff] == numBatches)
+            continue;
+
+        unsigned offset = 0;
+        for (unsigned k = 0; k < 256; ++k)
+        {
+            unsigned num = count[k];
+            count[k] = offset;
+            offset += num;
+        }
+
+        if (j < 8)
+        {
+            for (unsigned i = 0; i < numBatches; ++i)
+                dest[count[(src[i].low_ >> shift) & 0xff]++] = src[i];
+        }
+        else
+        {
+            for (unsigned i = 0; i < numBatches; ++i)
+                dest[count[(src[i].high_ >> shift) & 0xff]++] = src[i];
+        }
+
+        Swap(src, dest);
+    }
+
+    for (unsigned i = 0; i < numBatches; ++i)
+        batches[i] = src[i].batch_;
+}
+
 void CalculateShadowMatrix(Matrix4& dest, LightBatchQueue* queue, unsigned split, Renderer* renderer, const Vector3& translation)
 {
     Camera* shadowCamera = queue->shadowSplits_[split].shadowCamera_;
@@ -513,7 +625,7 @@ void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool all
                  graphics->NeedParameterUpdate(SP_LIGHT, lightQueue_))
         {
             Vector4 vertexLights[MAX_VERTEX_LIGHTS * 3];
-            const PODVector<Light*>& lights = lightQueue_->vertexLights_;
+            const DrawableLights& lights = lightQueue_->vertexLights_;
 
             for (unsigned i = 0; i < lights.Size(); ++i)
             {
@@ -699,7 +811,10 @@ void BatchQueue::SortBackToFront()
     for (unsigned i = 0; i < batches_.Size(); ++i)
         sortedBatches_[i] = &batches_[i];
 
-    Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    if (sortedBatches_.Size() >= MIN_RADIX_SORT_BATCHES)
+        RadixSortBatches(sortedBatches_, sortKeys_, sortKeysTemp_, BATCH_SORT_BACK_TO_FRONT);
+    else
+        Sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
 
     sortedBatchGroups_.Resize(batchGroups_.Size());
     
@@ -731,7 +846,7 @@ void BatchQueue::SortFrontToBack()
         else
         {
             float minDistance = M_INFINITY;
-            for (PODVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
+            for (FrameVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
                 minDistance = Min(minDistance, j->distance_);
             i->second_.distance_ = minDistance;
         }
@@ -751,10 +866,17 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
     // Mobile devices likely use a tiled deferred approach, with which front-to-back sorting is irrelevant. The 2-pass
     // method is also time consuming, so just sort with state having priority
 #ifdef GL_ES_VERSION_2_0
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    if (batches.Size() >= MIN_RADIX_SORT_BATCHES)
+        RadixSortBatches(batches, sortKeys_, sortKeysTemp_, BATCH_SORT_STATE);
+    else
+        Sort(batches.Begin(), batches.End(), CompareBatchesState);
 #else
     // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+    bool useRadixSort = batches.Size() >= MIN_RADIX_SORT_BATCHES;
+    if (useRadixSort)
+        RadixSortBatches(batches, sortKeys_, sortKeysTemp_, BATCH_SORT_FRONT_TO_BACK);
+    else
+        Sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
 
     unsigned freeShaderID = 0;
     unsigned short freeMaterialID = 0;
@@ -802,7 +924,10 @@ void BatchQueue::SortFrontToBack2Pass(PODVector<Batch*>& batches)
     geometryRemapping_.Clear();
 
     // Finally sort again with the rewritten ID's
-    Sort(batches.Begin(), batches.End(), CompareBatchesState);
+    if (useRadixSort)
+        RadixSortBatches(batches, sortKeys_, sortKeysTemp_, BATCH_SORT_STATE);
+    else
+        Sort(batches.Begin(), batches.End(), CompareBatchesState);
 #endif
 }
 
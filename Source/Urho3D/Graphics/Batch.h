@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Container/Ptr.h"
+#include "../Core/FrameAllocator.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Material.h"
 #include "../Math/MathDefs.h"
@@ -168,8 +169,8 @@ struct BatchGroup : public Batch
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
 
-    /// Instance data.
-    PODVector<InstanceData> instances_;
+    /// Instance data. Allocated from the frame allocator.
+    FrameVector<InstanceData> instances_;
     /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
     unsigned startIndex_;
 };
@@ -224,6 +225,17 @@ struct BatchGroupKey
     unsigned ToHash() const;
 };
 
+/// %Batch pointer with a 128-bit key for radix sorting. Compared as unsigned integers, the keys order the batches like the comparison sort.
+struct BatchSortKey
+{
+    /// High 64 bits of the key.
+    unsigned long long high_;
+    /// Low 64 bits of the key.
+    unsigned long long low_;
+    /// %Batch.
+    Batch* batch_;
+};
+
 /// Queue that contains both instanced and non-instanced draw calls.
 struct BatchQueue
 {
@@ -261,6 +273,10 @@ public:
     PODVector<Batch*> sortedBatches_;
     /// Sorted instanced draw calls.
     PODVector<BatchGroup*> sortedBatchGroups_;
+    /// Radix sort keys.
+    PODVector<BatchSortKey> sortKeys_;
+    /// Radix sort scratch buffer.
+    PODVector<BatchSortKey> sortKeysTemp_;
     /// Maximum sorted instances.
     unsigned maxSortedInstances_;
 };
@@ -296,7 +312,7 @@ struct LightBatchQueue
     /// Shadow map split queues.
     Vector<ShadowBatchQueue> shadowSplits_;
     /// Per-vertex lights.
-    PODVector<Light*> vertexLights_;
+    DrawableLights vertexLights_;
     /// Light volume draw calls.
     PODVector<Batch> volumeBatches_;
 };
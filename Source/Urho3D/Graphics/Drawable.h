@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/SmallVector.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Math/BoundingBox.h"
 #include "../Scene/Component.h"
@@ -53,6 +54,9 @@ class Zone;
 struct RayQueryResult;
 struct WorkItem;
 
+/// Per-drawable light list. Stores a few lights without dynamic allocation.
+typedef SmallVector<Light*, MAX_VERTEX_LIGHTS> DrawableLights;
+
 /// Geometry update type.
 enum UpdateGeometryType
 {
@@ -108,6 +112,7 @@ class URHO3D_API Drawable : public Component
 
     friend class Octant;
     friend class Octree;
+    friend class SpatialIndex;
     friend void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex);
 
 public:
@@ -267,10 +272,10 @@ public:
     bool HasBasePass(unsigned batchIndex) const { return (basePassFlags_ & (1 << batchIndex)) != 0; }
 
     /// Return per-pixel lights.
-    const PODVector<Light*>& GetLights() const { return lights_; }
+    const DrawableLights& GetLights() const { return lights_; }
 
     /// Return per-vertex lights.
-    const PODVector<Light*>& GetVertexLights() const { return vertexLights_; }
+    const DrawableLights& GetVertexLights() const { return vertexLights_; }
 
     /// Return the first added per-pixel light.
     Light* GetFirstLight() const { return firstLight_; }
@@ -342,6 +347,10 @@ protected:
     bool zoneDirty_;
     /// Octree octant.
     Octant* octant_;
+    /// Index in the octant's drawables.
+    unsigned octantIndex_;
+    /// Proxy in the octree's spatial index, if one is used instead of the octants.
+    unsigned spatialIndexProxy_;
     /// Current zone.
     Zone* zone_;
     /// View mask.
@@ -379,9 +388,9 @@ protected:
     /// First per-pixel light added this frame.
     Light* firstLight_;
     /// Per-pixel lights affecting this drawable.
-    PODVector<Light*> lights_;
+    DrawableLights lights_;
     /// Per-vertex lights affecting this drawable.
-    PODVector<Light*> vertexLights_;
+    DrawableLights vertexLights_;
 };
 
 inline bool CompareDrawables(Drawable* lhs, Drawable* rhs)
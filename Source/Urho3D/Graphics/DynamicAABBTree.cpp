@@ -0,0 +1,533 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/DebugRenderer.h"
+#include "../Graphics/DynamicAABBTree.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned NO_NODE = M_MAX_UNSIGNED;
+/// Multiplier for the drawable object's movement since the last update when enlarging its leaf box towards the predicted positions.
+static const float DISPLACEMENT_MULTIPLIER = 8.0f;
+/// Multiplier for the margin after which a leaf box that has grown from earlier movement is shrunk.
+static const float SHRINK_MARGIN_MULTIPLIER = 4.0f;
+
+/// Tree rotation. B and C are the children of the rotated node, D and E the children of B, and F and G the children of C.
+enum RotationType
+{
+    ROTATE_BF = 0,
+    ROTATE_BG,
+    ROTATE_CD,
+    ROTATE_CE,
+    ROTATE_NONE
+};
+
+static inline float GetSurfaceArea(const BoundingBox& box)
+{
+    Vector3 size = box.Size();
+    return size.x_ * size.y_ + size.y_ * size.z_ + size.z_ * size.x_;
+}
+
+static inline float GetLargestDimension(const BoundingBox& box)
+{
+    Vector3 size = box.Size();
+    return Max(Max(size.x_, size.y_), size.z_);
+}
+
+static inline BoundingBox CombineBoxes(const BoundingBox& lhs, const BoundingBox& rhs)
+{
+    BoundingBox ret(lhs);
+    ret.Merge(rhs);
+    return ret;
+}
+
+DynamicAABBTree::DynamicAABBTree(float margin) :
+    root_(NO_NODE),
+    freeNode_(NO_NODE),
+    margin_(margin)
+{
+}
+
+DynamicAABBTree::~DynamicAABBTree()
+{
+}
+
+void DynamicAABBTree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
+{
+    if (debug && root_ != NO_NODE)
+        DrawDebugGeometry(root_, debug, depthTest);
+}
+
+void DynamicAABBTree::InsertProxy(Drawable* drawable)
+{
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+    unsigned leaf = AllocateNode();
+    AABBTreeNode& node = nodes_[leaf];
+    node.box_ = GetLeafBox(box, Vector3::ZERO);
+    node.center_ = box.Center();
+    node.drawable_ = drawable;
+
+    SetProxy(drawable, leaf);
+    InsertLeaf(leaf, root_);
+}
+
+void DynamicAABBTree::RemoveProxy(Drawable* drawable)
+{
+    unsigned leaf = GetProxy(drawable);
+    RemoveLeaf(leaf);
+    FreeNode(leaf);
+}
+
+void DynamicAABBTree::UpdateProxy(Drawable* drawable)
+{
+    unsigned leaf = GetProxy(drawable);
+    AABBTreeNode& node = nodes_[leaf];
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+    Vector3 center = box.Center();
+    Vector3 displacement = center - node.center_;
+    BoundingBox leafBox = GetLeafBox(box, displacement);
+    node.center_ = center;
+
+    // Keep the leaf if its box still contains the drawable and has not grown too large from earlier movement. The allowed
+    // growth includes the predicted movement, so that steadily moving drawables are not reinserted for the box they leave behind
+    if (node.box_.IsInside(box) == INSIDE)
+    {
+        float shrinkDistance = SHRINK_MARGIN_MULTIPLIER * (margin_ * GetLargestDimension(box) + DISPLACEMENT_MULTIPLIER *
+            displacement.Length());
+        Vector3 shrinkMargin(Vector3::ONE * shrinkDistance);
+        if (BoundingBox(leafBox.min_ - shrinkMargin, leafBox.max_ + shrinkMargin).IsInside(node.box_) == INSIDE)
+            return;
+    }
+
+    // Reinsert below the closest ancestor that contains the new box, so that a small move searches only a nearby subtree.
+    // Start above the parent, as removing the leaf frees its parent
+    unsigned ancestor = nodes_[nodes_[leaf].parent_ != NO_NODE ? nodes_[leaf].parent_ : leaf].parent_;
+    while (ancestor != NO_NODE && nodes_[ancestor].box_.IsInside(leafBox) != INSIDE)
+        ancestor = nodes_[ancestor].parent_;
+
+    RemoveLeaf(leaf);
+    nodes_[leaf].box_ = leafBox;
+    InsertLeaf(leaf, ancestor != NO_NODE ? ancestor : root_);
+}
+
+void DynamicAABBTree::GetProxies(OctreeQuery& query) const
+{
+    if (root_ != NO_NODE)
+        GetDrawablesInternal(root_, query, false);
+}
+
+void DynamicAABBTree::GetProxies(const RayOctreeQuery& query, PODVector<Drawable*>& result) const
+{
+    if (root_ != NO_NODE)
+        GetDrawablesInternal(root_, query, result);
+}
+
+unsigned DynamicAABBTree::AllocateNode()
+{
+    unsigned nodeIndex;
+    if (freeNode_ != NO_NODE)
+    {
+        nodeIndex = freeNode_;
+        freeNode_ = nodes_[nodeIndex].parent_;
+    }
+    else
+    {
+        nodeIndex = nodes_.Size();
+        nodes_.Resize(nodeIndex + 1);
+    }
+
+    AABBTreeNode& node = nodes_[nodeIndex];
+    node.drawable_ = 0;
+    node.parent_ = NO_NODE;
+    node.child1_ = NO_NODE;
+    node.child2_ = NO_NODE;
+    node.height_ = 0;
+    return nodeIndex;
+}
+
+void DynamicAABBTree::FreeNode(unsigned nodeIndex)
+{
+    AABBTreeNode& node = nodes_[nodeIndex];
+    node.drawable_ = 0;
+    node.parent_ = freeNode_;
+    node.height_ = -1;
+    freeNode_ = nodeIndex;
+}
+
+void DynamicAABBTree::InsertLeaf(unsigned leaf, unsigned nodeIndex)
+{
+    if (root_ == NO_NODE)
+    {
+        root_ = leaf;
+        nodes_[leaf].parent_ = NO_NODE;
+        return;
+    }
+
+    // Descend along a single path towards the sibling with the lowest cost, which is the surface area of the new parent
+    // plus the increase of the ancestors' surface areas. Stop when the cost can not decrease further down
+    BoundingBox leafBox = nodes_[leaf].box_;
+    Vector3 leafCenter = leafBox.Center();
+    float leafArea = GetSurfaceArea(leafBox);
+    unsigned index = nodeIndex;
+    float area = GetSurfaceArea(nodes_[index].box_);
+    float directCost = GetSurfaceArea(CombineBoxes(nodes_[index].box_, leafBox));
+    float inheritedCost = 0.0f;
+    unsigned sibling = index;
+    float bestCost = directCost;
+
+    while (nodes_[index].child1_ != NO_NODE)
+    {
+        const AABBTreeNode& node = nodes_[index];
+        float cost = directCost + inheritedCost;
+        if (cost < bestCost)
+        {
+            sibling = index;
+            bestCost = cost;
+        }
+
+        inheritedCost += directCost - area;
+
+        unsigned children[2] = { node.child1_, node.child2_ };
+        bool isLeaf[2];
+        float childAreas[2];
+        float childDirectCosts[2];
+        float lowerCosts[2];
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            const AABBTreeNode& child = nodes_[children[i]];
+            isLeaf[i] = child.child1_ == NO_NODE;
+            childAreas[i] = GetSurfaceArea(child.box_);
+            childDirectCosts[i] = GetSurfaceArea(CombineBoxes(child.box_, leafBox));
+            lowerCosts[i] = M_INFINITY;
+
+            if (isLeaf[i])
+            {
+                float childCost = childDirectCosts[i] + inheritedCost;
+                if (childCost < bestCost)
+                {
+                    sibling = children[i];
+                    bestCost = childCost;
+                }
+            }
+            else
+                lowerCosts[i] = inheritedCost + childDirectCosts[i] + Min(leafArea - childAreas[i], 0.0f);
+        }
+
+        if ((isLeaf[0] && isLeaf[1]) || (bestCost <= lowerCosts[0] && bestCost <= lowerCosts[1]))
+            break;
+
+        // When both children contain the leaf the costs are equal, so choose the closer one
+        if (lowerCosts[0] == lowerCosts[1] && !isLeaf[0])
+        {
+            lowerCosts[0] = (nodes_[children[0]].box_.Center() - leafCenter).LengthSquared();
+            lowerCosts[1] = (nodes_[children[1]].box_.Center() - leafCenter).LengthSquared();
+        }
+
+        unsigned next = lowerCosts[0] < lowerCosts[1] && !isLeaf[0] ? 0 : 1;
+        index = children[next];
+        area = childAreas[next];
+        directCost = childDirectCosts[next];
+    }
+
+    unsigned oldParent = nodes_[sibling].parent_;
+    unsigned newParent = AllocateNode();
+    AABBTreeNode& parentNode = nodes_[newParent];
+    parentNode.parent_ = oldParent;
+    parentNode.child1_ = sibling;
+    parentNode.child2_ = leaf;
+    nodes_[sibling].parent_ = newParent;
+    nodes_[leaf].parent_ = newParent;
+
+    if (oldParent != NO_NODE)
+    {
+        if (nodes_[oldParent].child1_ == sibling)
+            nodes_[oldParent].child1_ = newParent;
+        else
+            nodes_[oldParent].child2_ = newParent;
+    }
+    else
+        root_ = newParent;
+
+    RefitParents(newParent);
+}
+
+void DynamicAABBTree::RemoveLeaf(unsigned leaf)
+{
+    if (leaf == root_)
+    {
+        root_ = NO_NODE;
+        return;
+    }
+
+    unsigned parent = nodes_[leaf].parent_;
+    unsigned grandParent = nodes_[parent].parent_;
+    unsigned sibling = nodes_[parent].child1_ == leaf ? nodes_[parent].child2_ : nodes_[parent].child1_;
+
+    // Replace the parent with the sibling
+    if (grandParent != NO_NODE)
+    {
+        if (nodes_[grandParent].child1_ == parent)
+            nodes_[grandParent].child1_ = sibling;
+        else
+            nodes_[grandParent].child2_ = sibling;
+        nodes_[sibling].parent_ = grandParent;
+        FreeNode(parent);
+        RefitParents(grandParent);
+    }
+    else
+    {
+        root_ = sibling;
+        nodes_[sibling].parent_ = NO_NODE;
+        FreeNode(parent);
+    }
+}
+
+void DynamicAABBTree::RefitParents(unsigned nodeIndex)
+{
+    while (nodeIndex != NO_NODE)
+    {
+        AABBTreeNode& node = nodes_[nodeIndex];
+        const AABBTreeNode& child1 = nodes_[node.child1_];
+        const AABBTreeNode& child2 = nodes_[node.child2_];
+        int height = 1 + Max(child1.height_, child2.height_);
+        BoundingBox box = CombineBoxes(child1.box_, child2.box_);
+        // When the node does not change, neither do its parents
+        if (height == node.height_ && box == node.box_)
+            break;
+
+        node.height_ = height;
+        node.box_ = box;
+        Rotate(nodeIndex);
+        nodeIndex = nodes_[nodeIndex].parent_;
+    }
+}
+
+void DynamicAABBTree::Rotate(unsigned iA)
+{
+    AABBTreeNode& a = nodes_[iA];
+    if (a.height_ < 2)
+        return;
+
+    unsigned iB = a.child1_;
+    unsigned iC = a.child2_;
+    AABBTreeNode& b = nodes_[iB];
+    AABBTreeNode& c = nodes_[iC];
+
+    // Swapping a child with a grandchild on the other side changes only the surface area of the grandchild's parent, as the
+    // bounding box of this node stays the same. Find the swap that decreases it the most
+    RotationType bestRotation = ROTATE_NONE;
+    float bestDelta = 0.0f;
+    BoundingBox newBoxes[4];
+
+    if (c.child1_ != NO_NODE)
+    {
+        float areaC = GetSurfaceArea(c.box_);
+        const BoundingBox& boxF = nodes_[c.child1_].box_;
+        const BoundingBox& boxG = nodes_[c.child2_].box_;
+
+        // Swap B and F: C will contain B and G
+        newBoxes[ROTATE_BF] = CombineBoxes(b.box_, boxG);
+        float delta = GetSurfaceArea(newBoxes[ROTATE_BF]) - areaC;
+        if (delta < bestDelta)
+        {
+            bestRotation = ROTATE_BF;
+            bestDelta = delta;
+        }
+
+        // Swap B and G: C will contain B and F
+        newBoxes[ROTATE_BG] = CombineBoxes(b.box_, boxF);
+        delta = GetSurfaceArea(newBoxes[ROTATE_BG]) - areaC;
+        if (delta < bestDelta)
+        {
+            bestRotation = ROTATE_BG;
+            bestDelta = delta;
+        }
+    }
+
+    if (b.child1_ != NO_NODE)
+    {
+        float areaB = GetSurfaceArea(b.box_);
+        const BoundingBox& boxD = nodes_[b.child1_].box_;
+        const BoundingBox& boxE = nodes_[b.child2_].box_;
+
+        // Swap C and D: B will contain C and E
+        newBoxes[ROTATE_CD] = CombineBoxes(c.box_, boxE);
+        float delta = GetSurfaceArea(newBoxes[ROTATE_CD]) - areaB;
+        if (delta < bestDelta)
+        {
+            bestRotation = ROTATE_CD;
+            bestDelta = delta;
+        }
+
+        // Swap C and E: B will contain C and D
+        newBoxes[ROTATE_CE] = CombineBoxes(c.box_, boxD);
+        delta = GetSurfaceArea(newBoxes[ROTATE_CE]) - areaB;
+        if (delta < bestDelta)
+        {
+            bestRotation = ROTATE_CE;
+            bestDelta = delta;
+        }
+    }
+
+    switch (bestRotation)
+    {
+    case ROTATE_BF:
+        {
+            unsigned iF = c.child1_;
+            a.child1_ = iF;
+            c.child1_ = iB;
+            b.parent_ = iC;
+            nodes_[iF].parent_ = iA;
+            c.box_ = newBoxes[ROTATE_BF];
+            c.height_ = 1 + Max(b.height_, nodes_[c.child2_].height_);
+            a.height_ = 1 + Max(c.height_, nodes_[iF].height_);
+        }
+        break;
+
+    case ROTATE_BG:
+        {
+            unsigned iG = c.child2_;
+            a.child1_ = iG;
+            c.child2_ = iB;
+            b.parent_ = iC;
+            nodes_[iG].parent_ = iA;
+            c.box_ = newBoxes[ROTATE_BG];
+            c.height_ = 1 + Max(b.height_, nodes_[c.child1_].height_);
+            a.height_ = 1 + Max(c.height_, nodes_[iG].height_);
+        }
+        break;
+
+    case ROTATE_CD:
+        {
+            unsigned iD = b.child1_;
+            a.child2_ = iD;
+            b.child1_ = iC;
+            c.parent_ = iB;
+            nodes_[iD].parent_ = iA;
+            b.box_ = newBoxes[ROTATE_CD];
+            b.height_ = 1 + Max(c.height_, nodes_[b.child2_].height_);
+            a.height_ = 1 + Max(b.height_, nodes_[iD].height_);
+        }
+        break;
+
+    case ROTATE_CE:
+        {
+            unsigned iE = b.child2_;
+            a.child2_ = iE;
+            b.child2_ = iC;
+            c.parent_ = iB;
+            nodes_[iE].parent_ = iA;
+            b.box_ = newBoxes[ROTATE_CE];
+            b.height_ = 1 + Max(c.height_, nodes_[b.child1_].height_);
+            a.height_ = 1 + Max(b.height_, nodes_[iE].height_);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+BoundingBox DynamicAABBTree::GetLeafBox(const BoundingBox& box, const Vector3& displacement) const
+{
+    Vector3 margin(Vector3::ONE * (margin_ * GetLargestDimension(box)));
+    BoundingBox ret(box.min_ - margin, box.max_ + margin);
+
+    // Enlarge towards the predicted movement
+    Vector3 predicted = DISPLACEMENT_MULTIPLIER * displacement;
+    if (predicted.x_ < 0.0f)
+        ret.min_.x_ += predicted.x_;
+    else
+        ret.max_.x_ += predicted.x_;
+    if (predicted.y_ < 0.0f)
+        ret.min_.y_ += predicted.y_;
+    else
+        ret.max_.y_ += predicted.y_;
+    if (predicted.z_ < 0.0f)
+        ret.min_.z_ += predicted.z_;
+    else
+        ret.max_.z_ += predicted.z_;
+
+    return ret;
+}
+
+void DynamicAABBTree::GetDrawablesInternal(unsigned nodeIndex, OctreeQuery& query, bool inside) const
+{
+    const AABBTreeNode& node = nodes_[nodeIndex];
+
+    // The drawable's own bounding box is tested by the query, so the leaf box is not tested
+    if (node.child1_ == NO_NODE)
+    {
+        Drawable** drawable = const_cast<Drawable**>(&node.drawable_);
+        query.TestDrawables(drawable, drawable + 1, inside);
+        return;
+    }
+
+    Intersection res = query.TestOctant(node.box_, inside);
+    if (res == INSIDE)
+        inside = true;
+    else if (res == OUTSIDE)
+        return;
+
+    GetDrawablesInternal(node.child1_, query, inside);
+    GetDrawablesInternal(node.child2_, query, inside);
+}
+
+void DynamicAABBTree::GetDrawablesInternal(unsigned nodeIndex, const RayOctreeQuery& query, PODVector<Drawable*>& result) const
+{
+    const AABBTreeNode& node = nodes_[nodeIndex];
+    if (query.ray_.HitDistance(node.box_) >= query.maxDistance_)
+        return;
+
+    if (node.child1_ == NO_NODE)
+    {
+        Drawable* drawable = node.drawable_;
+        if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+            result.Push(drawable);
+        return;
+    }
+
+    GetDrawablesInternal(node.child1_, query, result);
+    GetDrawablesInternal(node.child2_, query, result);
+}
+
+void DynamicAABBTree::DrawDebugGeometry(unsigned nodeIndex, DebugRenderer* debug, bool depthTest) const
+{
+    const AABBTreeNode& node = nodes_[nodeIndex];
+    if (!debug->IsInside(node.box_))
+        return;
+
+    debug->AddBoundingBox(node.box_, Color(0.25f, 0.25f, 0.25f), depthTest);
+
+    if (node.child1_ != NO_NODE)
+    {
+        DrawDebugGeometry(node.child1_, debug, depthTest);
+        DrawDebugGeometry(node.child2_, debug, depthTest);
+    }
+}
+
+}
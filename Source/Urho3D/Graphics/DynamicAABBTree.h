@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/SpatialIndex.h"
+
+namespace Urho3D
+{
+
+static const float DEFAULT_AABB_TREE_MARGIN = 0.25f;
+
+/// Dynamic %AABB tree node.
+struct AABBTreeNode
+{
+    /// Bounding box. For leaves, the drawable object's bounding box expanded by the margin and the predicted movement.
+    BoundingBox box_;
+    /// Drawable object's bounding box center on the last update, for leaves.
+    Vector3 center_;
+    /// Drawable object, for leaves.
+    Drawable* drawable_;
+    /// Parent node index, or the next unused node for unused nodes.
+    unsigned parent_;
+    /// First child node index.
+    unsigned child1_;
+    /// Second child node index.
+    unsigned child2_;
+    /// Height of the subtree. Zero for leaves.
+    int height_;
+};
+
+/// Dynamic %AABB tree spatial index. Leaves have enlarged bounding boxes, so that moving objects are reinserted only when they leave their box. Parent boxes are refit and rotated to decrease their surface area along the changed path.
+class URHO3D_API DynamicAABBTree : public SpatialIndex
+{
+public:
+    /// Construct with the margin added around the drawable objects' bounding boxes, relative to their largest dimension.
+    DynamicAABBTree(float margin = DEFAULT_AABB_TREE_MARGIN);
+    /// Destruct.
+    virtual ~DynamicAABBTree();
+
+    /// Draw the nodes to the debug geometry.
+    virtual void DrawDebugGeometry(DebugRenderer* debug, bool depthTest);
+
+    /// Return the margin added around the drawable objects' bounding boxes, relative to their largest dimension.
+    float GetMargin() const { return margin_; }
+
+    /// Return height of the tree.
+    int GetHeight() const { return root_ != M_MAX_UNSIGNED ? nodes_[root_].height_ : 0; }
+
+protected:
+    /// Add a drawable object to the index and set its proxy.
+    virtual void InsertProxy(Drawable* drawable);
+    /// Remove a drawable object from the index.
+    virtual void RemoveProxy(Drawable* drawable);
+    /// Update a drawable object in the index after its bounding box has changed.
+    virtual void UpdateProxy(Drawable* drawable);
+    /// Return drawable objects in the index by a query.
+    virtual void GetProxies(OctreeQuery& query) const;
+    /// Return drawable objects in the index by a ray query.
+    virtual void GetProxies(const RayOctreeQuery& query, PODVector<Drawable*>& result) const;
+
+private:
+    /// Allocate a node.
+    unsigned AllocateNode();
+    /// Free a node.
+    void FreeNode(unsigned nodeIndex);
+    /// Insert a leaf below a node, next to the sibling that increases the total surface area the least, then refit the parents.
+    void InsertLeaf(unsigned leaf, unsigned nodeIndex);
+    /// Remove a leaf and refit the parents.
+    void RemoveLeaf(unsigned leaf);
+    /// Refit the bounding boxes and heights from a node up to the root, rotating the nodes on the way.
+    void RefitParents(unsigned nodeIndex);
+    /// Swap a child of a node with a grandchild on the other side if it decreases the total surface area of the tree.
+    void Rotate(unsigned nodeIndex);
+    /// Return the leaf bounding box for a drawable object's bounding box and movement.
+    BoundingBox GetLeafBox(const BoundingBox& box, const Vector3& displacement) const;
+    /// Return drawable objects by a query recursively.
+    void GetDrawablesInternal(unsigned nodeIndex, OctreeQuery& query, bool inside) const;
+    /// Return drawable objects by a ray query recursively.
+    void GetDrawablesInternal(unsigned nodeIndex, const RayOctreeQuery& query, PODVector<Drawable*>& result) const;
+    /// Draw node bounds to the debug geometry recursively.
+    void DrawDebugGeometry(unsigned nodeIndex, DebugRenderer* debug, bool depthTest) const;
+
+    /// Nodes.
+    PODVector<AABBTreeNode> nodes_;
+    /// Root node index.
+    unsigned root_;
+    /// First unused node index.
+    unsigned freeNode_;
+    /// Margin added around the drawable objects' bounding boxes, relative to their largest dimension.
+    float margin_;
+};
+
+}
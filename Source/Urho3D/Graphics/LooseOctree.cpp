@@ -0,0 +1,295 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/DebugRenderer.h"
+#include "../Graphics/LooseOctree.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned NO_NODE = M_MAX_UNSIGNED;
+
+static void InitializeNode(LooseOctreeNode& node, const BoundingBox& box, unsigned level, unsigned parent, unsigned childIndex)
+{
+    Vector3 halfSize = 0.5f * box.Size();
+
+    node.worldBoundingBox_ = box;
+    node.cullingBox_ = BoundingBox(box.min_ - halfSize, box.max_ + halfSize);
+    node.center_ = box.Center();
+    for (unsigned i = 0; i < 8; ++i)
+        node.children_[i] = NO_NODE;
+    node.parent_ = parent;
+    node.childIndex_ = childIndex;
+    node.level_ = level;
+    node.numDrawables_ = 0;
+}
+
+LooseOctree::LooseOctree(const BoundingBox& box, unsigned numLevels) :
+    freeEntry_(M_MAX_UNSIGNED),
+    size_(box.Size()),
+    numLevels_(numLevels)
+{
+    nodes_.Resize(1);
+    InitializeNode(nodes_[0], box, 0, NO_NODE, 0);
+}
+
+LooseOctree::~LooseOctree()
+{
+}
+
+void LooseOctree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
+{
+    if (debug)
+        DrawDebugGeometry(0, debug, depthTest);
+}
+
+void LooseOctree::InsertProxy(Drawable* drawable)
+{
+    unsigned entryIndex;
+    if (freeEntry_ != M_MAX_UNSIGNED)
+    {
+        entryIndex = freeEntry_;
+        freeEntry_ = entries_[entryIndex].node_;
+    }
+    else
+    {
+        entryIndex = entries_.Size();
+        entries_.Resize(entryIndex + 1);
+    }
+
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+    Vector3 center = box.Center();
+    // Drawables centered outside the bounds stay in the root node, which is not culled
+    unsigned level = nodes_[0].worldBoundingBox_.IsInside(center) != OUTSIDE ? GetLevel(box) : 0;
+    unsigned nodeIndex = 0;
+    for (unsigned i = 0; i < level; ++i)
+        nodeIndex = GetOrCreateChild(nodeIndex, center);
+
+    SetProxy(drawable, entryIndex);
+    AddToNode(nodeIndex, drawable, entryIndex);
+}
+
+void LooseOctree::RemoveProxy(Drawable* drawable)
+{
+    unsigned entryIndex = GetProxy(drawable);
+    RemoveFromNode(drawable);
+    entries_[entryIndex].node_ = freeEntry_;
+    freeEntry_ = entryIndex;
+}
+
+void LooseOctree::UpdateProxy(Drawable* drawable)
+{
+    unsigned entryIndex = GetProxy(drawable);
+    const LooseOctreeNode& node = nodes_[entries_[entryIndex].node_];
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+    Vector3 center = box.Center();
+    unsigned level = nodes_[0].worldBoundingBox_.IsInside(center) != OUTSIDE ? GetLevel(box) : 0;
+
+    // Keep the drawable in its node if the level has not changed and the center is still inside the cell
+    if (level == node.level_ && (!level || node.worldBoundingBox_.IsInside(center) != OUTSIDE))
+        return;
+
+    RemoveFromNode(drawable);
+    unsigned nodeIndex = 0;
+    for (unsigned i = 0; i < level; ++i)
+        nodeIndex = GetOrCreateChild(nodeIndex, center);
+    AddToNode(nodeIndex, drawable, entryIndex);
+}
+
+void LooseOctree::GetProxies(OctreeQuery& query) const
+{
+    GetDrawablesInternal(0, query, false);
+}
+
+void LooseOctree::GetProxies(const RayOctreeQuery& query, PODVector<Drawable*>& result) const
+{
+    GetDrawablesInternal(0, query, result);
+}
+
+unsigned LooseOctree::GetLevel(const BoundingBox& box) const
+{
+    // A drawable fits the culling box of a cell that contains its center if it is not larger than the cell
+    Vector3 boxSize = box.Size();
+    Vector3 cellSize = 0.5f * size_;
+    unsigned level = 0;
+
+    while (level < numLevels_ && boxSize.x_ <= cellSize.x_ && boxSize.y_ <= cellSize.y_ && boxSize.z_ <= cellSize.z_)
+    {
+        cellSize *= 0.5f;
+        ++level;
+    }
+
+    return level;
+}
+
+unsigned LooseOctree::GetOrCreateChild(unsigned nodeIndex, const Vector3& point)
+{
+    const LooseOctreeNode& node = nodes_[nodeIndex];
+    unsigned index = (point.x_ < node.center_.x_ ? 0 : 1) + (point.y_ < node.center_.y_ ? 0 : 2) +
+        (point.z_ < node.center_.z_ ? 0 : 4);
+    if (node.children_[index] != NO_NODE)
+        return node.children_[index];
+
+    Vector3 newMin = node.worldBoundingBox_.min_;
+    Vector3 newMax = node.worldBoundingBox_.max_;
+
+    if (index & 1)
+        newMin.x_ = node.center_.x_;
+    else
+        newMax.x_ = node.center_.x_;
+
+    if (index & 2)
+        newMin.y_ = node.center_.y_;
+    else
+        newMax.y_ = node.center_.y_;
+
+    if (index & 4)
+        newMin.z_ = node.center_.z_;
+    else
+        newMax.z_ = node.center_.z_;
+
+    unsigned level = node.level_ + 1;
+
+    // Note: the node reference is invalid after this point if the node vector grows
+    unsigned childIndex;
+    if (freeNodes_.Size())
+    {
+        childIndex = freeNodes_.Back();
+        freeNodes_.Pop();
+    }
+    else
+    {
+        childIndex = nodes_.Size();
+        nodes_.Resize(childIndex + 1);
+    }
+
+    InitializeNode(nodes_[childIndex], BoundingBox(newMin, newMax), level, nodeIndex, index);
+    nodes_[nodeIndex].children_[index] = childIndex;
+    return childIndex;
+}
+
+void LooseOctree::AddToNode(unsigned nodeIndex, Drawable* drawable, unsigned entryIndex)
+{
+    LooseOctreeNode& node = nodes_[nodeIndex];
+    LooseOctreeEntry& entry = entries_[entryIndex];
+    entry.node_ = nodeIndex;
+    entry.slot_ = node.drawables_.Size();
+    node.drawables_.Push(drawable);
+
+    for (unsigned i = nodeIndex; i != NO_NODE; i = nodes_[i].parent_)
+        ++nodes_[i].numDrawables_;
+}
+
+void LooseOctree::RemoveFromNode(Drawable* drawable)
+{
+    const LooseOctreeEntry& entry = entries_[GetProxy(drawable)];
+    unsigned nodeIndex = entry.node_;
+
+    // Move the last drawable of the node to the freed slot
+    PODVector<Drawable*>& drawables = nodes_[nodeIndex].drawables_;
+    Drawable* last = drawables.Back();
+    drawables[entry.slot_] = last;
+    entries_[GetProxy(last)].slot_ = entry.slot_;
+    drawables.Pop();
+
+    // Decrease the drawable counts up to the root and free the nodes that become empty. Their children are already empty
+    while (nodeIndex != NO_NODE)
+    {
+        LooseOctreeNode& node = nodes_[nodeIndex];
+        unsigned parent = node.parent_;
+        if (!--node.numDrawables_ && parent != NO_NODE)
+        {
+            nodes_[parent].children_[node.childIndex_] = NO_NODE;
+            freeNodes_.Push(nodeIndex);
+        }
+        nodeIndex = parent;
+    }
+}
+
+void LooseOctree::GetDrawablesInternal(unsigned nodeIndex, OctreeQuery& query, bool inside) const
+{
+    const LooseOctreeNode& node = nodes_[nodeIndex];
+
+    // The root node is not tested, as it also contains the drawables outside the bounds
+    if (nodeIndex)
+    {
+        Intersection res = query.TestOctant(node.cullingBox_, inside);
+        if (res == INSIDE)
+            inside = true;
+        else if (res == OUTSIDE)
+            return;
+    }
+
+    if (node.drawables_.Size())
+    {
+        Drawable** start = const_cast<Drawable**>(&node.drawables_[0]);
+        query.TestDrawables(start, start + node.drawables_.Size(), inside);
+    }
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        if (node.children_[i] != NO_NODE)
+            GetDrawablesInternal(node.children_[i], query, inside);
+    }
+}
+
+void LooseOctree::GetDrawablesInternal(unsigned nodeIndex, const RayOctreeQuery& query, PODVector<Drawable*>& result) const
+{
+    const LooseOctreeNode& node = nodes_[nodeIndex];
+
+    if (nodeIndex && query.ray_.HitDistance(node.cullingBox_) >= query.maxDistance_)
+        return;
+
+    for (PODVector<Drawable*>::ConstIterator i = node.drawables_.Begin(); i != node.drawables_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+            result.Push(drawable);
+    }
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        if (node.children_[i] != NO_NODE)
+            GetDrawablesInternal(node.children_[i], query, result);
+    }
+}
+
+void LooseOctree::DrawDebugGeometry(unsigned nodeIndex, DebugRenderer* debug, bool depthTest) const
+{
+    const LooseOctreeNode& node = nodes_[nodeIndex];
+    if (!debug->IsInside(node.worldBoundingBox_))
+        return;
+
+    debug->AddBoundingBox(node.worldBoundingBox_, Color(0.25f, 0.25f, 0.25f), depthTest);
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        if (node.children_[i] != NO_NODE)
+            DrawDebugGeometry(node.children_[i], debug, depthTest);
+    }
+}
+
+}
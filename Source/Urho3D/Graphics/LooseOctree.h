@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/SpatialIndex.h"
+
+namespace Urho3D
+{
+
+/// %Loose octree node.
+struct LooseOctreeNode
+{
+    /// World bounding box of the cell.
+    BoundingBox worldBoundingBox_;
+    /// Cell bounding box expanded by half its size, which contains the drawable objects of the node.
+    BoundingBox cullingBox_;
+    /// Cell center.
+    Vector3 center_;
+    /// Drawable objects.
+    PODVector<Drawable*> drawables_;
+    /// Child node indices.
+    unsigned children_[8];
+    /// Parent node index.
+    unsigned parent_;
+    /// Index relative to the siblings.
+    unsigned childIndex_;
+    /// Subdivision level.
+    unsigned level_;
+    /// Number of drawable objects in this node and child nodes.
+    unsigned numDrawables_;
+};
+
+/// Position of a drawable object in a loose octree.
+struct LooseOctreeEntry
+{
+    /// Node index, or the next free entry if unused.
+    unsigned node_;
+    /// Index in the node's drawables.
+    unsigned slot_;
+};
+
+/// %Loose octree spatial index. The subdivision level of a drawable object is chosen from its size, and the cell from its center, so that moving objects are reinserted only when their center leaves the cell.
+class URHO3D_API LooseOctree : public SpatialIndex
+{
+public:
+    /// Construct with bounds and maximum subdivision level.
+    LooseOctree(const BoundingBox& box, unsigned numLevels);
+    /// Destruct.
+    virtual ~LooseOctree();
+
+    /// Draw the nodes to the debug geometry.
+    virtual void DrawDebugGeometry(DebugRenderer* debug, bool depthTest);
+
+    /// Return number of allocated nodes.
+    unsigned GetNumNodes() const { return nodes_.Size() - freeNodes_.Size(); }
+
+protected:
+    /// Add a drawable object to the index and set its proxy.
+    virtual void InsertProxy(Drawable* drawable);
+    /// Remove a drawable object from the index.
+    virtual void RemoveProxy(Drawable* drawable);
+    /// Update a drawable object in the index after its bounding box has changed.
+    virtual void UpdateProxy(Drawable* drawable);
+    /// Return drawable objects in the index by a query.
+    virtual void GetProxies(OctreeQuery& query) const;
+    /// Return drawable objects in the index by a ray query.
+    virtual void GetProxies(const RayOctreeQuery& query, PODVector<Drawable*>& result) const;
+
+private:
+    /// Return the subdivision level for a bounding box.
+    unsigned GetLevel(const BoundingBox& box) const;
+    /// Return or create the child node of a node that contains a point.
+    unsigned GetOrCreateChild(unsigned nodeIndex, const Vector3& point);
+    /// Add a drawable object to a node.
+    void AddToNode(unsigned nodeIndex, Drawable* drawable, unsigned entryIndex);
+    /// Remove a drawable object from its node, and free the nodes that become empty.
+    void RemoveFromNode(Drawable* drawable);
+    /// Return drawable objects by a query recursively.
+    void GetDrawablesInternal(unsigned nodeIndex, OctreeQuery& query, bool inside) const;
+    /// Return drawable objects by a ray query recursively.
+    void GetDrawablesInternal(unsigned nodeIndex, const RayOctreeQuery& query, PODVector<Drawable*>& result) const;
+    /// Draw node bounds to the debug geometry recursively.
+    void DrawDebugGeometry(unsigned nodeIndex, DebugRenderer* debug, bool depthTest) const;
+
+    /// Nodes. The root node is at index 0.
+    Vector<LooseOctreeNode> nodes_;
+    /// Unused node indices.
+    PODVector<unsigned> freeNodes_;
+    /// Drawable object positions indexed by proxy.
+    PODVector<LooseOctreeEntry> entries_;
+    /// First unused entry.
+    unsigned freeEntry_;
+    /// Root bounds size.
+    Vector3 size_;
+    /// Maximum subdivision level.
+    unsigned numLevels_;
+};
+
+}
@@ -43,8 +43,11 @@ static const unsigned CLIPMASK_Z_NEG = 0x20;
 void DrawOcclusionBatchWork(const WorkItem* item, unsigned threadIndex)
 {
     OcclusionBuffer* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
-    OcclusionBatch& batch = *reinterpret_cast<OcclusionBatch*>(item->start_);
-    buffer->DrawBatch(batch, threadIndex);
+    OcclusionBatch* start = reinterpret_cast<OcclusionBatch*>(item->start_);
+    OcclusionBatch* end = reinterpret_cast<OcclusionBatch*>(item->end_);
+
+    while (start != end)
+        buffer->DrawBatch(*start++, threadIndex);
 }
 
 OcclusionBuffer::OcclusionBuffer(Context* context) :
@@ -218,18 +221,7 @@ void OcclusionBuffer::DrawTriangles()
     {
         // Threaded
         WorkQueue* queue = GetSubsystem<WorkQueue>();
-
-        for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = DrawOcclusionBatchWork;
-            item->aux_ = this;
-            item->start_ = &(*i);
-            queue->AddWorkItem(item);
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+        queue->ParallelFor(batches_.Begin(), batches_.End(), DrawOcclusionBatchWork, this, &drawBatchesStats_);
 
         MergeBuffers();
         depthHierarchyDirty_ = true;
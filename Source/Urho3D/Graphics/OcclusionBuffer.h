@@ -24,6 +24,7 @@
 
 #include "../Core/Object.h"
 #include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Container/ArrayPtr.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Math/Frustum.h"
@@ -183,6 +184,8 @@ private:
     Vector<SharedArrayPtr<DepthValue> > mipBuffers_;
     /// Submitted render jobs.
     PODVector<OcclusionBatch> batches_;
+    /// Chunking state for the threaded render jobs.
+    ParallelForStats drawBatchesStats_;
     /// Buffer width.
     int width_;
     /// Buffer height.
@@ -28,7 +28,9 @@
 #include "../Core/Thread.h"
 #include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
+#include "../Graphics/DynamicAABBTree.h"
 #include "../Graphics/Graphics.h"
+#include "../Graphics/LooseOctree.h"
 #include "../Graphics/Octree.h"
 #include "../IO/Log.h"
 #include "../Scene/Scene.h"
@@ -45,6 +47,18 @@ namespace Urho3D
 
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
+/// Octree subdivision level from which octants are tested in worker threads during a threaded query.
+static const unsigned THREADED_QUERY_LEVEL = 2;
+/// Minimum number of drawables in the octree for a threaded query.
+static const unsigned MIN_THREADED_QUERY_DRAWABLES = 1024;
+
+static const char* spatialIndexNames[] =
+{
+    "Octree",
+    "LooseOctree",
+    "AABBTree",
+    0
+};
 
 extern const char* SUBSYSTEM_CATEGORY;
 
@@ -63,11 +77,42 @@ void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
+void GetDrawablesWork(const WorkItem* item, unsigned threadIndex)
+{
+    const Octree* octree = reinterpret_cast<Octree*>(item->aux_);
+    OctreeQuery& query = *octree->threadQueries_[threadIndex];
+    OctantQueryTask* start = reinterpret_cast<OctantQueryTask*>(item->start_);
+    OctantQueryTask* end = reinterpret_cast<OctantQueryTask*>(item->end_);
+
+    while (start != end)
+    {
+        if (start->octant_)
+        {
+            start->threadIndex_ = threadIndex;
+            start->resultStart_ = query.result_.Size();
+            start->octant_->GetDrawablesInternal(query, start->inside_);
+            start->resultEnd_ = query.result_.Size();
+        }
+        ++start;
+    }
+}
+
 inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
 }
 
+inline void CopyCullingData(DrawableCullingBlock& dest, unsigned destSlot, const DrawableCullingBlock& src, unsigned srcSlot)
+{
+    dest.minX_[destSlot] = src.minX_[srcSlot];
+    dest.minY_[destSlot] = src.minY_[srcSlot];
+    dest.minZ_[destSlot] = src.minZ_[srcSlot];
+    dest.maxX_[destSlot] = src.maxX_[srcSlot];
+    dest.maxY_[destSlot] = src.maxY_[srcSlot];
+    dest.maxZ_[destSlot] = src.maxZ_[srcSlot];
+    dest.flags_[destSlot] = src.flags_[srcSlot];
+}
+
 Octant::Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* root, unsigned index) :
     level_(level),
     numDrawables_(0),
@@ -89,10 +134,11 @@ Octant::~Octant()
         for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
         {
             (*i)->SetOctant(root_);
-            root_->drawables_.Push(*i);
+            root_->PushDrawable(*i);
             root_->QueueUpdate(*i);
         }
         drawables_.Clear();
+        cullingBlocks_.Clear();
         numDrawables_ = 0;
     }
 
@@ -140,10 +186,11 @@ void Octant::InsertDrawable(Drawable* drawable)
     const BoundingBox& box = drawable->GetWorldBoundingBox();
 
     // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
-    // Also if drawable is outside the root octant bounds, insert to root
+    // Also if drawable is outside the root octant bounds, or if the octree uses a separate spatial index, insert to root
     bool insertHere;
     if (this == root_)
-        insertHere = !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
+        insertHere = root_->spatialIndex_ || !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE ||
+            CheckDrawableFit(box);
     else
         insertHere = CheckDrawableFit(box);
 
@@ -153,9 +200,21 @@ void Octant::InsertDrawable(Drawable* drawable)
         if (oldOctant != this)
         {
             // Add first, then remove, because drawable count going to zero deletes the octree branch in question
+            unsigned oldIndex = drawable->octantIndex_;
             AddDrawable(drawable);
             if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
+            {
+                oldOctant->EraseDrawable(oldIndex);
+                oldOctant->DecDrawableCount();
+            }
+        }
+
+        if (this == root_ && root_->spatialIndex_)
+        {
+            if (oldOctant != this)
+                root_->spatialIndex_->InsertDrawable(drawable);
+            else
+                root_->spatialIndex_->UpdateDrawable(drawable);
         }
     }
     else
@@ -193,6 +252,28 @@ bool Octant::CheckDrawableFit(const BoundingBox& box) const
     return false;
 }
 
+void Octant::UpdateCullingData(Drawable* drawable)
+{
+    unsigned index = drawable->octantIndex_;
+    DrawableCullingBlock& block = cullingBlocks_[index / DRAWABLE_CULLING_BLOCK_SIZE];
+    unsigned slot = index % DRAWABLE_CULLING_BLOCK_SIZE;
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+
+    block.minX_[slot] = box.min_.x_;
+    block.minY_[slot] = box.min_.y_;
+    block.minZ_[slot] = box.min_.z_;
+    block.maxX_[slot] = box.max_.x_;
+    block.maxY_[slot] = box.max_.y_;
+    block.maxZ_[slot] = box.max_.z_;
+    block.flags_[slot] = drawable->GetDrawableFlags() | (drawable->updateQueued_ ? DRAWABLE_CULLING_STALE : 0);
+}
+
+void Octant::MarkCullingDataStale(Drawable* drawable)
+{
+    unsigned index = drawable->octantIndex_;
+    cullingBlocks_[index / DRAWABLE_CULLING_BLOCK_SIZE].flags_[index % DRAWABLE_CULLING_BLOCK_SIZE] |= DRAWABLE_CULLING_STALE;
+}
+
 void Octant::ResetRoot()
 {
     root_ = 0;
@@ -230,6 +311,48 @@ void Octant::Initialize(const BoundingBox& box)
     cullingBox_ = BoundingBox(worldBoundingBox_.min_ - halfSize_, worldBoundingBox_.max_ + halfSize_);
 }
 
+void Octant::PushDrawable(Drawable* drawable)
+{
+    unsigned index = drawables_.Size();
+    drawable->octantIndex_ = index;
+    drawables_.Push(drawable);
+
+    // Start a new block when the previous is full. Unused slots have zero flags so that queries skip them
+    if (index % DRAWABLE_CULLING_BLOCK_SIZE == 0)
+    {
+        cullingBlocks_.Resize(cullingBlocks_.Size() + 1);
+        memset(&cullingBlocks_.Back(), 0, sizeof(DrawableCullingBlock));
+    }
+
+    UpdateCullingData(drawable);
+}
+
+void Octant::EraseDrawable(unsigned index)
+{
+    if (this == root_ && root_->spatialIndex_)
+        root_->spatialIndex_->RemoveDrawable(drawables_[index]);
+
+    unsigned lastIndex = drawables_.Size() - 1;
+    DrawableCullingBlock& lastBlock = cullingBlocks_[lastIndex / DRAWABLE_CULLING_BLOCK_SIZE];
+    unsigned lastSlot = lastIndex % DRAWABLE_CULLING_BLOCK_SIZE;
+
+    // Move the last drawable to the freed index, so that the drawables and the culling blocks stay packed
+    if (index != lastIndex)
+    {
+        Drawable* last = drawables_[lastIndex];
+        drawables_[index] = last;
+        last->octantIndex_ = index;
+        CopyCullingData(cullingBlocks_[index / DRAWABLE_CULLING_BLOCK_SIZE], index % DRAWABLE_CULLING_BLOCK_SIZE, lastBlock,
+            lastSlot);
+    }
+
+    drawables_.Pop();
+    if (lastSlot)
+        lastBlock.flags_[lastSlot] = 0;
+    else
+        cullingBlocks_.Pop();
+}
+
 void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
 {
     if (this != root_)
@@ -248,7 +371,7 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     {
         Drawable** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.Size();
-        query.TestDrawables(start, end, inside);
+        query.TestDrawableBlocks(start, end, &cullingBlocks_[0], inside);
     }
 
     for (unsigned i = 0; i < NUM_OCTANTS; ++i)
@@ -258,6 +381,58 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     }
 }
 
+void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside, unsigned taskLevel, PODVector<OctantQueryTask>& tasks) const
+{
+    if (this != root_)
+    {
+        Intersection res = query.TestOctant(cullingBox_, inside);
+        if (res == INSIDE)
+            inside = true;
+        else if (res == OUTSIDE)
+            return;
+    }
+
+    if (drawables_.Size())
+    {
+        Drawable** start = const_cast<Drawable**>(&drawables_[0]);
+        Drawable** end = start + drawables_.Size();
+        unsigned resultStart = query.result_.Size();
+        query.TestDrawableBlocks(start, end, &cullingBlocks_[0], inside);
+
+        // Record the results as a range before the child octants, as in the single-threaded traversal
+        if (query.result_.Size() > resultStart)
+        {
+            OctantQueryTask range;
+            range.octant_ = 0;
+            range.inside_ = inside;
+            range.threadIndex_ = 0;
+            range.resultStart_ = resultStart;
+            range.resultEnd_ = query.result_.Size();
+            tasks.Push(range);
+        }
+    }
+
+    for (unsigned i = 0; i < NUM_OCTANTS; ++i)
+    {
+        Octant* child = children_[i];
+        if (child)
+        {
+            if (child->level_ >= taskLevel)
+            {
+                OctantQueryTask task;
+                task.octant_ = child;
+                task.inside_ = inside;
+                task.threadIndex_ = 0;
+                task.resultStart_ = 0;
+                task.resultEnd_ = 0;
+                tasks.Push(task);
+            }
+            else
+                child->GetDrawablesInternal(query, inside, taskLevel, tasks);
+        }
+    }
+}
+
 void Octant::GetDrawablesInternal(RayOctreeQuery& query) const
 {
     float octantDist = query.ray_.HitDistance(cullingBox_);
@@ -315,7 +490,9 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*
 Octree::Octree(Context* context) :
     Component(context),
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, 0, this),
-    numLevels_(DEFAULT_OCTREE_LEVELS)
+    numLevels_(DEFAULT_OCTREE_LEVELS),
+    spatialIndexType_(SPATIAL_INDEX_OCTREE),
+    spatialIndex_(0)
 {
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
@@ -328,6 +505,9 @@ Octree::~Octree()
     // Reset root pointer from all child octants now so that they do not move their drawables to root
     drawableUpdates_.Clear();
     ResetRoot();
+
+    delete spatialIndex_;
+    spatialIndex_ = 0;
 }
 
 void Octree::RegisterObject(Context* context)
@@ -340,6 +520,8 @@ void Octree::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Bounding Box Min", Vector3, worldBoundingBox_.min_, defaultBoundsMin, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Bounding Box Max", Vector3, worldBoundingBox_.max_, defaultBoundsMax, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Number of Levels", int, numLevels_, DEFAULT_OCTREE_LEVELS, AM_DEFAULT);
+    URHO3D_ENUM_ACCESSOR_ATTRIBUTE("Spatial Index", GetSpatialIndexType, SetSpatialIndexType, SpatialIndexType, spatialIndexNames,
+        SPATIAL_INDEX_OCTREE, AM_DEFAULT);
 }
 
 void Octree::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
@@ -355,7 +537,10 @@ void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     {
         URHO3D_PROFILE(OctreeDrawDebug);
 
-        Octant::DrawDebugGeometry(debug, depthTest);
+        if (spatialIndex_)
+            spatialIndex_->DrawDebugGeometry(debug, depthTest);
+        else
+            Octant::DrawDebugGeometry(debug, depthTest);
     }
 }
 
@@ -370,6 +555,38 @@ void Octree::SetSize(const BoundingBox& box, unsigned numLevels)
     Initialize(box);
     numDrawables_ = drawables_.Size();
     numLevels_ = Max(numLevels, 1U);
+
+    if (spatialIndex_)
+        CreateSpatialIndex();
+}
+
+void Octree::SetSpatialIndexType(SpatialIndexType type)
+{
+    if (type == spatialIndexType_)
+        return;
+
+    spatialIndexType_ = type;
+
+    if (type == SPATIAL_INDEX_OCTREE)
+    {
+        delete spatialIndex_;
+        spatialIndex_ = 0;
+
+        // Move the drawables from the root to the octants on the next update
+        for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
+        {
+            if (!(*i)->updateQueued_)
+                QueueUpdate(*i);
+        }
+    }
+    else
+    {
+        // Deleting the child octants moves their drawables to the root
+        for (unsigned i = 0; i < NUM_OCTANTS; ++i)
+            DeleteChild(i);
+
+        CreateSpatialIndex();
+    }
 }
 
 void Octree::Update(const FrameInfo& frame)
@@ -380,6 +597,11 @@ void Octree::Update(const FrameInfo& frame)
         return;
     }
 
+    // Apply batched transform changes so that the moved drawables get queued for update
+    Scene* scene = GetScene();
+    if (scene)
+        scene->UpdateTransforms();
+
     // Let drawables update themselves before reinsertion. This can be used for animation
     if (!drawableUpdates_.Empty())
     {
@@ -387,34 +609,12 @@ void Octree::Update(const FrameInfo& frame)
 
         // Perform updates in worker threads. Notify the scene that a threaded update is going on and components
         // (for example physics objects) should not perform non-threadsafe work when marked dirty
-        Scene* scene = GetScene();
         WorkQueue* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.Size() / numWorkItems), 1);
-
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
+        queue->ParallelFor(drawableUpdates_.Begin(), drawableUpdates_.End(), UpdateDrawablesWork,
+            const_cast<FrameInfo*>(&frame), &updateDrawablesStats_);
 
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
         scene->EndThreadedUpdate();
     }
 
@@ -437,7 +637,6 @@ void Octree::Update(const FrameInfo& frame)
     }
 
     // Notify drawable update being finished. Custom animation (eg. IK) can be done at this point
-    Scene* scene = GetScene();
     if (scene)
     {
         using namespace SceneDrawableUpdateFinished;
@@ -446,6 +645,7 @@ void Octree::Update(const FrameInfo& frame)
         eventData[P_SCENE] = scene;
         eventData[P_TIMESTEP] = frame.timeStep_;
         scene->SendEvent(E_SCENEDRAWABLEUPDATEFINISHED, eventData);
+        scene->UpdateTransforms();
     }
 
     // Reinsert drawables that have been moved or resized, or that have been newly added to the octree and do not sit inside
@@ -464,11 +664,22 @@ void Octree::Update(const FrameInfo& frame)
             // Skip if no octant or does not belong to this octree anymore
             if (!octant || octant->GetRoot() != this)
                 continue;
-            // Skip if still fits the current octant
+            // With a separate spatial index the drawable stays in the root octant
+            if (spatialIndex_)
+            {
+                spatialIndex_->UpdateDrawable(drawable);
+                octant->UpdateCullingData(drawable);
+                continue;
+            }
+            // Skip if still fits the current octant, but refresh the bounding box used for culling
             if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+            {
+                octant->UpdateCullingData(drawable);
                 continue;
+            }
 
             InsertDrawable(drawable);
+            drawable->GetOctant()->UpdateCullingData(drawable);
 
 #ifdef _DEBUG
             // Verify that the drawable will be culled correctly
@@ -491,6 +702,8 @@ void Octree::AddManualDrawable(Drawable* drawable)
         return;
 
     AddDrawable(drawable);
+    if (spatialIndex_)
+        spatialIndex_->InsertDrawable(drawable);
 }
 
 void Octree::RemoveManualDrawable(Drawable* drawable)
@@ -506,6 +719,22 @@ void Octree::RemoveManualDrawable(Drawable* drawable)
 void Octree::GetDrawables(OctreeQuery& query) const
 {
     query.result_.Clear();
+
+    if (spatialIndex_)
+    {
+        spatialIndex_->GetDrawables(query);
+        return;
+    }
+
+    // Worker threads can not wait for other work items, so only split the query when called from the main thread while
+    // it is not executing work items itself
+    if (numDrawables_ >= MIN_THREADED_QUERY_DRAWABLES && Thread::IsMainThread())
+    {
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        if (queue && queue->GetNumThreads() && !queue->IsCompleting() && GetDrawablesThreaded(query, queue))
+            return;
+    }
+
     GetDrawablesInternal(query, false);
 }
 
@@ -514,7 +743,17 @@ void Octree::Raycast(RayOctreeQuery& query) const
     URHO3D_PROFILE(Raycast);
 
     query.result_.Clear();
-    GetDrawablesInternal(query);
+
+    if (spatialIndex_)
+    {
+        rayQueryDrawables_.Clear();
+        spatialIndex_->GetDrawables(query, rayQueryDrawables_);
+        for (PODVector<Drawable*>::Iterator i = rayQueryDrawables_.Begin(); i != rayQueryDrawables_.End(); ++i)
+            (*i)->ProcessRayQuery(query, query.result_);
+    }
+    else
+        GetDrawablesInternal(query);
+
     Sort(query.result_.Begin(), query.result_.End(), CompareRayQueryResults);
 }
 
@@ -524,7 +763,10 @@ void Octree::RaycastSingle(RayOctreeQuery& query) const
 
     query.result_.Clear();
     rayQueryDrawables_.Clear();
-    GetDrawablesOnlyInternal(query, rayQueryDrawables_);
+    if (spatialIndex_)
+        spatialIndex_->GetDrawables(query, rayQueryDrawables_);
+    else
+        GetDrawablesOnlyInternal(query, rayQueryDrawables_);
 
     // Sort by increasing hit distance to AABB
     for (PODVector<Drawable*>::Iterator i = rayQueryDrawables_.Begin(); i != rayQueryDrawables_.End(); ++i)
@@ -561,13 +803,20 @@ void Octree::RaycastSingle(RayOctreeQuery& query) const
 void Octree::QueueUpdate(Drawable* drawable)
 {
     Scene* scene = GetScene();
+    Octant* octant = drawable->GetOctant();
     if (scene && scene->IsThreadedUpdate())
     {
         MutexLock lock(octreeMutex_);
         threadedDrawableUpdates_.Push(drawable);
+        if (octant)
+            octant->MarkCullingDataStale(drawable);
     }
     else
+    {
         drawableUpdates_.Push(drawable);
+        if (octant)
+            octant->MarkCullingDataStale(drawable);
+    }
 
     drawable->updateQueued_ = true;
 }
@@ -586,6 +835,76 @@ void Octree::DrawDebugGeometry(bool depthTest)
     DrawDebugGeometry(debug, depthTest);
 }
 
+bool Octree::GetDrawablesThreaded(OctreeQuery& query, WorkQueue* queue) const
+{
+    unsigned numThreads = queue->GetNumThreads() + 1;
+    threadQueryResults_.Resize(numThreads);
+    threadQueries_.Resize(numThreads);
+
+    threadQueryResults_[0].Clear();
+    threadQueries_[0] = query.Clone(threadQueryResults_[0]);
+    if (!threadQueries_[0])
+        return false;
+
+    for (unsigned i = 1; i < numThreads; ++i)
+    {
+        threadQueryResults_[i].Clear();
+        threadQueries_[i] = query.Clone(threadQueryResults_[i]);
+    }
+
+    // Test the top levels in the main thread, then the octants below them in the worker threads. Each thread writes to its own
+    // result vector without locking
+    {
+        URHO3D_PROFILE(GetDrawablesThreaded);
+
+        queryTasks_.Clear();
+        GetDrawablesInternal(query, false, THREADED_QUERY_LEVEL, queryTasks_);
+        queue->ParallelFor(queryTasks_.Begin(), queryTasks_.End(), GetDrawablesWork, const_cast<Octree*>(this), &queryStats_);
+    }
+
+    // Combine the top level results and the octant results in task order. This is the depth-first order of the single-threaded
+    // query, and does not depend on which thread tested which octant
+    topQueryResults_.Swap(query.result_);
+    query.result_.Clear();
+    for (PODVector<OctantQueryTask>::ConstIterator i = queryTasks_.Begin(); i != queryTasks_.End(); ++i)
+    {
+        const PODVector<Drawable*>& taskResult = i->octant_ ? threadQueryResults_[i->threadIndex_] : topQueryResults_;
+        for (unsigned j = i->resultStart_; j < i->resultEnd_; ++j)
+            query.result_.Push(taskResult[j]);
+    }
+
+    for (unsigned i = 0; i < numThreads; ++i)
+    {
+        delete threadQueries_[i];
+        threadQueries_[i] = 0;
+    }
+
+    return true;
+}
+
+void Octree::CreateSpatialIndex()
+{
+    delete spatialIndex_;
+
+    switch (spatialIndexType_)
+    {
+    case SPATIAL_INDEX_LOOSE_OCTREE:
+        spatialIndex_ = new LooseOctree(worldBoundingBox_, numLevels_);
+        break;
+
+    case SPATIAL_INDEX_AABB_TREE:
+        spatialIndex_ = new DynamicAABBTree();
+        break;
+
+    default:
+        spatialIndex_ = 0;
+        return;
+    }
+
+    for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
+        spatialIndex_->InsertDrawable(*i);
+}
+
 void Octree::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
 {
     // When running in headless mode, update the Octree manually during the RenderUpdate event
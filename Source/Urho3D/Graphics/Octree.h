@@ -24,6 +24,7 @@
 
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/OctreeQuery.h"
 
@@ -31,13 +32,39 @@ namespace Urho3D
 {
 
 class Octree;
+class SpatialIndex;
+
+/// Spatial index used by an octree for culling drawable objects.
+enum SpatialIndexType
+{
+    SPATIAL_INDEX_OCTREE = 0,
+    SPATIAL_INDEX_LOOSE_OCTREE,
+    SPATIAL_INDEX_AABB_TREE
+};
 
 static const int NUM_OCTANTS = 8;
 static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
 
+/// Octant to be tested in a worker thread during a threaded octree query, or a range of drawables already found in the top levels.
+struct OctantQueryTask
+{
+    /// Octant. Null for a range of top level results.
+    const Octant* octant_;
+    /// Whether the parent octant was fully inside the query.
+    bool inside_;
+    /// Index of the thread that tested the octant.
+    unsigned threadIndex_;
+    /// Start of the results in the thread's result vector.
+    unsigned resultStart_;
+    /// End of the results in the thread's result vector.
+    unsigned resultEnd_;
+};
+
 /// %Octree octant
 class URHO3D_API Octant
 {
+    friend void GetDrawablesWork(const WorkItem* item, unsigned threadIndex);
+
 public:
     /// Construct.
     Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* root, unsigned index = ROOT_INDEX);
@@ -57,21 +84,28 @@ public:
     void AddDrawable(Drawable* drawable)
     {
         drawable->SetOctant(this);
-        drawables_.Push(drawable);
+        PushDrawable(drawable);
         IncDrawableCount();
     }
 
     /// Remove a drawable object from this octant.
     void RemoveDrawable(Drawable* drawable, bool resetOctant = true)
     {
-        if (drawables_.Remove(drawable))
+        unsigned index = drawable->octantIndex_;
+        if (index < drawables_.Size() && drawables_[index] == drawable)
         {
+            EraseDrawable(index);
             if (resetOctant)
                 drawable->SetOctant(0);
             DecDrawableCount();
         }
     }
 
+    /// Copy a drawable object's current world bounding box to the culling blocks. Called by Octree after the drawable has been updated.
+    void UpdateCullingData(Drawable* drawable);
+    /// Mark a drawable object's culling data stale, so that queries test its actual bounding box until the next octree update. Called by Octree.
+    void MarkCullingDataStale(Drawable* drawable);
+
     /// Return world-space bounding box.
     const BoundingBox& GetWorldBoundingBox() const { return worldBoundingBox_; }
 
@@ -90,6 +124,9 @@ public:
     /// Return number of drawables.
     unsigned GetNumDrawables() const { return numDrawables_; }
 
+    /// Return bounding boxes and flags of the drawables in this octant in structure of arrays layout.
+    const PODVector<DrawableCullingBlock>& GetCullingBlocks() const { return cullingBlocks_; }
+
     /// Return true if there are no drawable objects in this octant and child octants.
     bool IsEmpty() { return numDrawables_ == 0; }
 
@@ -101,8 +138,14 @@ public:
 protected:
     /// Initialize bounding box.
     void Initialize(const BoundingBox& box);
+    /// Append a drawable object and its culling data without changing the drawable count.
+    void PushDrawable(Drawable* drawable);
+    /// Remove a drawable object and its culling data by index without changing the drawable count. The last drawable is moved to its place.
+    void EraseDrawable(unsigned index);
     /// Return drawable objects by a query, called internally.
     void GetDrawablesInternal(OctreeQuery& query, bool inside) const;
+    /// Return drawable objects by a query down to the specified level, and collect the octants below it for worker threads. The ranges of results found meanwhile are collected in between, so that the tasks are in depth-first order. Called internally.
+    void GetDrawablesInternal(OctreeQuery& query, bool inside, unsigned taskLevel, PODVector<OctantQueryTask>& tasks) const;
     /// Return drawable objects by a ray query, called internally.
     void GetDrawablesInternal(RayOctreeQuery& query) const;
     /// Return drawable objects only for a threaded ray query, called internally.
@@ -138,6 +181,8 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     PODVector<Drawable*> drawables_;
+    /// Drawable bounding boxes and flags in the same order as the drawables.
+    PODVector<DrawableCullingBlock> cullingBlocks_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS];
     /// World bounding box center.
@@ -159,7 +204,9 @@ protected:
 /// %Octree component. Should be added only to the root scene node
 class URHO3D_API Octree : public Component, public Octant
 {
+    friend class Octant;
     friend void RaycastDrawablesWork(const WorkItem* item, unsigned threadIndex);
+    friend void GetDrawablesWork(const WorkItem* item, unsigned threadIndex);
 
     URHO3D_OBJECT(Octree, Component);
 
@@ -178,6 +225,8 @@ public:
 
     /// Set size and maximum subdivision levels. If octree is not empty, drawable objects will be temporarily moved to the root.
     void SetSize(const BoundingBox& box, unsigned numLevels);
+    /// Set the spatial index used for culling. With other than the octree type, drawable objects are kept in the root octant and culled by a separate index.
+    void SetSpatialIndexType(SpatialIndexType type);
     /// Update and reinsert drawable objects.
     void Update(const FrameInfo& frame);
     /// Add a drawable manually.
@@ -185,7 +234,7 @@ public:
     /// Remove a manually added drawable.
     void RemoveManualDrawable(Drawable* drawable);
 
-    /// Return drawable objects by a query.
+    /// Return drawable objects by a query. When called from the main thread on a large octree, the octants below the top levels are tested in worker threads if the query can be cloned. Queries through a spatial index other than the octants are not threaded.
     void GetDrawables(OctreeQuery& query) const;
     /// Return drawable objects by a ray query.
     void Raycast(RayOctreeQuery& query) const;
@@ -195,6 +244,12 @@ public:
     /// Return subdivision levels.
     unsigned GetNumLevels() const { return numLevels_; }
 
+    /// Return the spatial index type.
+    SpatialIndexType GetSpatialIndexType() const { return spatialIndexType_; }
+
+    /// Return the spatial index, or null if the octants are used.
+    SpatialIndex* GetSpatialIndex() const { return spatialIndex_; }
+
     /// Mark drawable object as requiring an update and a reinsertion.
     void QueueUpdate(Drawable* drawable);
     /// Cancel drawable object's update.
@@ -205,17 +260,37 @@ public:
 private:
     /// Handle render update in case of headless execution.
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Return drawable objects by a query using worker threads. Return false if the query can not be cloned.
+    bool GetDrawablesThreaded(OctreeQuery& query, WorkQueue* queue) const;
+    /// Create the spatial index according to the type and the octree bounds, and add the drawable objects of the root octant to it.
+    void CreateSpatialIndex();
 
     /// Drawable objects that require update.
     PODVector<Drawable*> drawableUpdates_;
     /// Drawable objects that were inserted during threaded update phase.
     PODVector<Drawable*> threadedDrawableUpdates_;
+    /// Chunking state for the threaded drawable update.
+    ParallelForStats updateDrawablesStats_;
     /// Mutex for octree reinsertions.
     Mutex octreeMutex_;
     /// Ray query temporary list of drawables.
     mutable PODVector<Drawable*> rayQueryDrawables_;
+    /// Octants to test in worker threads during a threaded query.
+    mutable PODVector<OctantQueryTask> queryTasks_;
+    /// Per-thread copies of the query during a threaded query.
+    mutable PODVector<OctreeQuery*> threadQueries_;
+    /// Per-thread results of a threaded query.
+    mutable Vector<PODVector<Drawable*> > threadQueryResults_;
+    /// Top level results of a threaded query.
+    mutable PODVector<Drawable*> topQueryResults_;
+    /// Chunking state for threaded queries.
+    mutable ParallelForStats queryStats_;
     /// Subdivision level.
     unsigned numLevels_;
+    /// Spatial index type.
+    SpatialIndexType spatialIndexType_;
+    /// Spatial index, or null if the octants are used.
+    SpatialIndex* spatialIndex_;
 };
 
 }
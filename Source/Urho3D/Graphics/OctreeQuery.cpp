@@ -24,6 +24,12 @@
 
 #include "../Graphics/OctreeQuery.h"
 
+#include <typeinfo>
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -51,6 +57,14 @@ void PointOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool insi
     }
 }
 
+OctreeQuery* PointOctreeQuery::Clone(PODVector<Drawable*>& result) const
+{
+    if (typeid(*this) != typeid(PointOctreeQuery))
+        return 0;
+
+    return new PointOctreeQuery(result, point_, drawableFlags_, viewMask_);
+}
+
 Intersection SphereOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -73,6 +87,14 @@ void SphereOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool ins
     }
 }
 
+OctreeQuery* SphereOctreeQuery::Clone(PODVector<Drawable*>& result) const
+{
+    if (typeid(*this) != typeid(SphereOctreeQuery))
+        return 0;
+
+    return new SphereOctreeQuery(result, sphere_, drawableFlags_, viewMask_);
+}
+
 Intersection BoxOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -95,6 +117,14 @@ void BoxOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool inside
     }
 }
 
+OctreeQuery* BoxOctreeQuery::Clone(PODVector<Drawable*>& result) const
+{
+    if (typeid(*this) != typeid(BoxOctreeQuery))
+        return 0;
+
+    return new BoxOctreeQuery(result, box_, drawableFlags_, viewMask_);
+}
+
 Intersection FrustumOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -117,6 +147,105 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     }
 }
 
+void FrustumOctreeQuery::TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableCullingBlock* blocks, bool inside)
+{
+    // If the octant is fully inside, only the drawable flags and view mask remain to be tested. For less than a full block
+    // setting up the plane data is not worth it either
+    unsigned numDrawables = (unsigned)(end - start);
+    if (inside || numDrawables < DRAWABLE_CULLING_BLOCK_SIZE)
+    {
+        TestDrawables(start, end, inside);
+        return;
+    }
+
+    unsigned numBlocks = (numDrawables + DRAWABLE_CULLING_BLOCK_SIZE - 1) / DRAWABLE_CULLING_BLOCK_SIZE;
+
+#ifdef URHO3D_SSE
+    __m128 normalX[NUM_FRUSTUM_PLANES];
+    __m128 normalY[NUM_FRUSTUM_PLANES];
+    __m128 normalZ[NUM_FRUSTUM_PLANES];
+    __m128 absNormalX[NUM_FRUSTUM_PLANES];
+    __m128 absNormalY[NUM_FRUSTUM_PLANES];
+    __m128 absNormalZ[NUM_FRUSTUM_PLANES];
+    __m128 planeD[NUM_FRUSTUM_PLANES];
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Plane& plane = frustum_.planes_[i];
+        normalX[i] = _mm_set1_ps(plane.normal_.x_);
+        normalY[i] = _mm_set1_ps(plane.normal_.y_);
+        normalZ[i] = _mm_set1_ps(plane.normal_.z_);
+        absNormalX[i] = _mm_set1_ps(plane.absNormal_.x_);
+        absNormalY[i] = _mm_set1_ps(plane.absNormal_.y_);
+        absNormalZ[i] = _mm_set1_ps(plane.absNormal_.z_);
+        planeD[i] = _mm_set1_ps(plane.d_);
+    }
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+#endif
+
+    for (unsigned i = 0; i < numBlocks; ++i)
+    {
+        const DrawableCullingBlock& block = blocks[i];
+
+        // Build a mask of the bounding boxes that are not outside any of the planes. Same test as Frustum::IsInsideFast()
+        unsigned visibleMask = 0;
+#ifdef URHO3D_SSE
+        __m128 minX = _mm_loadu_ps(block.minX_);
+        __m128 minY = _mm_loadu_ps(block.minY_);
+        __m128 minZ = _mm_loadu_ps(block.minZ_);
+        __m128 centerX = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(block.maxX_), minX), half);
+        __m128 centerY = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(block.maxY_), minY), half);
+        __m128 centerZ = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(block.maxZ_), minZ), half);
+        __m128 edgeX = _mm_sub_ps(centerX, minX);
+        __m128 edgeY = _mm_sub_ps(centerY, minY);
+        __m128 edgeZ = _mm_sub_ps(centerZ, minZ);
+        __m128 outside = zero;
+
+        for (unsigned j = 0; j < NUM_FRUSTUM_PLANES; ++j)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX[j], centerX), _mm_mul_ps(normalY[j], centerY)),
+                _mm_mul_ps(normalZ[j], centerZ)), planeD[j]);
+            __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absNormalX[j], edgeX), _mm_mul_ps(absNormalY[j], edgeY)),
+                _mm_mul_ps(absNormalZ[j], edgeZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(zero, absDist)));
+        }
+
+        visibleMask = ~(unsigned)_mm_movemask_ps(outside);
+#else
+        for (unsigned j = 0; j < DRAWABLE_CULLING_BLOCK_SIZE; ++j)
+        {
+            BoundingBox box(Vector3(block.minX_[j], block.minY_[j], block.minZ_[j]),
+                Vector3(block.maxX_[j], block.maxY_[j], block.maxZ_[j]));
+            if (frustum_.IsInsideFast(box) == INSIDE)
+                visibleMask |= 1 << j;
+        }
+#endif
+
+        // Let TestDrawables() do the rest of the filtering. Unused slots have zero flags and are skipped
+        Drawable** blockStart = start + i * DRAWABLE_CULLING_BLOCK_SIZE;
+        for (unsigned j = 0; j < DRAWABLE_CULLING_BLOCK_SIZE; ++j)
+        {
+            unsigned flags = block.flags_[j];
+            if (!(flags & drawableFlags_))
+                continue;
+
+            // Drawables that have changed since the last octree update are tested with their actual bounding box
+            if (flags & DRAWABLE_CULLING_STALE)
+                TestDrawables(blockStart + j, blockStart + j + 1, false);
+            else if (visibleMask & (1 << j))
+                TestDrawables(blockStart + j, blockStart + j + 1, true);
+        }
+    }
+}
+
+OctreeQuery* FrustumOctreeQuery::Clone(PODVector<Drawable*>& result) const
+{
+    if (typeid(*this) != typeid(FrustumOctreeQuery))
+        return 0;
+
+    return new FrustumOctreeQuery(result, frustum_, drawableFlags_, viewMask_);
+}
+
 
 Intersection AllContentOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
@@ -134,4 +263,12 @@ void AllContentOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool
     }
 }
 
+OctreeQuery* AllContentOctreeQuery::Clone(PODVector<Drawable*>& result) const
+{
+    if (typeid(*this) != typeid(AllContentOctreeQuery))
+        return 0;
+
+    return new AllContentOctreeQuery(result, drawableFlags_, viewMask_);
+}
+
 }
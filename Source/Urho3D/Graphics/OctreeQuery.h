@@ -34,6 +34,30 @@ namespace Urho3D
 class Drawable;
 class Node;
 
+/// Number of drawables in a culling block.
+static const unsigned DRAWABLE_CULLING_BLOCK_SIZE = 4;
+/// Culling block flag for a drawable whose bounding box has changed since the last octree update.
+static const unsigned DRAWABLE_CULLING_STALE = 0x100;
+
+/// World bounding boxes and flags of an octant's drawables in structure of arrays layout, for testing several drawables at once.
+struct DrawableCullingBlock
+{
+    /// Bounding box minimum X coordinates.
+    float minX_[DRAWABLE_CULLING_BLOCK_SIZE];
+    /// Bounding box minimum Y coordinates.
+    float minY_[DRAWABLE_CULLING_BLOCK_SIZE];
+    /// Bounding box minimum Z coordinates.
+    float minZ_[DRAWABLE_CULLING_BLOCK_SIZE];
+    /// Bounding box maximum X coordinates.
+    float maxX_[DRAWABLE_CULLING_BLOCK_SIZE];
+    /// Bounding box maximum Y coordinates.
+    float maxY_[DRAWABLE_CULLING_BLOCK_SIZE];
+    /// Bounding box maximum Z coordinates.
+    float maxZ_[DRAWABLE_CULLING_BLOCK_SIZE];
+    /// Drawable flags, combined with the stale flag. Zero for unused slots.
+    unsigned flags_[DRAWABLE_CULLING_BLOCK_SIZE];
+};
+
 /// Base class for octree queries.
 class URHO3D_API OctreeQuery
 {
@@ -55,6 +79,13 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Intersection test for drawables with their bounding boxes and flags also available in culling blocks. By default calls TestDrawables().
+    virtual void TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableCullingBlock* blocks, bool inside)
+    {
+        TestDrawables(start, end, inside);
+    }
+    /// Return a copy of the query that writes to another result vector, for testing parts of the octree in worker threads. The copy must be safe to use from a worker thread. Return null if not supported (default.) The built-in queries copy only their exact class, as a subclass may test drawables differently.
+    virtual OctreeQuery* Clone(PODVector<Drawable*>& result) const { return 0; }
 
     /// Result vector reference.
     PODVector<Drawable*>& result_;
@@ -86,6 +117,8 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside);
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside);
+    /// Return a copy of the query that writes to another result vector. Return null for subclasses.
+    virtual OctreeQuery* Clone(PODVector<Drawable*>& result) const;
 
     /// Point.
     Vector3 point_;
@@ -107,6 +140,8 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside);
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside);
+    /// Return a copy of the query that writes to another result vector. Return null for subclasses.
+    virtual OctreeQuery* Clone(PODVector<Drawable*>& result) const;
 
     /// Sphere.
     Sphere sphere_;
@@ -128,12 +163,14 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside);
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside);
+    /// Return a copy of the query that writes to another result vector. Return null for subclasses.
+    virtual OctreeQuery* Clone(PODVector<Drawable*>& result) const;
 
     /// Bounding box.
     BoundingBox box_;
 };
 
-/// %Frustum octree query.
+/// %Frustum octree query. Subclasses that filter drawables further should do so in TestDrawables(), which is called with inside = true for the drawables that pass the frustum and drawable flags tests.
 class URHO3D_API FrustumOctreeQuery : public OctreeQuery
 {
 public:
@@ -149,6 +186,10 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside);
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside);
+    /// Intersection test for drawables in culling blocks. Tests the frustum planes against four bounding boxes at a time.
+    virtual void TestDrawableBlocks(Drawable** start, Drawable** end, const DrawableCullingBlock* blocks, bool inside);
+    /// Return a copy of the query that writes to another result vector. Return null for subclasses.
+    virtual OctreeQuery* Clone(PODVector<Drawable*>& result) const;
 
     /// Frustum.
     Frustum frustum_;
@@ -269,6 +310,8 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside);
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside);
+    /// Return a copy of the query that writes to another result vector. Return null for subclasses.
+    virtual OctreeQuery* Clone(PODVector<Drawable*>& result) const;
 };
 
 }
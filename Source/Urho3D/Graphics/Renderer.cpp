@@ -613,6 +613,7 @@ unsigned Renderer::GetNumOccluders(bool allViews) const
 void Renderer::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdateViews);
+    URHO3D_MEMORY_CATEGORY(MC_RENDERER);
 
     views_.Clear();
     preparedViews_.Clear();
@@ -661,6 +662,7 @@ void Renderer::Render()
     assert(graphics_ && graphics_->IsInitialized() && !graphics_->IsDeviceLost());
 
     URHO3D_PROFILE(RenderViews);
+    URHO3D_MEMORY_CATEGORY(MC_RENDERER);
 
     // If the indirection textures have lost content (OpenGL mode only), restore them now
     if (faceSelectCubeMap_ && faceSelectCubeMap_->IsDataLost())
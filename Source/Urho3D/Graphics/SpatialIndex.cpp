@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/SpatialIndex.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+SpatialIndex::SpatialIndex() :
+    numDrawables_(0)
+{
+}
+
+SpatialIndex::~SpatialIndex()
+{
+}
+
+void SpatialIndex::InsertDrawable(Drawable* drawable)
+{
+    if (drawable->IsOccludee())
+        InsertProxy(drawable);
+    else
+        AddUnculled(drawable);
+
+    ++numDrawables_;
+}
+
+void SpatialIndex::RemoveDrawable(Drawable* drawable)
+{
+    if (GetProxy(drawable) & UNCULLED_PROXY_FLAG)
+        RemoveUnculled(drawable);
+    else
+        RemoveProxy(drawable);
+
+    SetProxy(drawable, M_MAX_UNSIGNED);
+    --numDrawables_;
+}
+
+void SpatialIndex::UpdateDrawable(Drawable* drawable)
+{
+    bool unculled = (GetProxy(drawable) & UNCULLED_PROXY_FLAG) != 0;
+
+    // Move between the unculled list and the index if the occludee flag has changed
+    if (unculled == drawable->IsOccludee())
+    {
+        if (unculled)
+        {
+            RemoveUnculled(drawable);
+            InsertProxy(drawable);
+        }
+        else
+        {
+            RemoveProxy(drawable);
+            AddUnculled(drawable);
+        }
+    }
+    else if (!unculled)
+        UpdateProxy(drawable);
+}
+
+void SpatialIndex::GetDrawables(OctreeQuery& query) const
+{
+    if (unculledDrawables_.Size())
+    {
+        Drawable** start = const_cast<Drawable**>(&unculledDrawables_[0]);
+        query.TestDrawables(start, start + unculledDrawables_.Size(), false);
+    }
+
+    GetProxies(query);
+}
+
+void SpatialIndex::GetDrawables(const RayOctreeQuery& query, PODVector<Drawable*>& result) const
+{
+    for (PODVector<Drawable*>::ConstIterator i = unculledDrawables_.Begin(); i != unculledDrawables_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+            result.Push(drawable);
+    }
+
+    GetProxies(query, result);
+}
+
+void SpatialIndex::AddUnculled(Drawable* drawable)
+{
+    SetProxy(drawable, unculledDrawables_.Size() | UNCULLED_PROXY_FLAG);
+    unculledDrawables_.Push(drawable);
+}
+
+void SpatialIndex::RemoveUnculled(Drawable* drawable)
+{
+    unsigned index = GetProxy(drawable) & ~UNCULLED_PROXY_FLAG;
+    Drawable* last = unculledDrawables_.Back();
+    unculledDrawables_[index] = last;
+    SetProxy(last, index | UNCULLED_PROXY_FLAG);
+    unculledDrawables_.Pop();
+}
+
+}
@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/Drawable.h"
+#include "../Graphics/OctreeQuery.h"
+
+namespace Urho3D
+{
+
+class DebugRenderer;
+
+/// Proxy flag for drawables that are kept in the unculled list.
+static const unsigned UNCULLED_PROXY_FLAG = 0x80000000;
+
+/// Spatial index that an Octree can use instead of its octants for culling drawable objects. Drawables that are not occludees are kept in an unculled list, so that occlusion of the index nodes does not hide them. Queries through a spatial index run on the calling thread; threaded octree queries apply only when the octree culls with its octants.
+class URHO3D_API SpatialIndex
+{
+public:
+    /// Construct.
+    SpatialIndex();
+    /// Destruct.
+    virtual ~SpatialIndex();
+
+    /// Add a drawable object.
+    void InsertDrawable(Drawable* drawable);
+    /// Remove a drawable object.
+    void RemoveDrawable(Drawable* drawable);
+    /// Update a drawable object after its bounding box or occludee flag has changed.
+    void UpdateDrawable(Drawable* drawable);
+    /// Return drawable objects by a query.
+    void GetDrawables(OctreeQuery& query) const;
+    /// Return drawable objects whose index nodes a ray query hits, filtered by the query's drawable flags and view mask.
+    void GetDrawables(const RayOctreeQuery& query, PODVector<Drawable*>& result) const;
+
+    /// Draw the index nodes to the debug geometry.
+    virtual void DrawDebugGeometry(DebugRenderer* debug, bool depthTest) = 0;
+
+    /// Return number of drawable objects.
+    unsigned GetNumDrawables() const { return numDrawables_; }
+
+protected:
+    /// Add a drawable object to the index and set its proxy.
+    virtual void InsertProxy(Drawable* drawable) = 0;
+    /// Remove a drawable object from the index.
+    virtual void RemoveProxy(Drawable* drawable) = 0;
+    /// Update a drawable object in the index after its bounding box has changed.
+    virtual void UpdateProxy(Drawable* drawable) = 0;
+    /// Return drawable objects in the index by a query.
+    virtual void GetProxies(OctreeQuery& query) const = 0;
+    /// Return drawable objects in the index by a ray query.
+    virtual void GetProxies(const RayOctreeQuery& query, PODVector<Drawable*>& result) const = 0;
+
+    /// Return a drawable object's proxy.
+    static unsigned GetProxy(const Drawable* drawable) { return drawable->spatialIndexProxy_; }
+    /// Set a drawable object's proxy.
+    static void SetProxy(Drawable* drawable, unsigned proxy) { drawable->spatialIndexProxy_ = proxy; }
+
+private:
+    /// Add a drawable object to the unculled list.
+    void AddUnculled(Drawable* drawable);
+    /// Remove a drawable object from the unculled list.
+    void RemoveUnculled(Drawable* drawable);
+
+    /// Drawable objects that are tested without culling by the index nodes.
+    PODVector<Drawable*> unculledDrawables_;
+    /// Number of drawable objects.
+    unsigned numDrawables_;
+};
+
+}
@@ -91,6 +91,12 @@ public:
             }
         }
     }
+
+    /// Return a copy of the query that writes to another result vector.
+    virtual OctreeQuery* Clone(PODVector<Drawable*>& result) const
+    {
+        return new ShadowCasterOctreeQuery(result, frustum_, drawableFlags_, viewMask_);
+    }
 };
 
 /// %Frustum octree query for zones and occluders.
@@ -120,6 +126,12 @@ public:
             }
         }
     }
+
+    /// Return a copy of the query that writes to another result vector.
+    virtual OctreeQuery* Clone(PODVector<Drawable*>& result) const
+    {
+        return new ZoneOccluderOctreeQuery(result, frustum_, drawableFlags_, viewMask_);
+    }
 };
 
 /// %Frustum octree query with occlusion.
@@ -163,6 +175,12 @@ public:
         }
     }
 
+    /// Return a copy of the query that writes to another result vector. The occlusion buffer is only read, so it can be shared.
+    virtual OctreeQuery* Clone(PODVector<Drawable*>& result) const
+    {
+        return new OccludedFrustumOctreeQuery(result, frustum_, buffer_, drawableFlags_, viewMask_);
+    }
+
     /// Occlusion buffer.
     OcclusionBuffer* buffer_;
 };
@@ -236,12 +254,22 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
     }
 }
 
+static void CombineSceneResults(PerThreadSceneResult& dest, const PerThreadSceneResult& source)
+{
+    dest.geometries_.Push(source.geometries_);
+    dest.lights_.Push(source.lights_);
+    dest.minZ_ = Min(dest.minZ_, source.minZ_);
+    dest.maxZ_ = Max(dest.maxZ_, source.maxZ_);
+}
+
 void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
 {
     View* view = reinterpret_cast<View*>(item->aux_);
-    LightQueryResult* query = reinterpret_cast<LightQueryResult*>(item->start_);
+    LightQueryResult* start = reinterpret_cast<LightQueryResult*>(item->start_);
+    LightQueryResult* end = reinterpret_cast<LightQueryResult*>(item->end_);
 
-    view->ProcessLight(*query, threadIndex);
+    while (start != end)
+        view->ProcessLight(*start++, threadIndex);
 }
 
 void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
@@ -273,18 +301,19 @@ void SortBatchQueueBackToFrontWork(const WorkItem* item, unsigned threadIndex)
     queue->SortBackToFront();
 }
 
-void SortLightQueueWork(const WorkItem* item, unsigned threadIndex)
+void SortLightQueuesWork(const WorkItem* item, unsigned threadIndex)
 {
     LightBatchQueue* start = reinterpret_cast<LightBatchQueue*>(item->start_);
-    start->litBaseBatches_.SortFrontToBack();
-    start->litBatches_.SortFrontToBack();
-}
+    LightBatchQueue* end = reinterpret_cast<LightBatchQueue*>(item->end_);
 
-void SortShadowQueueWork(const WorkItem* item, unsigned threadIndex)
-{
-    LightBatchQueue* start = reinterpret_cast<LightBatchQueue*>(item->start_);
-    for (unsigned i = 0; i < start->shadowSplits_.Size(); ++i)
-        start->shadowSplits_[i].shadowBatches_.SortFrontToBack();
+    while (start != end)
+    {
+        start->litBaseBatches_.SortFrontToBack();
+        start->litBatches_.SortFrontToBack();
+        for (unsigned i = 0; i < start->shadowSplits_.Size(); ++i)
+            start->shadowSplits_[i].shadowBatches_.SortFrontToBack();
+        ++start;
+    }
 }
 
 StringHash ParseTextureTypeXml(ResourceCache* cache, String filename);
@@ -293,6 +322,7 @@ View::View(Context* context) :
     Object(context),
     graphics_(GetSubsystem<Graphics>()),
     renderer_(GetSubsystem<Renderer>()),
+    frameAllocator_(GetSubsystem<FrameAllocator>()),
     scene_(0),
     octree_(0),
     cullCamera_(0),
@@ -308,6 +338,7 @@ View::View(Context* context) :
     unsigned numThreads = GetSubsystem<WorkQueue>()->GetNumThreads() + 1; // Worker threads + main thread
     tempDrawables_.Resize(numThreads);
     sceneResults_.Resize(numThreads);
+    frameAllocator_->SetNumThreads(numThreads);
     frame_.camera_ = 0;
 }
 
@@ -892,58 +923,16 @@ void View::GetDrawables()
             result.maxZ_ = 0.0f;
         }
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
-
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
-        {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+        queue->ParallelReduce(tempDrawables.Begin(), tempDrawables.End(), CheckVisibilityWork, this,
+            sceneResults_, CombineSceneResults, &checkVisibilityStats_);
     }
 
-    // Combine lights, geometries & scene Z range from the threads
-    geometries_.Clear();
-    lights_.Clear();
-    minZ_ = M_INFINITY;
-    maxZ_ = 0.0f;
-
-    if (sceneResults_.Size() > 1)
-    {
-        for (unsigned i = 0; i < sceneResults_.Size(); ++i)
-        {
-            PerThreadSceneResult& result = sceneResults_[i];
-            geometries_.Push(result.geometries_);
-            lights_.Push(result.lights_);
-            minZ_ = Min(minZ_, result.minZ_);
-            maxZ_ = Max(maxZ_, result.maxZ_);
-        }
-    }
-    else
-    {
-        // If just 1 thread, copy the results directly
-        PerThreadSceneResult& result = sceneResults_[0];
-        minZ_ = result.minZ_;
-        maxZ_ = result.maxZ_;
-        Swap(geometries_, result.geometries_);
-        Swap(lights_, result.lights_);
-    }
+    // Take the lights, geometries & scene Z range combined from the threads
+    PerThreadSceneResult& result = sceneResults_[0];
+    minZ_ = result.minZ_;
+    maxZ_ = result.maxZ_;
+    Swap(geometries_, result.geometries_);
+    Swap(lights_, result.lights_);
 
     if (minZ_ == M_INFINITY)
         minZ_ = 0.0f;
@@ -979,23 +968,11 @@ void View::ProcessLights()
 
     WorkQueue* queue = GetSubsystem<WorkQueue>();
     lightQueryResults_.Resize(lights_.Size());
-
     for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
-    {
-        SharedPtr<WorkItem> item = queue->GetFreeItem();
-        item->priority_ = M_MAX_UNSIGNED;
-        item->workFunction_ = ProcessLightWork;
-        item->aux_ = this;
-
-        LightQueryResult& query = lightQueryResults_[i];
-        query.light_ = lights_[i];
-
-        item->start_ = &query;
-        queue->AddWorkItem(item);
-    }
+        lightQueryResults_[i].light_ = lights_[i];
 
     // Ensure all lights have been processed before proceeding
-    queue->Complete(M_MAX_UNSIGNED);
+    queue->ParallelFor(lightQueryResults_.Begin(), lightQueryResults_.End(), ProcessLightWork, this, &processLightsStats_);
 }
 
 void View::GetLightBatches()
@@ -1069,7 +1046,7 @@ void View::GetLightBatches()
                     FinalizeShadowCamera(shadowCamera, light, shadowQueue.shadowViewport_, query.shadowCasterBox_[j]);
 
                     // Loop through shadow casters
-                    for (PODVector<Drawable*>::ConstIterator k = query.shadowCasters_.Begin() + query.shadowCasterBegin_[j];
+                    for (FrameVector<Drawable*>::ConstIterator k = query.shadowCasters_.Begin() + query.shadowCasterBegin_[j];
                          k < query.shadowCasters_.Begin() + query.shadowCasterEnd_[j]; ++k)
                     {
                         Drawable* drawable = *k;
@@ -1110,7 +1087,7 @@ void View::GetLightBatches()
                 }
 
                 // Process lit geometries
-                for (PODVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
+                for (FrameVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
                 {
                     Drawable* drawable = *j;
                     drawable->AddLight(light);
@@ -1145,7 +1122,7 @@ void View::GetLightBatches()
             else
             {
                 // Add the vertex light to lit drawables. It will be processed later during base pass batch generation
-                for (PODVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
+                for (FrameVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
                 {
                     Drawable* drawable = *j;
                     drawable->AddVertexLight(light);
@@ -1163,7 +1140,7 @@ void View::GetLightBatches()
         {
             Drawable* drawable = *i;
             drawable->LimitLights();
-            const PODVector<Light*>& lights = drawable->GetLights();
+            const DrawableLights& lights = drawable->GetLights();
 
             for (unsigned i = 0; i < lights.Size(); ++i)
             {
@@ -1226,7 +1203,7 @@ void View::GetBaseBatches()
 
                 if (info.vertexLights_)
                 {
-                    const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
+                    const DrawableLights& drawableVertexLights = drawable->GetVertexLights();
                     if (drawableVertexLights.Size() && !vertexLightsProcessed)
                     {
                         // Limit vertex lights. If this is a deferred opaque batch, remove converted per-pixel lights,
@@ -1277,8 +1254,10 @@ void View::UpdateGeometries()
     URHO3D_PROFILE(SortAndUpdateGeometry);
 
     WorkQueue* queue = GetSubsystem<WorkQueue>();
+    Vector<SharedPtr<WorkItem> > items;
 
-    // Sort batches
+    // Sort batches. The scene pass queues are not stored contiguously and each needs its own sort function, so they get a work
+    // item each
     {
         for (unsigned i = 0; i < renderPath_->commands_.Size(); ++i)
         {
@@ -1294,26 +1273,11 @@ void View::UpdateGeometries()
                     command.sortMode_ == SORT_FRONTTOBACK ? SortBatchQueueFrontToBackWork : SortBatchQueueBackToFrontWork;
                 item->start_ = &batchQueues_[command.passIndex_];
                 queue->AddWorkItem(item);
+                items.Push(item);
             }
         }
 
-        for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
-        {
-            SharedPtr<WorkItem> lightItem = queue->GetFreeItem();
-            lightItem->priority_ = M_MAX_UNSIGNED;
-            lightItem->workFunction_ = SortLightQueueWork;
-            lightItem->start_ = &(*i);
-            queue->AddWorkItem(lightItem);
-
-            if (i->shadowSplits_.Size())
-            {
-                SharedPtr<WorkItem> shadowItem = queue->GetFreeItem();
-                shadowItem->priority_ = M_MAX_UNSIGNED;
-                shadowItem->workFunction_ = SortShadowQueueWork;
-                shadowItem->start_ = &(*i);
-                queue->AddWorkItem(shadowItem);
-            }
-        }
+        queue->AddParallelWorkItems(lightQueues_.Begin(), lightQueues_.End(), SortLightQueuesWork, 0, 0, M_MAX_UNSIGNED, &items);
     }
 
     // Update geometries. Split into threaded and non-threaded updates.
@@ -1332,26 +1296,8 @@ void View::UpdateGeometries()
                 }
             }
 
-            int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-            int drawablesPerItem = threadedGeometries_.Size() / numWorkItems;
-
-            PODVector<Drawable*>::Iterator start = threadedGeometries_.Begin();
-            for (int i = 0; i < numWorkItems; ++i)
-            {
-                PODVector<Drawable*>::Iterator end = threadedGeometries_.End();
-                if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                    end = start + drawablesPerItem;
-
-                SharedPtr<WorkItem> item = queue->GetFreeItem();
-                item->priority_ = M_MAX_UNSIGNED;
-                item->workFunction_ = UpdateDrawableGeometriesWork;
-                item->aux_ = const_cast<FrameInfo*>(&frame_);
-                item->start_ = &(*start);
-                item->end_ = &(*end);
-                queue->AddWorkItem(item);
-
-                start = end;
-            }
+            queue->AddParallelWorkItems(threadedGeometries_.Begin(), threadedGeometries_.End(),
+                UpdateDrawableGeometriesWork, const_cast<FrameInfo*>(&frame_), 0, M_MAX_UNSIGNED, &items);
         }
 
         // While the work queue is processed, update non-threaded geometries
@@ -1360,7 +1306,7 @@ void View::UpdateGeometries()
     }
 
     // Finally ensure all threaded work has completed
-    queue->Complete(M_MAX_UNSIGNED);
+    queue->CompleteItems(items);
     geometriesUpdated_ = true;
 }
 
@@ -2229,7 +2175,8 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
 #endif
     // Get lit geometries. They must match the light mask and be inside the main camera frustum to be considered
     PODVector<Drawable*>& tempDrawables = tempDrawables_[threadIndex];
-    query.litGeometries_.Clear();
+    query.litGeometries_.SetAllocator(frameAllocator_, threadIndex);
+    query.shadowCasters_.SetAllocator(frameAllocator_, threadIndex);
 
     switch (type)
     {
@@ -2279,7 +2226,6 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
     SetupShadowCameras(query);
 
     // Process each split for shadow casters
-    query.shadowCasters_.Clear();
     for (unsigned i = 0; i < query.numSplits_; ++i)
     {
         Camera* shadowCamera = query.shadowCameras_[i];
@@ -2820,6 +2766,7 @@ void View::AddBatchToQueue(BatchQueue& batchQueue, Batch& batch, Technique* tech
             // Create a new group based on the batch
             // In case the group remains below the instancing limit, do not enable instancing shaders yet
             BatchGroup newGroup(batch);
+            newGroup.instances_.SetAllocator(frameAllocator_);
             newGroup.geometryType_ = GEOM_STATIC;
             renderer_->SetBatchShaders(newGroup, tech, allowShadows);
             newGroup.CalculateSortKey();
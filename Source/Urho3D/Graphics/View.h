@@ -25,6 +25,7 @@
 #include "../Container/HashSet.h"
 #include "../Container/List.h"
 #include "../Core/Object.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Light.h"
 #include "../Graphics/Zone.h"
@@ -56,10 +57,10 @@ struct LightQueryResult
 {
     /// Light.
     Light* light_;
-    /// Lit geometries.
-    PODVector<Drawable*> litGeometries_;
-    /// Shadow casters.
-    PODVector<Drawable*> shadowCasters_;
+    /// Lit geometries. Allocated from the frame allocator.
+    FrameVector<Drawable*> litGeometries_;
+    /// Shadow casters. Allocated from the frame allocator.
+    FrameVector<Drawable*> shadowCasters_;
     /// Shadow cameras.
     Camera* shadowCameras_[MAX_LIGHT_SPLITS];
     /// Shadow caster start indices.
@@ -285,10 +286,10 @@ private:
     }
 
     /// Return hash code for a vertex light queue.
-    unsigned long long GetVertexLightQueueHash(const PODVector<Light*>& vertexLights)
+    unsigned long long GetVertexLightQueueHash(const DrawableLights& vertexLights)
     {
         unsigned long long hash = 0;
-        for (PODVector<Light*>::ConstIterator i = vertexLights.Begin(); i != vertexLights.End(); ++i)
+        for (DrawableLights::ConstIterator i = vertexLights.Begin(); i != vertexLights.End(); ++i)
             hash += (unsigned long long)(*i);
         return hash;
     }
@@ -297,6 +298,8 @@ private:
     WeakPtr<Graphics> graphics_;
     /// Renderer subsystem.
     WeakPtr<Renderer> renderer_;
+    /// Frame allocator subsystem.
+    WeakPtr<FrameAllocator> frameAllocator_;
     /// Scene to use.
     Scene* scene_;
     /// Octree to use.
@@ -371,6 +374,8 @@ private:
     Vector<PODVector<Drawable*> > tempDrawables_;
     /// Per-thread geometries, lights and Z range collection results.
     Vector<PerThreadSceneResult> sceneResults_;
+    /// Chunking state for the threaded visibility check.
+    ParallelForStats checkVisibilityStats_;
     /// Visible zones.
     PODVector<Zone*> zones_;
     /// Visible geometry objects.
@@ -392,6 +397,8 @@ private:
     HashMap<StringHash, Texture*> renderTargets_;
     /// Intermediate light processing results.
     Vector<LightQueryResult> lightQueryResults_;
+    /// Chunking state for the threaded light processing.
+    ParallelForStats processLightsStats_;
     /// Info for scene render passes defined by the renderpath.
     PODVector<ScenePassInfo> scenePasses_;
     /// Per-pixel light queues.
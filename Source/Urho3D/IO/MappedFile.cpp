@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../IO/File.h"
+#include "../IO/Log.h"
+#include "../IO/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+#include <cstdio>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+MappedFile::MappedFile(Context* context) :
+    Object(context),
+    data_(0),
+    size_(0),
+    view_(0),
+    viewSize_(0),
+    mapping_(0)
+{
+}
+
+MappedFile::MappedFile(Context* context, const String& fileName) :
+    Object(context),
+    data_(0),
+    size_(0),
+    view_(0),
+    viewSize_(0),
+    mapping_(0)
+{
+    Open(fileName);
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const String& fileName)
+{
+    File file(context_);
+    if (!file.Open(fileName, FILE_READ))
+    {
+        Close();
+        return false;
+    }
+
+    return Open(&file);
+}
+
+bool MappedFile::Open(File* file)
+{
+    Close();
+
+    if (!file || !file->IsOpen() || file->GetMode() != FILE_READ)
+    {
+        URHO3D_LOGERROR("File not open for reading, can not map");
+        return false;
+    }
+
+    fileName_ = file->GetName();
+    unsigned position = file->GetPosition();
+    unsigned size = file->GetSize() - position;
+    if (!size)
+    {
+        URHO3D_LOGERROR("No data to map from " + fileName_);
+        return false;
+    }
+
+    // Packaged files may be compressed and Android assets have no file handle, so only map regular files
+    FILE* handle = static_cast<FILE*>(file->GetHandle());
+    if (handle && !file->IsPackaged())
+    {
+#ifdef _WIN32
+        HANDLE fileHandle = (HANDLE)_get_osfhandle(_fileno(handle));
+        mapping_ = CreateFileMappingW(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+        if (mapping_)
+        {
+            view_ = MapViewOfFile((HANDLE)mapping_, FILE_MAP_READ, 0, 0, 0);
+            if (!view_)
+            {
+                CloseHandle((HANDLE)mapping_);
+                mapping_ = 0;
+            }
+        }
+#else
+        void* view = mmap(0, position + size, PROT_READ, MAP_PRIVATE, fileno(handle), 0);
+        if (view != MAP_FAILED)
+            view_ = view;
+#endif
+        if (view_)
+        {
+            viewSize_ = position + size;
+            data_ = static_cast<const unsigned char*>(view_) + position;
+            size_ = size;
+            return true;
+        }
+    }
+
+    // Fall back to reading the rest of the file into memory
+    buffer_.Resize(size);
+    if (file->Read(&buffer_[0], size) != size)
+    {
+        URHO3D_LOGERROR("Could not read " + fileName_);
+        buffer_.Clear();
+        return false;
+    }
+
+    data_ = &buffer_[0];
+    size_ = size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (view_)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(view_);
+        CloseHandle((HANDLE)mapping_);
+        mapping_ = 0;
+#else
+        munmap(view_, viewSize_);
+#endif
+        view_ = 0;
+        viewSize_ = 0;
+    }
+
+    buffer_.Clear();
+    buffer_.Compact();
+    data_ = 0;
+    size_ = 0;
+}
+
+}
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+
+namespace Urho3D
+{
+
+class File;
+
+/// Read-only memory mapping of a file. Files that cannot be mapped, such as files inside packages, are read into memory instead.
+class URHO3D_API MappedFile : public Object
+{
+    URHO3D_OBJECT(MappedFile, Object);
+
+public:
+    /// Construct.
+    MappedFile(Context* context);
+    /// Construct and map a filesystem file.
+    MappedFile(Context* context, const String& fileName);
+    /// Destruct. Unmap the file if mapped.
+    virtual ~MappedFile();
+
+    /// Map a filesystem file. Return true if successful.
+    bool Open(const String& fileName);
+    /// Map the contents of an open file from its current position to the end. The file can be closed afterward. Return true if successful.
+    bool Open(File* file);
+    /// Unmap the file and release the data.
+    void Close();
+
+    /// Return the data.
+    const unsigned char* GetData() const { return data_; }
+
+    /// Return the data size in bytes.
+    unsigned GetSize() const { return size_; }
+
+    /// Return the file name.
+    const String& GetName() const { return fileName_; }
+
+    /// Return whether has data.
+    bool IsOpen() const { return data_ != 0; }
+
+    /// Return whether the data is memory-mapped instead of read into memory.
+    bool IsMapped() const { return view_ != 0; }
+
+private:
+    /// File name.
+    String fileName_;
+    /// Start of the data.
+    const unsigned char* data_;
+    /// Data size.
+    unsigned size_;
+    /// Start of the mapped view.
+    void* view_;
+    /// Size of the mapped view.
+    unsigned viewSize_;
+    /// File mapping handle on Windows.
+    void* mapping_;
+    /// Data read into memory when mapping is not possible.
+    PODVector<unsigned char> buffer_;
+};
+
+}
@@ -517,7 +517,16 @@ PODVector<CrowdAgent*> CrowdManager::GetAgents(Node* node, bool inCrowdFilter) c
     if (!node)
         node = GetScene();
     PODVector<CrowdAgent*> agents;
-    node->GetComponents<CrowdAgent>(agents, true);
+    // Use the scene's type registry instead of walking the whole hierarchy
+    if (node && node == GetScene())
+    {
+        const PODVector<Component*>& components = GetScene()->GetComponentsByType(CrowdAgent::GetTypeStatic());
+        agents.Resize(components.Size());
+        for (unsigned i = 0; i < components.Size(); ++i)
+            agents[i] = static_cast<CrowdAgent*>(components[i]);
+    }
+    else
+        node->GetComponents<CrowdAgent>(agents, true);
     if (inCrowdFilter)
     {
         PODVector<CrowdAgent*>::Iterator i = agents.Begin();
@@ -453,6 +453,7 @@ bool Network::CheckRemoteEvent(StringHash eventType) const
 void Network::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdateNetwork);
+    URHO3D_MEMORY_CATEGORY(MC_NETWORK);
 
     // Process server connection if it exists
     if (serverConnection_)
@@ -427,9 +427,6 @@ CollisionShape::CollisionShape(Context* context) :
 CollisionShape::~CollisionShape()
 {
     ReleaseShape();
-
-    if (physicsWorld_)
-        physicsWorld_->RemoveCollisionShape(this);
 }
 
 void CollisionShape::RegisterObject(Context* context)
@@ -939,7 +936,6 @@ void CollisionShape::OnSceneSet(Scene* scene)
             URHO3D_LOGWARNING(GetTypeName() + " should not be created to the root scene node");
 
         physicsWorld_ = scene->GetOrCreateComponent<PhysicsWorld>();
-        physicsWorld_->AddCollisionShape(this);
 
         // Create shape now if necessary (attributes modified before adding to scene)
         if (retryCreation_)
@@ -952,9 +948,6 @@ void CollisionShape::OnSceneSet(Scene* scene)
     {
         ReleaseShape();
 
-        if (physicsWorld_)
-            physicsWorld_->RemoveCollisionShape(this);
-
         // Recreate when moved to a scene again
         retryCreation_ = true;
     }
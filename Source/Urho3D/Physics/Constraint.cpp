@@ -75,9 +75,6 @@ Constraint::Constraint(Context* context) :
 Constraint::~Constraint()
 {
     ReleaseConstraint();
-
-    if (physicsWorld_)
-        physicsWorld_->RemoveConstraint(this);
 }
 
 void Constraint::RegisterObject(Context* context)
@@ -457,7 +454,6 @@ void Constraint::OnSceneSet(Scene* scene)
             URHO3D_LOGWARNING(GetTypeName() + " should not be created to the root scene node");
 
         physicsWorld_ = scene->GetOrCreateComponent<PhysicsWorld>();
-        physicsWorld_->AddConstraint(this);
 
         // Create constraint now if necessary (attributes modified before adding to scene)
         if (retryCreation_)
@@ -467,9 +463,6 @@ void Constraint::OnSceneSet(Scene* scene)
     {
         ReleaseConstraint();
 
-        if (physicsWorld_)
-            physicsWorld_->RemoveConstraint(this);
-
         // Recreate when moved to a scene again
         retryCreation_ = true;
     }
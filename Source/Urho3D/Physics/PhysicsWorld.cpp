@@ -153,15 +153,32 @@ PhysicsWorld::~PhysicsWorld()
 {
     if (scene_)
     {
-        // Force all remaining constraints, rigid bodies and collision shapes to release themselves
-        for (PODVector<Constraint*>::Iterator i = constraints_.Begin(); i != constraints_.End(); ++i)
-            (*i)->ReleaseConstraint();
+        // Force all remaining constraints, rigid bodies and collision shapes to release themselves. Find them from the scene's
+        // component registry
+        PODVector<Component*> components;
+        scene_->GetDerivedComponentsByType(components, Constraint::GetTypeStatic());
+        for (PODVector<Component*>::Iterator i = components.Begin(); i != components.End(); ++i)
+        {
+            Constraint* constraint = static_cast<Constraint*>(*i);
+            if (constraint->GetPhysicsWorld() == this)
+                constraint->ReleaseConstraint();
+        }
 
-        for (PODVector<RigidBody*>::Iterator i = rigidBodies_.Begin(); i != rigidBodies_.End(); ++i)
-            (*i)->ReleaseBody();
+        scene_->GetDerivedComponentsByType(components, RigidBody::GetTypeStatic());
+        for (PODVector<Component*>::Iterator i = components.Begin(); i != components.End(); ++i)
+        {
+            RigidBody* body = static_cast<RigidBody*>(*i);
+            if (body->GetPhysicsWorld() == this)
+                body->ReleaseBody();
+        }
 
-        for (PODVector<CollisionShape*>::Iterator i = collisionShapes_.Begin(); i != collisionShapes_.End(); ++i)
-            (*i)->ReleaseShape();
+        scene_->GetDerivedComponentsByType(components, CollisionShape::GetTypeStatic());
+        for (PODVector<Component*>::Iterator i = components.Begin(); i != components.End(); ++i)
+        {
+            CollisionShape* shape = static_cast<CollisionShape*>(*i);
+            if (shape->GetPhysicsWorld() == this)
+                shape->ReleaseShape();
+        }
     }
 
     delete world_;
@@ -238,6 +255,7 @@ void PhysicsWorld::draw3dText(const btVector3& location, const char* textString)
 void PhysicsWorld::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdatePhysics);
+    URHO3D_MEMORY_CATEGORY(MC_PHYSICS);
 
     float internalTimeStep = 1.0f / fps_;
     int maxSubSteps = (int)(timeStep * fps_) + 1;
@@ -705,38 +723,12 @@ bool PhysicsWorld::GetSplitImpulse() const
     return world_->getSolverInfo().m_splitImpulse != 0;
 }
 
-void PhysicsWorld::AddRigidBody(RigidBody* body)
-{
-    rigidBodies_.Push(body);
-}
-
 void PhysicsWorld::RemoveRigidBody(RigidBody* body)
 {
-    rigidBodies_.Remove(body);
     // Remove possible dangling pointer from the delayedWorldTransforms structure
     delayedWorldTransforms_.Erase(body);
 }
 
-void PhysicsWorld::AddCollisionShape(CollisionShape* shape)
-{
-    collisionShapes_.Push(shape);
-}
-
-void PhysicsWorld::RemoveCollisionShape(CollisionShape* shape)
-{
-    collisionShapes_.Remove(shape);
-}
-
-void PhysicsWorld::AddConstraint(Constraint* constraint)
-{
-    constraints_.Push(constraint);
-}
-
-void PhysicsWorld::RemoveConstraint(Constraint* constraint)
-{
-    constraints_.Remove(constraint);
-}
-
 void PhysicsWorld::AddDelayedWorldTransform(const DelayedWorldTransform& transform)
 {
     delayedWorldTransforms_[transform.rigidBody_] = transform;
@@ -211,18 +211,8 @@ public:
     /// Return maximum angular velocity for network replication.
     float GetMaxNetworkAngularVelocity() const { return maxNetworkAngularVelocity_; }
 
-    /// Add a rigid body to keep track of. Called by RigidBody.
-    void AddRigidBody(RigidBody* body);
     /// Remove a rigid body. Called by RigidBody.
     void RemoveRigidBody(RigidBody* body);
-    /// Add a collision shape to keep track of. Called by CollisionShape.
-    void AddCollisionShape(CollisionShape* shape);
-    /// Remove a collision shape. Called by CollisionShape.
-    void RemoveCollisionShape(CollisionShape* shape);
-    /// Add a constraint to keep track of. Called by Constraint.
-    void AddConstraint(Constraint* joint);
-    /// Remove a constraint. Called by Constraint.
-    void RemoveConstraint(Constraint* joint);
     /// Add a delayed world transform assignment. Called by RigidBody.
     void AddDelayedWorldTransform(const DelayedWorldTransform& transform);
     /// Add debug geometry to the debug renderer.
@@ -279,12 +269,6 @@ private:
     btDiscreteDynamicsWorld* world_;
     /// Extra weak pointer to scene to allow for cleanup in case the world is destroyed before other components.
     WeakPtr<Scene> scene_;
-    /// Rigid bodies in the world.
-    PODVector<RigidBody*> rigidBodies_;
-    /// Collision shapes in the world.
-    PODVector<CollisionShape*> collisionShapes_;
-    /// Constraints in the world.
-    PODVector<Constraint*> constraints_;
     /// Collision pairs on this frame.
     HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, btPersistentManifold*> currentCollisions_;
     /// Collision pairs on the previous frame. Used to check if a collision is "new." Manifolds are not guaranteed to exist anymore.
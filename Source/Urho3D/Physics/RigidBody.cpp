@@ -941,7 +941,6 @@ void RigidBody::OnSceneSet(Scene* scene)
             URHO3D_LOGWARNING(GetTypeName() + " should not be created to the root scene node");
 
         physicsWorld_ = scene->GetOrCreateComponent<PhysicsWorld>();
-        physicsWorld_->AddRigidBody(this);
 
         AddBodyToWorld();
     }
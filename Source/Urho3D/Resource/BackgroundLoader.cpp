@@ -50,6 +50,13 @@ BackgroundLoader::~BackgroundLoader()
 
 void BackgroundLoader::ThreadFunction()
 {
+#ifdef URHO3D_PROFILING
+    Profiler* profiler = owner_->GetSubsystem<Profiler>();
+    if (profiler)
+        profiler->SetThreadName("BackgroundLoader");
+#endif
+    URHO3D_MEMORY_CATEGORY(MC_RESOURCE);
+
     while (shouldRun_)
     {
         backgroundLoadMutex_.Acquire();
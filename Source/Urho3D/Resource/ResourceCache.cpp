@@ -561,6 +561,8 @@ Resource* ResourceCache::GetExistingResource(StringHash type, const String& name
 
 Resource* ResourceCache::GetResource(StringHash type, const String& nameIn, bool sendEventOnFailure)
 {
+    URHO3D_MEMORY_CATEGORY(MC_RESOURCE);
+
     String name = SanitateResourceName(nameIn);
 
     if (!Thread::IsMainThread())
@@ -62,13 +62,19 @@ void AttributeAnimationInfo::ApplyValue(const Variant& newValue)
     if (animatable)
     {
         animatable->OnSetAttribute(attributeInfo_, newValue);
-        animatable->ApplyAttributes();
+        if (animatable->applyingAnimationBatch_)
+            animatable->animationBatchApplied_ = true;
+        else
+            animatable->ApplyAttributes();
     }
 }
 
 Animatable::Animatable(Context* context) :
     Serializable(context),
-    animationEnabled_(true)
+    animationEnabled_(true),
+    attributeAnimationIndex_(M_MAX_UNSIGNED),
+    applyingAnimationBatch_(false),
+    animationBatchApplied_(false)
 {
 }
 
@@ -350,14 +356,9 @@ void Animatable::SetAttributeAnimation(const String& name, ValueAnimation* attri
                 return;
             }
 
-            for (Vector<AttributeInfo>::ConstIterator i = attributes->Begin(); i != attributes->End(); ++i)
-            {
-                if (name == (*i).name_)
-                {
-                    attributeInfo = &(*i);
-                    break;
-                }
-            }
+            unsigned index = GetAttributeIndex(name);
+            if (index != M_MAX_UNSIGNED)
+                attributeInfo = &attributes->At(index);
         }
 
         if (!attributeInfo)
@@ -512,23 +513,57 @@ void Animatable::OnObjectAnimationRemoved(ObjectAnimation* objectAnimation)
         SetObjectAttributeAnimation(i->first_, 0, WM_LOOP, 1.0f);
 }
 
-void Animatable::UpdateAttributeAnimations(float timeStep)
+void Animatable::PrepareAttributeAnimations()
+{
+    for (HashMap<String, SharedPtr<AttributeAnimationInfo> >::ConstIterator i = attributeAnimationInfos_.Begin();
+         i != attributeAnimationInfos_.End(); ++i)
+    {
+        ValueAnimation* animation = i->second_->GetAnimation();
+        if (animation)
+            animation->PrepareEvaluation();
+    }
+}
+
+void Animatable::EvaluateAttributeAnimations(float timeStep)
 {
     if (!animationEnabled_)
         return;
 
+    for (HashMap<String, SharedPtr<AttributeAnimationInfo> >::ConstIterator i = attributeAnimationInfos_.Begin();
+         i != attributeAnimationInfos_.End(); ++i)
+        i->second_->Evaluate(timeStep);
+}
+
+void Animatable::ApplyAttributeAnimations()
+{
     Vector<String> finishedNames;
+    applyingAnimationBatch_ = true;
+    animationBatchApplied_ = false;
+
     for (HashMap<String, SharedPtr<AttributeAnimationInfo> >::ConstIterator i = attributeAnimationInfos_.Begin();
          i != attributeAnimationInfos_.End(); ++i)
     {
-        if (i->second_->Update(timeStep))
+        if (i->second_->ApplyEvaluated())
             finishedNames.Push(i->second_->GetAttributeInfo().name_);
     }
 
+    applyingAnimationBatch_ = false;
+    if (animationBatchApplied_)
+        ApplyAttributes();
+
     for (unsigned i = 0; i < finishedNames.Size(); ++i)
         SetAttributeAnimation(finishedNames[i], 0);
 }
 
+void Animatable::UpdateAttributeAnimations(float timeStep)
+{
+    if (!animationEnabled_)
+        return;
+
+    EvaluateAttributeAnimations(timeStep);
+    ApplyAttributeAnimations();
+}
+
 bool Animatable::IsAnimatedNetworkAttribute(const AttributeInfo& attrInfo) const
 {
     return animatedNetworkAttributes_.Find(&attrInfo) != animatedNetworkAttributes_.End();
@@ -64,6 +64,9 @@ class URHO3D_API Animatable : public Serializable
 {
     URHO3D_OBJECT(Animatable, Serializable);
 
+    friend class AttributeAnimationInfo;
+    friend class Scene;
+
 public:
     /// Construct.
     Animatable(Context* context);
@@ -101,9 +104,17 @@ public:
     void RemoveObjectAnimation();
     /// Remove attribute animation. Same as calling SetAttributeAnimation with a null pointer.
     void RemoveAttributeAnimation(const String& name);
+    /// Calculate spline tangents of the attribute animations, so that they can be evaluated on worker threads.
+    void PrepareAttributeAnimations();
+    /// Advance the attribute animations and calculate their values without applying them. Can be called from a worker thread after PrepareAttributeAnimations(), if the animations are not shared with objects outside the batch that are updated meanwhile.
+    void EvaluateAttributeAnimations(float timeStep);
+    /// Apply the values calculated by EvaluateAttributeAnimations(), then apply attributes once. Remove finished animations.
+    void ApplyAttributeAnimations();
 
     /// Return animation enabled.
     bool GetAnimationEnabled() const { return animationEnabled_; }
+    /// Return whether has attribute animations.
+    bool HasAttributeAnimations() const { return !attributeAnimationInfos_.Empty(); }
 
     /// Return object animation.
     ObjectAnimation* GetObjectAnimation() const;
@@ -153,6 +164,14 @@ protected:
     HashSet<const AttributeInfo*> animatedNetworkAttributes_;
     /// Attribute animation infos.
     HashMap<String, SharedPtr<AttributeAnimationInfo> > attributeAnimationInfos_;
+
+private:
+    /// Index in the scene's attribute animation update, managed by Scene.
+    unsigned attributeAnimationIndex_;
+    /// Applying a batch of attribute animations flag. ApplyAttributes() is deferred to the end of the batch.
+    bool applyingAnimationBatch_;
+    /// Attribute values set during the batch flag.
+    bool animationBatchApplied_;
 };
 
 }
@@ -49,7 +49,8 @@ Component::Component(Context* context) :
     node_(0),
     id_(0),
     networkUpdate_(false),
-    enabled_(true)
+    enabled_(true),
+    typeIndex_(M_MAX_UNSIGNED)
 {
 }
 
@@ -57,6 +58,16 @@ Component::~Component()
 {
 }
 
+void* Component::operator new(size_t size)
+{
+    return AllocateMemory((unsigned)size);
+}
+
+void Component::operator delete(void* ptr, size_t size)
+{
+    FreeMemory(ptr, (unsigned)size);
+}
+
 bool Component::Save(Serializer& dest) const
 {
     // Write type and ID
@@ -225,14 +236,16 @@ void Component::CleanupConnection(Connection* connection)
 
 void Component::OnAttributeAnimationAdded()
 {
-    if (attributeAnimationInfos_.Size() == 1)
-        SubscribeToEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE, URHO3D_HANDLER(Component, HandleAttributeAnimationUpdate));
+    Scene* scene = GetScene();
+    if (attributeAnimationInfos_.Size() == 1 && scene)
+        scene->AddAttributeAnimationTarget(this);
 }
 
 void Component::OnAttributeAnimationRemoved()
 {
-    if (attributeAnimationInfos_.Empty())
-        UnsubscribeFromEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE);
+    Scene* scene = GetScene();
+    if (attributeAnimationInfos_.Empty() && scene)
+        scene->RemoveAttributeAnimationTarget(this);
 }
 
 void Component::OnNodeSet(Node* node)
@@ -280,13 +293,6 @@ void Component::GetComponents(PODVector<Component*>& dest, StringHash type) cons
         dest.Clear();
 }
 
-void Component::HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData)
-{
-    using namespace AttributeAnimationUpdate;
-
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
-}
-
 Component* Component::GetFixedUpdateSource()
 {
     Component* ret = 0;
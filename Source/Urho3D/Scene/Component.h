@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Scene/Animatable.h"
+#include "../Scene/SceneEvents.h"
 
 namespace Urho3D
 {
@@ -47,6 +48,17 @@ public:
     /// Destruct.
     virtual ~Component();
 
+    /// Allocate component memory from the engine size class pools, so that components of the same type share a pool.
+    static void* operator new(size_t size);
+    /// Free component memory back to the engine size class pools.
+    static void operator delete(void* ptr, size_t size);
+#if defined(_MSC_VER) && defined(_DEBUG)
+    /// Allocate component memory when DebugNew.h redefines new.
+    static void* operator new(size_t size, int blockType, const char* file, int line) { return operator new(size); }
+    /// Match the debug operator new. Only called if a constructor throws, which the engine does not do.
+    static void operator delete(void* ptr, int blockType, const char* file, int line) { }
+#endif
+
     /// Handle enabled/disabled state change.
     virtual void OnSetEnabled() { }
 
@@ -115,8 +127,6 @@ protected:
     void SetID(unsigned id);
     /// Set scene node. Called by Node when creating the component.
     void SetNode(Node* node);
-    /// Handle scene attribute animation update event.
-    void HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData);
     /// Return a component from the scene root that sends out fixed update events (either PhysicsWorld or PhysicsWorld2D). Return null if neither exists.
     Component* GetFixedUpdateSource();
 
@@ -128,6 +138,10 @@ protected:
     bool networkUpdate_;
     /// Enabled flag.
     bool enabled_;
+
+private:
+    /// Index in the scene's per-type component registry.
+    unsigned typeIndex_;
 };
 
 template <class T> T* Component::GetComponent() const { return static_cast<T*>(GetComponent(T::GetTypeStatic())); }
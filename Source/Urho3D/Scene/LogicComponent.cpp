@@ -37,7 +37,11 @@ LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
-    delayedStartCalled_(false)
+    parallelMask_(0),
+    parallelUpdateIndex_(M_MAX_UNSIGNED),
+    parallelPostUpdateIndex_(M_MAX_UNSIGNED),
+    delayedStartCalled_(false),
+    threadSafeUpdate_(false)
 {
 }
 
@@ -75,6 +79,15 @@ void LogicComponent::SetUpdateEventMask(unsigned char mask)
     }
 }
 
+void LogicComponent::SetThreadSafeUpdate(bool enable)
+{
+    if (threadSafeUpdate_ != enable)
+    {
+        threadSafeUpdate_ = enable;
+        UpdateEventSubscription();
+    }
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -102,6 +115,7 @@ void LogicComponent::OnSceneSet(Scene* scene)
         UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
 #endif
         currentEventMask_ = 0;
+        UpdateParallelUpdate(0, 0);
     }
 }
 
@@ -113,10 +127,16 @@ void LogicComponent::UpdateEventSubscription()
 
     bool enabled = IsEnabledEffective();
 
-    bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
+    // Thread-safe components move to the parallel phases once the delayed start has been called from an update event
+    unsigned char parallelMask = 0;
+    if (enabled && threadSafeUpdate_ && delayedStartCalled_)
+        parallelMask = updateEventMask_ & (USE_UPDATE | USE_POSTUPDATE);
+    UpdateParallelUpdate(scene, parallelMask);
+
+    bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_) && !(parallelMask & USE_UPDATE);
     if (needUpdate && !(currentEventMask_ & USE_UPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(LogicComponent, HandleSceneUpdate));
+        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_TYPED_HANDLER(LogicComponent, HandleSceneUpdate));
         currentEventMask_ |= USE_UPDATE;
     }
     else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
@@ -125,13 +145,13 @@ void LogicComponent::UpdateEventSubscription()
         currentEventMask_ &= ~USE_UPDATE;
     }
 
-    bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
+    bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE) && !(parallelMask & USE_POSTUPDATE);
     if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(LogicComponent, HandleScenePostUpdate));
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_TYPED_HANDLER(LogicComponent, HandleScenePostUpdate));
         currentEventMask_ |= USE_POSTUPDATE;
     }
-    else if (!needUpdate && (currentEventMask_ & USE_POSTUPDATE))
+    else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
     {
         UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
         currentEventMask_ &= ~USE_POSTUPDATE;
@@ -168,16 +188,21 @@ void LogicComponent::UpdateEventSubscription()
 #endif
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleSceneUpdate(StringHash eventType, const SceneUpdate::Data& eventData)
 {
-    using namespace SceneUpdate;
-
     // Execute user-defined delayed start function before first update
     if (!delayedStartCalled_)
     {
         DelayedStart();
         delayedStartCalled_ = true;
 
+        // Thread-safe components get their first update in the parallel phase that follows this event
+        if (threadSafeUpdate_)
+        {
+            UpdateEventSubscription();
+            return;
+        }
+
         // If did not need actual update events, unsubscribe now
         if (!(updateEventMask_ & USE_UPDATE))
         {
@@ -188,15 +213,34 @@ void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventDa
     }
 
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::HandleScenePostUpdate(StringHash eventType, const ScenePostUpdate::Data& eventData)
 {
-    using namespace ScenePostUpdate;
-
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(eventData.timeStep_);
+}
+
+void LogicComponent::UpdateParallelUpdate(Scene* scene, unsigned char mask)
+{
+    // Remove from both phases of the old scene, as a registration change delayed during a parallel phase may still be pending
+    if (parallelScene_ != scene)
+    {
+        if (parallelScene_)
+            parallelScene_->RemoveParallelUpdate(this, USE_UPDATE | USE_POSTUPDATE);
+        parallelMask_ = 0;
+    }
+    parallelScene_ = scene;
+
+    if (mask != parallelMask_)
+    {
+        if (parallelMask_ & ~mask)
+            scene->RemoveParallelUpdate(this, parallelMask_ & ~mask);
+        if (mask & ~parallelMask_)
+            scene->AddParallelUpdate(this, mask & ~parallelMask_);
+        parallelMask_ = mask;
+    }
 }
 
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
@@ -210,6 +254,8 @@ void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& even
     {
         DelayedStart();
         delayedStartCalled_ = true;
+        if (threadSafeUpdate_)
+            UpdateEventSubscription();
     }
 
     // Execute user-defined fixed update function
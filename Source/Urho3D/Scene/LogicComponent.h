@@ -41,6 +41,8 @@ class URHO3D_API LogicComponent : public Component
 {
     URHO3D_OBJECT(LogicComponent, Component);
 
+    friend class Scene;
+
     /// Construct.
     LogicComponent(Context* context);
     /// Destruct.
@@ -70,9 +72,15 @@ class URHO3D_API LogicComponent : public Component
     /// Set what update events should be subscribed to. Use this for optimization: by default all are in use. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
     void SetUpdateEventMask(unsigned char mask);
 
+    /// Set whether Update() and PostUpdate() are safe to call from worker threads. If so, they are called in parallel after the scene update and post-update events instead of from the events. They may then only modify their own node and components, and must queue structural changes through the scene's Delayed functions. Like the update event mask, this should be called in the subclass constructor.
+    void SetThreadSafeUpdate(bool enable);
+
     /// Return what update events are subscribed to.
     unsigned char GetUpdateEventMask() const { return updateEventMask_; }
 
+    /// Return whether Update() and PostUpdate() are safe to call from worker threads.
+    bool IsThreadSafeUpdate() const { return threadSafeUpdate_; }
+
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
 
@@ -85,10 +93,12 @@ protected:
 private:
     /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
     void UpdateEventSubscription();
+    /// Add to or remove from the scene's parallel update phases.
+    void UpdateParallelUpdate(Scene* scene, unsigned char mask);
     /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneUpdate(StringHash eventType, const SceneUpdate::Data& eventData);
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(StringHash eventType, const ScenePostUpdate::Data& eventData);
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
     /// Handle physics pre-step event.
     void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
@@ -99,8 +109,18 @@ private:
     unsigned char updateEventMask_;
     /// Current event subscription mask.
     unsigned char currentEventMask_;
+    /// Current parallel update mask.
+    unsigned char parallelMask_;
+    /// Scene of the parallel updates.
+    WeakPtr<Scene> parallelScene_;
+    /// Index in the scene's parallel update list.
+    unsigned parallelUpdateIndex_;
+    /// Index in the scene's parallel post-update list.
+    unsigned parallelPostUpdateIndex_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
+    /// Thread-safe update flag.
+    bool threadSafeUpdate_;
 };
 
 }
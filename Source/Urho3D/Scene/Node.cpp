@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../Resource/XMLFile.h"
@@ -54,6 +55,10 @@ Node::Node(Context* context) :
     enabledPrev_(true),
     parent_(0),
     scene_(0),
+    transformStore_(0),
+    transformIndex_(M_MAX_UNSIGNED),
+    transformPendingIndex_(M_MAX_UNSIGNED),
+    markedDirtyIndex_(M_MAX_UNSIGNED),
     id_(0),
     position_(Vector3::ZERO),
     rotation_(Quaternion::IDENTITY),
@@ -101,7 +106,7 @@ bool Node::Load(Deserializer& source, bool setInstanceDefault)
     resolver.AddNode(nodeID, this);
 
     // Read attributes, components and child nodes
-    bool success = Load(source, resolver);
+    bool success = Load(source, resolver, true, false, REPLICATED, setInstanceDefault);
     if (success)
     {
         resolver.Resolve();
@@ -161,7 +166,7 @@ bool Node::LoadXML(const XMLElement& source, bool setInstanceDefault)
     resolver.AddNode(nodeID, this);
 
     // Read attributes, components and child nodes
-    bool success = LoadXML(source, resolver);
+    bool success = LoadXML(source, resolver, true, false, REPLICATED, setInstanceDefault);
     if (success)
     {
         resolver.Resolve();
@@ -180,7 +185,7 @@ bool Node::LoadJSON(const JSONValue& source, bool setInstanceDefault)
     resolver.AddNode(nodeID, this);
 
     // Read attributes, components and child nodes
-    bool success = LoadJSON(source, resolver);
+    bool success = LoadJSON(source, resolver, true, false, REPLICATED, setInstanceDefault);
     if (success)
     {
         resolver.Resolve();
@@ -358,15 +363,18 @@ void Node::AddTag(const String& tag)
     tags_.Push(tag);
 
     // Cache
-    scene_->NodeTagAdded(this, tag);
+    if (scene_)
+    {
+        scene_->NodeTagAdded(this, tag);
 
-    // Send event
-    using namespace NodeTagAdded;
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_SCENE] = scene_;
-    eventData[P_NODE] = this;
-    eventData[P_TAG] = tag;
-    scene_->SendEvent(E_NODETAGADDED, eventData);
+        // Send event
+        using namespace NodeTagAdded;
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_SCENE] = scene_;
+        eventData[P_NODE] = this;
+        eventData[P_TAG] = tag;
+        scene_->SendEvent(E_NODETAGADDED, eventData);
+    }
 
     // Sync
     MarkNetworkUpdate();
@@ -728,6 +736,24 @@ void Node::SetOwner(Connection* owner)
 }
 
 void Node::MarkDirty()
+{
+    // With a transform store, mark only this node on the main thread. The store reaches the children in its next update.
+    // Nodes without children or not yet stored, worker threads and threaded updates mark recursively
+    if (transformStore_ && transformIndex_ != M_MAX_UNSIGNED && !children_.Empty() && Thread::IsMainThread() &&
+        !scene_->IsThreadedUpdate())
+    {
+        if (!dirty_)
+        {
+            dirty_ = true;
+            NotifyListeners();
+        }
+        transformStore_->MarkPending(this);
+    }
+    else
+        MarkDirtyRecursive();
+}
+
+void Node::MarkDirtyRecursive()
 {
     Node *cur = this;
     for (;;)
@@ -744,21 +770,7 @@ void Node::MarkDirty()
         cur->dirty_ = true;
 
         // Notify listener components first, then mark child nodes
-        for (Vector<WeakPtr<Component> >::Iterator i = cur->listeners_.Begin(); i != cur->listeners_.End();)
-        {
-            Component *c = *i;
-            if (c)
-            {
-                c->OnMarkedDirty(cur);
-                ++i;
-            }
-            // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
-            else
-            {
-                *i = cur->listeners_.Back();
-                cur->listeners_.Pop();
-            }
-        }
+        cur->NotifyListeners();
 
         // Tail call optimization: Don't recurse to mark the first child dirty, but
         // instead process it in the context of the current function. If there are more
@@ -768,7 +780,7 @@ void Node::MarkDirty()
         {
             Node *next = *i;
             for (++i; i != cur->children_.End(); ++i)
-                (*i)->MarkDirty();
+                (*i)->MarkDirtyRecursive();
             cur = next;
         }
         else
@@ -830,6 +842,8 @@ void Node::AddChild(Node* node, unsigned index)
         scene_->NodeAdded(node);
 
     node->parent_ = this;
+    if (node->transformStore_)
+        node->transformStore_->ReparentNode(node);
     node->MarkDirty();
     node->MarkNetworkUpdate();
 
@@ -1117,7 +1131,7 @@ void Node::AddListener(Component* component)
 
     listeners_.Push(WeakPtr<Component>(component));
     // If the node is currently dirty, notify immediately
-    if (dirty_)
+    if (IsDirty())
         component->OnMarkedDirty(this);
 }
 
@@ -1351,7 +1365,18 @@ void Node::SetID(unsigned id)
 
 void Node::SetScene(Scene* scene)
 {
+    // A queued dirty notification is discarded when leaving the scene
+    if (markedDirtyIndex_ != M_MAX_UNSIGNED && scene != scene_)
+        scene_->CancelMarkedDirty(this);
+
+    if (transformStore_)
+        transformStore_->RemoveNode(this);
+
     scene_ = scene;
+
+    transformStore_ = scene && scene != this ? scene->GetTransformStore() : 0;
+    if (transformStore_)
+        transformStore_->AddNode(this);
 }
 
 void Node::ResetScene()
@@ -1456,14 +1481,15 @@ const PODVector<unsigned char>& Node::GetNetParentAttr() const
     return attrBuffer_.GetBuffer();
 }
 
-bool Node::Load(Deserializer& source, SceneResolver& resolver, bool readChildren, bool rewriteIDs, CreateMode mode)
+bool Node::Load(Deserializer& source, SceneResolver& resolver, bool readChildren, bool rewriteIDs, CreateMode mode,
+    bool setInstanceDefault)
 {
     // Remove all children and components first in case this is not a fresh load
     RemoveAllChildren();
     RemoveAllComponents();
 
     // ID has been read at the parent level
-    if (!Animatable::Load(source))
+    if (!Animatable::Load(source, setInstanceDefault))
         return false;
 
     unsigned numComponents = source.ReadVLE();
@@ -1479,7 +1505,7 @@ bool Node::Load(Deserializer& source, SceneResolver& resolver, bool readChildren
         {
             resolver.AddComponent(compID, newComponent);
             // Do not abort if component fails to load, as the component buffer is nested and we can skip to the next
-            newComponent->Load(compBuffer);
+            newComponent->Load(compBuffer, setInstanceDefault);
         }
     }
 
@@ -1493,20 +1519,21 @@ bool Node::Load(Deserializer& source, SceneResolver& resolver, bool readChildren
         Node* newNode = CreateChild(rewriteIDs ? 0 : nodeID, (mode == REPLICATED && nodeID < FIRST_LOCAL_ID) ? REPLICATED :
             LOCAL);
         resolver.AddNode(nodeID, newNode);
-        if (!newNode->Load(source, resolver, readChildren, rewriteIDs, mode))
+        if (!newNode->Load(source, resolver, readChildren, rewriteIDs, mode, setInstanceDefault))
             return false;
     }
 
     return true;
 }
 
-bool Node::LoadXML(const XMLElement& source, SceneResolver& resolver, bool readChildren, bool rewriteIDs, CreateMode mode)
+bool Node::LoadXML(const XMLElement& source, SceneResolver& resolver, bool readChildren, bool rewriteIDs, CreateMode mode,
+    bool setInstanceDefault)
 {
     // Remove all children and components first in case this is not a fresh load
     RemoveAllChildren();
     RemoveAllComponents();
 
-    if (!Animatable::LoadXML(source))
+    if (!Animatable::LoadXML(source, setInstanceDefault))
         return false;
 
     XMLElement compElem = source.GetChild("component");
@@ -1519,7 +1546,7 @@ bool Node::LoadXML(const XMLElement& source, SceneResolver& resolver, bool readC
         if (newComponent)
         {
             resolver.AddComponent(compID, newComponent);
-            if (!newComponent->LoadXML(compElem))
+            if (!newComponent->LoadXML(compElem, setInstanceDefault))
                 return false;
         }
 
@@ -1536,7 +1563,7 @@ bool Node::LoadXML(const XMLElement& source, SceneResolver& resolver, bool readC
         Node* newNode = CreateChild(rewriteIDs ? 0 : nodeID, (mode == REPLICATED && nodeID < FIRST_LOCAL_ID) ? REPLICATED :
             LOCAL);
         resolver.AddNode(nodeID, newNode);
-        if (!newNode->LoadXML(childElem, resolver, readChildren, rewriteIDs, mode))
+        if (!newNode->LoadXML(childElem, resolver, readChildren, rewriteIDs, mode, setInstanceDefault))
             return false;
 
         childElem = childElem.GetNext("node");
@@ -1545,13 +1572,14 @@ bool Node::LoadXML(const XMLElement& source, SceneResolver& resolver, bool readC
     return true;
 }
 
-bool Node::LoadJSON(const JSONValue& source, SceneResolver& resolver, bool readChildren, bool rewriteIDs, CreateMode mode)
+bool Node::LoadJSON(const JSONValue& source, SceneResolver& resolver, bool readChildren, bool rewriteIDs, CreateMode mode,
+    bool setInstanceDefault)
 {
     // Remove all children and components first in case this is not a fresh load
     RemoveAllChildren();
     RemoveAllComponents();
 
-    if (!Animatable::LoadJSON(source))
+    if (!Animatable::LoadJSON(source, setInstanceDefault))
         return false;
 
     const JSONArray& componentsArray = source.Get("components").GetArray();
@@ -1566,7 +1594,7 @@ bool Node::LoadJSON(const JSONValue& source, SceneResolver& resolver, bool readC
         if (newComponent)
         {
             resolver.AddComponent(compID, newComponent);
-            if (!newComponent->LoadJSON(compVal))
+            if (!newComponent->LoadJSON(compVal, setInstanceDefault))
                 return false;
         }
     }
@@ -1583,7 +1611,7 @@ bool Node::LoadJSON(const JSONValue& source, SceneResolver& resolver, bool readC
         Node* newNode = CreateChild(rewriteIDs ? 0 : nodeID, (mode == REPLICATED && nodeID < FIRST_LOCAL_ID) ? REPLICATED :
             LOCAL);
         resolver.AddNode(nodeID, newNode);
-        if (!newNode->LoadJSON(childVal, resolver, readChildren, rewriteIDs, mode))
+        if (!newNode->LoadJSON(childVal, resolver, readChildren, rewriteIDs, mode, setInstanceDefault))
             return false;
     }
 
@@ -1817,14 +1845,14 @@ void Node::SetTransformSilent(const Vector3& position, const Quaternion& rotatio
 
 void Node::OnAttributeAnimationAdded()
 {
-    if (attributeAnimationInfos_.Size() == 1)
-        SubscribeToEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE, URHO3D_HANDLER(Node, HandleAttributeAnimationUpdate));
+    if (attributeAnimationInfos_.Size() == 1 && scene_)
+        scene_->AddAttributeAnimationTarget(this);
 }
 
 void Node::OnAttributeAnimationRemoved()
 {
-    if (attributeAnimationInfos_.Empty())
-        UnsubscribeFromEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE);
+    if (attributeAnimationInfos_.Empty() && scene_)
+        scene_->RemoveAttributeAnimationTarget(this);
 }
 
 Animatable* Node::FindAttributeAnimationTarget(const String& name, String& outName)
@@ -1992,6 +2020,31 @@ Component* Node::SafeCreateComponent(const String& typeName, StringHash type, Cr
 }
 
 void Node::UpdateWorldTransform() const
+{
+    if (transformStore_ && transformStore_->HasPendingChanges())
+    {
+        // With a transform store the node is not marked dirty when a parent moves, so check the parent chain. On the main
+        // thread mark the pending parents' children dirty now so that the result stays cached, otherwise just recalculate
+        bool resolve = Thread::IsMainThread() && !scene_->IsThreadedUpdate();
+        bool parentPending = false;
+        for (Node* parent = parent_; parent && parent != scene_; parent = parent->parent_)
+        {
+            if (parent->transformPendingIndex_ != M_MAX_UNSIGNED)
+            {
+                parentPending = true;
+                if (resolve)
+                    transformStore_->ResolvePending(parent);
+            }
+        }
+
+        if (!dirty_ && !parentPending)
+            return;
+    }
+
+    CalculateWorldTransform();
+}
+
+void Node::CalculateWorldTransform() const
 {
     Matrix3x4 transform = GetTransform();
 
@@ -2010,6 +2063,51 @@ void Node::UpdateWorldTransform() const
     dirty_ = false;
 }
 
+bool Node::IsParentTransformPending() const
+{
+    for (Node* parent = parent_; parent && parent != scene_; parent = parent->parent_)
+    {
+        if (parent->transformPendingIndex_ != M_MAX_UNSIGNED)
+            return true;
+    }
+
+    return false;
+}
+
+void Node::NotifyListeners()
+{
+    if (listeners_.Empty())
+        return;
+
+    // Coalesce notifications into the scene's queue when deferred. Threaded updates notify immediately as before
+    if (scene_ && scene_->IsDeferredDirtyEnabled() && !scene_->IsThreadedUpdate() && Thread::IsMainThread())
+    {
+        if (markedDirtyIndex_ == M_MAX_UNSIGNED)
+            scene_->QueueMarkedDirty(this);
+    }
+    else
+        SendMarkedDirty();
+}
+
+void Node::SendMarkedDirty()
+{
+    for (Vector<WeakPtr<Component> >::Iterator i = listeners_.Begin(); i != listeners_.End();)
+    {
+        Component *c = *i;
+        if (c)
+        {
+            c->OnMarkedDirty(this);
+            ++i;
+        }
+        // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
+        else
+        {
+            *i = listeners_.Back();
+            listeners_.Pop();
+        }
+    }
+}
+
 void Node::RemoveChild(Vector<SharedPtr<Node> >::Iterator i)
 {
     // Send change event. Do not send when already being destroyed
@@ -2150,11 +2248,4 @@ void Node::RemoveComponent(Vector<SharedPtr<Component> >::Iterator i)
     components_.Erase(i);
 }
 
-void Node::HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData)
-{
-    using namespace AttributeAnimationUpdate;
-
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
-}
-
 }
@@ -25,6 +25,8 @@
 #include "../IO/VectorBuffer.h"
 #include "../Math/Matrix3x4.h"
 #include "../Scene/Animatable.h"
+#include "../Scene/SceneEvents.h"
+#include "../Scene/TransformStore.h"
 
 namespace Urho3D
 {
@@ -57,6 +59,8 @@ class URHO3D_API Node : public Animatable
     URHO3D_OBJECT(Node, Animatable);
 
     friend class Connection;
+    friend class Scene;
+    friend class TransformStore;
 
 public:
     /// Construct.
@@ -325,6 +329,9 @@ public:
     /// Return whether has a specific tag.
     bool HasTag(const String& tag) const;
 
+    /// Return tag bits indexed by the scene's interned tag indices. Empty when not in a scene.
+    const PODVector<unsigned>& GetTagBits() const { return tagBits_; }
+
     /// Return parent scene node.
     Node* GetParent() const { return parent_; }
 
@@ -373,7 +380,7 @@ public:
     /// Return position in world space.
     Vector3 GetWorldPosition() const
     {
-        if (dirty_)
+        if (dirty_ || (transformStore_ && transformStore_->HasPendingChanges()))
             UpdateWorldTransform();
 
         return worldTransform_.Translation();
@@ -389,7 +396,7 @@ public:
     /// Return rotation in world space.
     Quaternion GetWorldRotation() const
     {
-        if (dirty_)
+        if (dirty_ || (transformStore_ && transformStore_->HasPendingChanges()))
             UpdateWorldTransform();
 
         return worldRotation_;
@@ -404,7 +411,7 @@ public:
     /// Return direction in world space.
     Vector3 GetWorldDirection() const
     {
-        if (dirty_)
+        if (dirty_ || (transformStore_ && transformStore_->HasPendingChanges()))
             UpdateWorldTransform();
 
         return worldRotation_ * Vector3::FORWARD;
@@ -413,7 +420,7 @@ public:
     /// Return node's up vector in world space.
     Vector3 GetWorldUp() const
     {
-        if (dirty_)
+        if (dirty_ || (transformStore_ && transformStore_->HasPendingChanges()))
             UpdateWorldTransform();
 
         return worldRotation_ * Vector3::UP;
@@ -422,7 +429,7 @@ public:
     /// Return node's right vector in world space.
     Vector3 GetWorldRight() const
     {
-        if (dirty_)
+        if (dirty_ || (transformStore_ && transformStore_->HasPendingChanges()))
             UpdateWorldTransform();
 
         return worldRotation_ * Vector3::RIGHT;
@@ -431,7 +438,7 @@ public:
     /// Return scale in world space.
     Vector3 GetWorldScale() const
     {
-        if (dirty_)
+        if (dirty_ || (transformStore_ && transformStore_->HasPendingChanges()))
             UpdateWorldTransform();
 
         return worldTransform_.Scale();
@@ -447,7 +454,7 @@ public:
     /// Return world space transform matrix.
     const Matrix3x4& GetWorldTransform() const
     {
-        if (dirty_)
+        if (dirty_ || (transformStore_ && transformStore_->HasPendingChanges()))
             UpdateWorldTransform();
 
         return worldTransform_;
@@ -467,7 +474,7 @@ public:
     Vector2 WorldToLocal2D(const Vector2& vector) const;
 
     /// Return whether transform has changed and world transform needs recalculation.
-    bool IsDirty() const { return dirty_; }
+    bool IsDirty() const { return dirty_ || (transformStore_ && transformStore_->HasPendingChanges() && IsParentTransformPending()); }
 
     /// Return number of child scene nodes.
     unsigned GetNumChildren(bool recursive = false) const;
@@ -554,13 +561,13 @@ public:
     const PODVector<unsigned char>& GetNetParentAttr() const;
     /// Load components and optionally load child nodes.
     bool Load(Deserializer& source, SceneResolver& resolver, bool loadChildren = true, bool rewriteIDs = false,
-        CreateMode mode = REPLICATED);
+        CreateMode mode = REPLICATED, bool setInstanceDefault = false);
     /// Load components from XML data and optionally load child nodes.
     bool LoadXML(const XMLElement& source, SceneResolver& resolver, bool loadChildren = true, bool rewriteIDs = false,
-        CreateMode mode = REPLICATED);
+        CreateMode mode = REPLICATED, bool setInstanceDefault = false);
     /// Load components from XML data and optionally load child nodes.
     bool LoadJSON(const JSONValue& source, SceneResolver& resolver, bool loadChildren = true, bool rewriteIDs = false,
-        CreateMode mode = REPLICATED);
+        CreateMode mode = REPLICATED, bool setInstanceDefault = false);
     /// Return the depended on nodes to order network updates.
     const PODVector<Node*>& GetDependencyNodes() const { return dependencyNodes_; }
 
@@ -609,8 +616,18 @@ private:
     void SetEnabled(bool enable, bool recursive, bool storeSelf);
     /// Create component, allowing UnknownComponent if actual type is not supported. Leave typeName empty if not known.
     Component* SafeCreateComponent(const String& typeName, StringHash type, CreateMode mode, unsigned id);
-    /// Recalculate the world transform.
+    /// Recalculate the world transform if it or a parent's transform has changed.
     void UpdateWorldTransform() const;
+    /// Recalculate the world transform from the parent's.
+    void CalculateWorldTransform() const;
+    /// Return whether a parent node is pending in the transform store.
+    bool IsParentTransformPending() const;
+    /// Notify listener components that the node has been marked dirty, or queue the notification if the scene defers it.
+    void NotifyListeners();
+    /// Call OnMarkedDirty() on the listener components.
+    void SendMarkedDirty();
+    /// Mark node and child nodes dirty without the transform store.
+    void MarkDirtyRecursive();
     /// Remove child node by iterator.
     void RemoveChild(Vector<SharedPtr<Node> >::Iterator i);
     /// Return child nodes recursively.
@@ -625,8 +642,6 @@ private:
     Node* CloneRecursive(Node* parent, SceneResolver& resolver, CreateMode mode);
     /// Remove a component from this node with the specified iterator.
     void RemoveComponent(Vector<SharedPtr<Component> >::Iterator i);
-    /// Handle attribute animation update event.
-    void HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData);
 
     /// World-space transform matrix.
     mutable Matrix3x4 worldTransform_;
@@ -640,6 +655,14 @@ private:
     Node* parent_;
     /// Scene (root node.)
     Scene* scene_;
+    /// Transform store of the scene, null if not used.
+    TransformStore* transformStore_;
+    /// Index in the transform store, or M_MAX_UNSIGNED if not stored.
+    unsigned transformIndex_;
+    /// Index in the transform store's list of nodes whose children are not yet marked dirty, or M_MAX_UNSIGNED if not pending.
+    unsigned transformPendingIndex_;
+    /// Index in the scene's deferred dirty notification queue, or M_MAX_UNSIGNED if not queued.
+    unsigned markedDirtyIndex_;
     /// Unique ID within the scene.
     unsigned id_;
     /// Position.
@@ -664,6 +687,8 @@ private:
     String name_;
     /// Tag strings.
     StringVector tags_;
+    /// Tag bits by scene tag index.
+    PODVector<unsigned> tagBits_;
     /// Name hash.
     StringHash nameHash_;
     /// Attribute buffer for network updates.
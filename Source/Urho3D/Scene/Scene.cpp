@@ -28,12 +28,15 @@
 #include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/Log.h"
+#include "../IO/MappedFile.h"
+#include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
 #include "../Scene/Component.h"
+#include "../Scene/LogicComponent.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
@@ -54,9 +57,311 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+static const unsigned PACKED_SCENE_VERSION = 2;
+
+/// Object type of a packed scene file, with its attribute layout.
+struct PackedSceneType
+{
+    /// Construct.
+    PackedSceneType() :
+        nameIndex_(0),
+        raw_(false),
+        matches_(false),
+        isNode_(false)
+    {
+    }
+
+    /// Type hash.
+    StringHash type_;
+    /// Type name index in the string table.
+    unsigned nameIndex_;
+    /// Attribute name indices in the string table.
+    PODVector<unsigned> attributeNames_;
+    /// Attribute types.
+    PODVector<unsigned char> attributeTypes_;
+    /// Instance data offsets within the type's block, followed by the end offset.
+    PODVector<unsigned> offsets_;
+    /// Instance attribute data when saving.
+    VectorBuffer data_;
+    /// Instances in file order when loading. Null for objects that could not be created.
+    PODVector<Serializable*> instances_;
+    /// File attribute index for each runtime file attribute when loading, or M_MAX_UNSIGNED if not in the file.
+    PODVector<unsigned> remap_;
+    /// Attribute data is stored in the binary scene format attribute order. Used for objects with per-instance attributes.
+    bool raw_;
+    /// Attribute layout matches the runtime attributes when loading.
+    bool matches_;
+    /// Type is Node or Scene.
+    bool isNode_;
+};
+
+/// Helper for building the string and type tables of a packed scene file.
+struct PackedSceneWriter
+{
+    /// Return the string table index of a string, adding it if new.
+    unsigned AddString(const String& str)
+    {
+        HashMap<String, unsigned>::ConstIterator i = stringIndices_.Find(str);
+        if (i != stringIndices_.End())
+            return i->second_;
+
+        unsigned index = strings_.Size();
+        strings_.Push(str);
+        stringIndices_[str] = index;
+        return index;
+    }
+
+    /// Append an object's attributes to the block of its type and return the type index, or M_MAX_UNSIGNED if failed.
+    unsigned AddObject(const Serializable* object)
+    {
+        StringHash type = object->GetType();
+        const UnknownComponent* unknown = dynamic_cast<const UnknownComponent*>(object);
+
+        unsigned index;
+        HashMap<StringHash, unsigned>::ConstIterator i = typeIndices_.Find(type);
+        if (i != typeIndices_.End())
+            index = i->second_;
+        else
+        {
+            index = types_.Size();
+            typeIndices_[type] = index;
+            types_.Resize(index + 1);
+
+            PackedSceneType& newType = types_[index];
+            newType.type_ = type;
+            newType.nameIndex_ = AddString(object->GetTypeName());
+
+            // Objects with per-instance attributes, such as script instances, can only be stored in attribute order
+            const Vector<AttributeInfo>* attributes = object->GetAttributes();
+            newType.raw_ = unknown || attributes != object->GetContext()->GetAttributes(type);
+            if (!newType.raw_ && attributes)
+            {
+                for (unsigned j = 0; j < attributes->Size(); ++j)
+                {
+                    const AttributeInfo& attr = attributes->At(j);
+                    if (!(attr.mode_ & AM_FILE))
+                        continue;
+                    newType.attributeNames_.Push(AddString(attr.name_));
+                    newType.attributeTypes_.Push((unsigned char)attr.type_);
+                }
+            }
+        }
+
+        PackedSceneType& objectType = types_[index];
+        objectType.offsets_.Push(objectType.data_.GetSize());
+        if (unknown)
+        {
+            if (!unknown->GetUseXML())
+            {
+                const PODVector<unsigned char>& data = unknown->GetBinaryAttributes();
+                if (data.Size())
+                    objectType.data_.Write(&data[0], data.Size());
+            }
+            else
+                URHO3D_LOGWARNING("UnknownComponent loaded in XML mode, attributes will be empty for packed save");
+        }
+        else if (!object->Serializable::Save(objectType.data_))
+            return M_MAX_UNSIGNED;
+
+        return index;
+    }
+
+    /// String table.
+    StringVector strings_;
+    /// String table indices by string.
+    HashMap<String, unsigned> stringIndices_;
+    /// Object types.
+    Vector<PackedSceneType> types_;
+    /// Object type indices by type.
+    HashMap<StringHash, unsigned> typeIndices_;
+};
+
+void UpdateLogicWork(const WorkItem* item, unsigned threadIndex)
+{
+    float timeStep = *(reinterpret_cast<float*>(item->aux_));
+    LogicComponent** start = reinterpret_cast<LogicComponent**>(item->start_);
+    LogicComponent** end = reinterpret_cast<LogicComponent**>(item->end_);
+
+    while (start != end)
+        (*start++)->Update(timeStep);
+}
+
+void PostUpdateLogicWork(const WorkItem* item, unsigned threadIndex)
+{
+    float timeStep = *(reinterpret_cast<float*>(item->aux_));
+    LogicComponent** start = reinterpret_cast<LogicComponent**>(item->start_);
+    LogicComponent** end = reinterpret_cast<LogicComponent**>(item->end_);
+
+    while (start != end)
+        (*start++)->PostUpdate(timeStep);
+}
+
+static void AddToParallelList(PODVector<LogicComponent*>& components, unsigned LogicComponent::* indexMember,
+    LogicComponent* component)
+{
+    unsigned index = component->*indexMember;
+    if (index < components.Size() && components[index] == component)
+        return;
+
+    component->*indexMember = components.Size();
+    components.Push(component);
+}
+
+static void RemoveFromParallelList(PODVector<LogicComponent*>& components, unsigned LogicComponent::* indexMember,
+    LogicComponent* component)
+{
+    unsigned index = component->*indexMember;
+    if (index >= components.Size() || components[index] != component)
+        return;
+
+    // Move the last component into the gap
+    LogicComponent* last = components.Back();
+    components[index] = last;
+    last->*indexMember = index;
+    components.Pop();
+    component->*indexMember = M_MAX_UNSIGNED;
+}
+
+void EvaluateAttributeAnimationsWork(const WorkItem* item, unsigned threadIndex)
+{
+    float timeStep = *(reinterpret_cast<float*>(item->aux_));
+    Animatable** start = reinterpret_cast<Animatable**>(item->start_);
+    Animatable** end = reinterpret_cast<Animatable**>(item->end_);
+
+    while (start != end)
+        (*start++)->EvaluateAttributeAnimations(timeStep);
+}
+
+/// Node or component of an XML or JSON scene, with its attribute values converted before instantiation.
+struct StagedSceneObject
+{
+    /// Construct.
+    StagedSceneObject() :
+        xmlNode_(0),
+        jsonValue_(0),
+        attributes_(0),
+        parent_(M_MAX_UNSIGNED),
+        id_(0),
+        isNode_(false)
+    {
+    }
+
+    /// XML element node.
+    pugi::xml_node_struct* xmlNode_;
+    /// JSON value.
+    const JSONValue* jsonValue_;
+    /// Attribute descriptions of the type.
+    const Vector<AttributeInfo>* attributes_;
+    /// Component type name.
+    String typeName_;
+    /// Object index of the parent node, or M_MAX_UNSIGNED for the scene.
+    unsigned parent_;
+    /// ID in the source data.
+    unsigned id_;
+    /// Node flag.
+    bool isNode_;
+    /// Converted attribute values.
+    ConvertedAttributes converted_;
+};
+
+/// Shared data for converting the attributes of staged scene objects.
+struct StagedSceneConversion
+{
+    /// Execution context, for querying component attributes.
+    Context* context_;
+    /// Per-thread proxy files for wrapping XML elements.
+    Vector<SharedPtr<XMLFile> > proxyFiles_;
+};
+
+static void CollectStagedXML(const XMLElement& source, unsigned parent, const Vector<AttributeInfo>* nodeAttributes,
+    const Vector<AttributeInfo>* childAttributes, Vector<StagedSceneObject>& objects)
+{
+    unsigned nodeIndex = objects.Size();
+    objects.Resize(nodeIndex + 1);
+    StagedSceneObject& node = objects.Back();
+    node.xmlNode_ = source.GetNode();
+    node.attributes_ = nodeAttributes;
+    node.parent_ = parent;
+    node.isNode_ = true;
+
+    // Component types and IDs are read during conversion
+    for (XMLElement compElem = source.GetChild("component"); compElem; compElem = compElem.GetNext("component"))
+    {
+        objects.Resize(objects.Size() + 1);
+        objects.Back().xmlNode_ = compElem.GetNode();
+        objects.Back().parent_ = nodeIndex;
+    }
+
+    for (XMLElement childElem = source.GetChild("node"); childElem; childElem = childElem.GetNext("node"))
+        CollectStagedXML(childElem, nodeIndex, childAttributes, childAttributes, objects);
+}
+
+static void CollectStagedJSON(const JSONValue& source, unsigned parent, const Vector<AttributeInfo>* nodeAttributes,
+    const Vector<AttributeInfo>* childAttributes, Vector<StagedSceneObject>& objects)
+{
+    unsigned nodeIndex = objects.Size();
+    objects.Resize(nodeIndex + 1);
+    StagedSceneObject& node = objects.Back();
+    node.jsonValue_ = &source;
+    node.attributes_ = nodeAttributes;
+    node.parent_ = parent;
+    node.isNode_ = true;
+
+    const JSONArray& componentsArray = source.Get("components").GetArray();
+    for (unsigned i = 0; i < componentsArray.Size(); ++i)
+    {
+        objects.Resize(objects.Size() + 1);
+        objects.Back().jsonValue_ = &componentsArray[i];
+        objects.Back().parent_ = nodeIndex;
+    }
+
+    const JSONArray& childrenArray = source.Get("children").GetArray();
+    for (unsigned i = 0; i < childrenArray.Size(); ++i)
+        CollectStagedJSON(childrenArray[i], nodeIndex, childAttributes, childAttributes, objects);
+}
+
+void ConvertStagedAttributesWork(const WorkItem* item, unsigned threadIndex)
+{
+    StagedSceneConversion* conversion = reinterpret_cast<StagedSceneConversion*>(item->aux_);
+    StagedSceneObject* start = reinterpret_cast<StagedSceneObject*>(item->start_);
+    StagedSceneObject* end = reinterpret_cast<StagedSceneObject*>(item->end_);
+
+    while (start != end)
+    {
+        if (start->jsonValue_)
+        {
+            const JSONValue& source = *start->jsonValue_;
+            if (!start->isNode_)
+            {
+                start->typeName_ = source.Get("type").GetString();
+                start->attributes_ = conversion->context_->GetAttributes(StringHash(start->typeName_));
+            }
+            start->id_ = source.Get("id").GetUInt();
+            start->converted_.ConvertJSON(source, start->attributes_);
+        }
+        else
+        {
+            // Copying elements that refer to the scene file from several threads would race on its weak reference count, so
+            // wrap the element in a proxy file owned by this thread
+            XMLElement source(conversion->proxyFiles_[threadIndex], start->xmlNode_);
+            if (!start->isNode_)
+            {
+                start->typeName_ = source.GetAttribute("type");
+                start->attributes_ = conversion->context_->GetAttributes(StringHash(start->typeName_));
+            }
+            start->id_ = source.GetUInt("id");
+            start->converted_.ConvertXML(source, start->attributes_);
+        }
+        ++start;
+    }
+}
 
 Scene::Scene(Context* context) :
     Node(context),
+    replicatedNodes_(FIRST_REPLICATED_ID),
+    localNodes_(FIRST_LOCAL_ID),
+    replicatedComponents_(FIRST_REPLICATED_ID),
+    localComponents_(FIRST_LOCAL_ID),
     replicatedNodeID_(FIRST_REPLICATED_ID),
     replicatedComponentID_(FIRST_REPLICATED_ID),
     localNodeID_(FIRST_LOCAL_ID),
@@ -69,7 +374,11 @@ Scene::Scene(Context* context) :
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
     updateEnabled_(true),
     asyncLoading_(false),
-    threadedUpdate_(false)
+    threadedUpdate_(false),
+    parallelLogicUpdating_(false),
+    deferredDirty_(false),
+    attributeAnimationsUpdating_(false),
+    attributeAnimationTargetsRemoved_(false)
 {
     // Assign an ID to self so that nodes can refer to this node as a parent
     SetID(GetFreeNodeID(REPLICATED));
@@ -87,10 +396,10 @@ Scene::~Scene()
     RemoveAllChildren();
 
     // Remove scene reference and owner from all nodes that still exist
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
-        i->second_->ResetScene();
-    for (HashMap<unsigned, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
-        i->second_->ResetScene();
+    for (IDTable<Node>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+        i->ResetScene();
+    for (IDTable<Node>::ConstIterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+        i->ResetScene();
 }
 
 void Scene::RegisterObject(Context* context)
@@ -118,7 +427,32 @@ bool Scene::Load(Deserializer& source, bool setInstanceDefault)
     StopAsyncLoading();
 
     // Check ID
-    if (source.ReadFileID() != "USCN")
+    String fileID = source.ReadFileID();
+    if (fileID == "USC2")
+    {
+        URHO3D_LOGINFO("Loading packed scene from " + source.GetName());
+
+        // Map the whole file if possible, otherwise read it into memory
+        bool success;
+        source.Seek(0);
+        File* file = dynamic_cast<File*>(&source);
+        if (file)
+        {
+            MappedFile mappedFile(context_);
+            success = mappedFile.Open(file) && LoadPacked(mappedFile.GetData(), mappedFile.GetSize(), setInstanceDefault);
+        }
+        else
+        {
+            PODVector<unsigned char> buffer(source.GetSize());
+            success = buffer.Size() && source.Read(&buffer[0], buffer.Size()) == buffer.Size() &&
+                LoadPacked(&buffer[0], buffer.Size(), setInstanceDefault);
+        }
+
+        if (success)
+            FinishLoading(&source);
+        return success;
+    }
+    else if (fileID != "USCN")
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid scene file");
         return false;
@@ -162,15 +496,381 @@ bool Scene::Save(Serializer& dest) const
         return false;
 }
 
+bool Scene::SavePacked(Serializer& dest) const
+{
+    URHO3D_PROFILE(SaveScenePacked);
+
+    Deserializer* ptr = dynamic_cast<Deserializer*>(&dest);
+    if (ptr)
+        URHO3D_LOGINFO("Saving packed scene to " + ptr->GetName());
+
+    // Walk the persistent nodes depth-first so that parents come before their children. Collect the attributes of each object
+    // into the block of its type
+    PackedSceneWriter writer;
+    VectorBuffer nodeTable;
+    unsigned numNodes = 0;
+    PODVector<Pair<const Node*, unsigned> > stack;
+    stack.Push(MakePair((const Node*)this, 0U));
+
+    while (stack.Size())
+    {
+        const Node* node = stack.Back().first_;
+        unsigned parentIndex = stack.Back().second_;
+        stack.Pop();
+        ++numNodes;
+
+        unsigned typeIndex = writer.AddObject(node);
+        if (typeIndex == M_MAX_UNSIGNED)
+        {
+            URHO3D_LOGERROR("Could not save packed scene, writing node attributes failed");
+            return false;
+        }
+
+        nodeTable.WriteVLE(parentIndex);
+        nodeTable.WriteUInt(node->GetID());
+        nodeTable.WriteVLE(typeIndex);
+        nodeTable.WriteVLE(node->GetNumPersistentComponents());
+        for (unsigned i = 0; i < node->components_.Size(); ++i)
+        {
+            const Component* component = node->components_[i];
+            if (component->IsTemporary())
+                continue;
+
+            typeIndex = writer.AddObject(component);
+            if (typeIndex == M_MAX_UNSIGNED)
+            {
+                URHO3D_LOGERROR("Could not save packed scene, writing component attributes failed");
+                return false;
+            }
+            nodeTable.WriteVLE(typeIndex);
+            nodeTable.WriteUInt(component->GetID());
+        }
+
+        // Push in reverse to visit the children in order. The parent index is stored plus one, zero is the scene
+        for (unsigned i = node->children_.Size() - 1; i < node->children_.Size(); --i)
+        {
+            if (!node->children_[i]->IsTemporary())
+                stack.Push(MakePair((const Node*)node->children_[i].Get(), numNodes));
+        }
+    }
+
+    Vector<PackedSceneType>& types = writer.types_;
+
+    VectorBuffer header;
+    header.WriteUInt(PACKED_SCENE_VERSION);
+    header.WriteVLE(writer.strings_.Size());
+    for (unsigned i = 0; i < writer.strings_.Size(); ++i)
+        header.WriteString(writer.strings_[i]);
+    header.WriteVLE(types.Size());
+    for (unsigned i = 0; i < types.Size(); ++i)
+    {
+        const PackedSceneType& type = types[i];
+        header.WriteStringHash(type.type_);
+        header.WriteVLE(type.nameIndex_);
+        header.WriteBool(type.raw_);
+        header.WriteVLE(type.attributeNames_.Size());
+        for (unsigned j = 0; j < type.attributeNames_.Size(); ++j)
+        {
+            header.WriteVLE(type.attributeNames_[j]);
+            header.WriteUByte(type.attributeTypes_[j]);
+        }
+    }
+    header.WriteVLE(numNodes);
+    header.Write(nodeTable.GetData(), nodeTable.GetSize());
+
+    // Block table follows the header. Block offsets are from the start of the file
+    unsigned offset = 4 + header.GetSize() + types.Size() * 2 * sizeof(unsigned);
+    for (unsigned i = 0; i < types.Size(); ++i)
+    {
+        PackedSceneType& type = types[i];
+        unsigned numInstances = type.offsets_.Size();
+        type.offsets_.Push(type.data_.GetSize());
+        header.WriteUInt(offset);
+        header.WriteUInt(numInstances);
+        offset += type.offsets_.Size() * sizeof(unsigned) + type.data_.GetSize();
+    }
+
+    bool success = dest.WriteFileID("USC2") && dest.Write(header.GetData(), header.GetSize()) == header.GetSize();
+    for (unsigned i = 0; success && i < types.Size(); ++i)
+    {
+        const PackedSceneType& type = types[i];
+        unsigned offsetsSize = type.offsets_.Size() * sizeof(unsigned);
+        success = dest.Write(&type.offsets_[0], offsetsSize) == offsetsSize &&
+            dest.Write(type.data_.GetData(), type.data_.GetSize()) == type.data_.GetSize();
+    }
+
+    if (!success)
+    {
+        URHO3D_LOGERROR("Could not save packed scene, writing to stream failed");
+        return false;
+    }
+
+    FinishSaving(&dest);
+    return true;
+}
+
+bool Scene::LoadPacked(const String& fileName, bool setInstanceDefault)
+{
+    MappedFile file(context_, fileName);
+    if (!file.IsOpen())
+        return false;
+
+    URHO3D_LOGINFO("Loading packed scene from " + fileName);
+
+    if (!LoadPacked(file.GetData(), file.GetSize(), setInstanceDefault))
+        return false;
+
+    fileName_ = fileName;
+    checksum_ = 0;
+    const unsigned char* data = file.GetData();
+    for (unsigned i = 0; i < file.GetSize(); ++i)
+        checksum_ = SDBMHash(checksum_, data[i]);
+    return true;
+}
+
+bool Scene::LoadPacked(const void* data, unsigned size, bool setInstanceDefault)
+{
+    URHO3D_PROFILE(LoadScenePacked);
+
+    StopAsyncLoading();
+
+    MemoryBuffer source(data, size);
+    if (source.ReadFileID() != "USC2")
+    {
+        URHO3D_LOGERROR("Data is not a packed scene file");
+        return false;
+    }
+    unsigned version = source.ReadUInt();
+    if (version != PACKED_SCENE_VERSION)
+    {
+        URHO3D_LOGERROR("Unsupported packed scene file version " + String(version));
+        return false;
+    }
+
+    Clear();
+
+    // Each string takes at least one byte, which bounds the counts read from a corrupt file
+    unsigned numStrings = source.ReadVLE();
+    if (numStrings > size)
+    {
+        URHO3D_LOGERROR("Corrupt packed scene string table");
+        return false;
+    }
+    StringVector strings(numStrings);
+    for (unsigned i = 0; i < numStrings; ++i)
+        strings[i] = source.ReadString();
+
+    unsigned numTypes = source.ReadVLE();
+    if (numTypes > size)
+    {
+        URHO3D_LOGERROR("Corrupt packed scene type table");
+        return false;
+    }
+    Vector<PackedSceneType> types(numTypes);
+    for (unsigned i = 0; i < numTypes; ++i)
+    {
+        PackedSceneType& type = types[i];
+        type.type_ = source.ReadStringHash();
+        type.nameIndex_ = source.ReadVLE();
+        type.raw_ = source.ReadBool();
+        type.isNode_ = type.type_ == Node::GetTypeStatic() || type.type_ == Scene::GetTypeStatic();
+        unsigned numAttributes = source.ReadVLE();
+        if (type.nameIndex_ >= numStrings || numAttributes > size)
+        {
+            URHO3D_LOGERROR("Corrupt packed scene type table");
+            return false;
+        }
+        type.attributeNames_.Resize(numAttributes);
+        type.attributeTypes_.Resize(numAttributes);
+        for (unsigned j = 0; j < numAttributes; ++j)
+        {
+            type.attributeNames_[j] = source.ReadVLE();
+            type.attributeTypes_[j] = source.ReadUByte();
+            if (type.attributeNames_[j] >= numStrings || type.attributeTypes_[j] >= MAX_VAR_TYPES)
+            {
+                URHO3D_LOGERROR("Corrupt packed scene type table");
+                return false;
+            }
+        }
+
+        // Compare the attribute layout to the current one. If attributes have been added, removed or reordered since saving,
+        // match them by name and type instead
+        const Vector<AttributeInfo>* attributes = context_->GetAttributes(type.type_);
+        if (type.raw_ || !attributes)
+            continue;
+        type.matches_ = true;
+        for (unsigned j = 0; j < attributes->Size(); ++j)
+        {
+            const AttributeInfo& attr = attributes->At(j);
+            if (!(attr.mode_ & AM_FILE))
+                continue;
+
+            unsigned fileIndex = M_MAX_UNSIGNED;
+            for (unsigned k = 0; k < numAttributes; ++k)
+            {
+                if (type.attributeTypes_[k] == attr.type_ && strings[type.attributeNames_[k]] == attr.name_)
+                {
+                    fileIndex = k;
+                    break;
+                }
+            }
+            if (fileIndex != type.remap_.Size())
+                type.matches_ = false;
+            type.remap_.Push(fileIndex);
+        }
+        if (type.remap_.Size() != numAttributes)
+            type.matches_ = false;
+    }
+
+    // Create the nodes and components in file order. The first node is the scene itself
+    SceneResolver resolver;
+    unsigned numNodes = source.ReadVLE();
+    if (!numNodes || numNodes > size)
+    {
+        URHO3D_LOGERROR("Corrupt packed scene node table");
+        return false;
+    }
+    PODVector<Node*> nodes(numNodes);
+    for (unsigned i = 0; i < numNodes; ++i)
+    {
+        unsigned parentIndex = source.ReadVLE();
+        unsigned nodeID = source.ReadUInt();
+        unsigned typeIndex = source.ReadVLE();
+        if (typeIndex >= numTypes || (i && (!parentIndex || parentIndex > i)) || (!i && parentIndex) || source.IsEof())
+        {
+            URHO3D_LOGERROR("Corrupt packed scene node table");
+            return false;
+        }
+
+        Node* node = i ? nodes[parentIndex - 1]->CreateChild(nodeID, nodeID < FIRST_LOCAL_ID ? REPLICATED : LOCAL) : this;
+        nodes[i] = node;
+        resolver.AddNode(nodeID, node);
+        types[typeIndex].instances_.Push(node);
+
+        unsigned numComponents = source.ReadVLE();
+        for (unsigned j = 0; j < numComponents; ++j)
+        {
+            unsigned compTypeIndex = source.ReadVLE();
+            unsigned compID = source.ReadUInt();
+            if (compTypeIndex >= numTypes)
+            {
+                URHO3D_LOGERROR("Corrupt packed scene node table");
+                return false;
+            }
+
+            PackedSceneType& compType = types[compTypeIndex];
+            Component* newComponent = node->SafeCreateComponent(strings[compType.nameIndex_], compType.type_,
+                compID < FIRST_LOCAL_ID ? REPLICATED : LOCAL, compID);
+            if (newComponent)
+                resolver.AddComponent(compID, newComponent);
+            compType.instances_.Push(newComponent);
+        }
+    }
+
+    // Apply the attributes one type block at a time, reading directly from the source data
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    Variant value;
+    for (unsigned i = 0; i < numTypes; ++i)
+    {
+        PackedSceneType& type = types[i];
+        unsigned offset = source.ReadUInt();
+        unsigned numInstances = source.ReadUInt();
+        if (numInstances != type.instances_.Size() || offset > size || (size - offset) / sizeof(unsigned) <= numInstances)
+        {
+            URHO3D_LOGERROR("Corrupt packed scene block table");
+            return false;
+        }
+
+        const unsigned char* block = bytes + offset;
+        unsigned blockSize = size - offset;
+        type.offsets_.Resize(numInstances + 1);
+        memcpy(&type.offsets_[0], block, (numInstances + 1) * sizeof(unsigned));
+        unsigned dataStart = (numInstances + 1) * sizeof(unsigned);
+
+        for (unsigned j = 0; j < numInstances; ++j)
+        {
+            unsigned start = type.offsets_[j];
+            unsigned end = type.offsets_[j + 1];
+            if (start > end || end > blockSize - dataStart)
+            {
+                URHO3D_LOGERROR("Corrupt packed scene block table");
+                return false;
+            }
+
+            Serializable* object = type.instances_[j];
+            if (!object)
+                continue;
+
+            MemoryBuffer objectData(block + dataStart + start, end - start);
+            if (type.matches_ || type.raw_ || type.remap_.Empty())
+            {
+                // Nodes load their hierarchy in Load(), so call the attribute load directly for them
+                if (type.isNode_)
+                    object->Serializable::Load(objectData, setInstanceDefault);
+                else
+                    object->Load(objectData, setInstanceDefault);
+            }
+            else
+            {
+                // Convert to the current attribute order. Attributes missing from the file keep their current values
+                Vector<Variant> values(type.attributeTypes_.Size());
+                for (unsigned k = 0; k < values.Size(); ++k)
+                    values[k] = objectData.ReadVariant((VariantType)type.attributeTypes_[k]);
+
+                const Vector<AttributeInfo>* attributes = object->GetAttributes();
+                VectorBuffer converted;
+                unsigned index = 0;
+                for (unsigned k = 0; k < attributes->Size(); ++k)
+                {
+                    const AttributeInfo& attr = attributes->At(k);
+                    if (!(attr.mode_ & AM_FILE))
+                        continue;
+                    unsigned fileIndex = type.remap_[index++];
+                    if (fileIndex != M_MAX_UNSIGNED)
+                        converted.WriteVariantData(values[fileIndex]);
+                    else
+                    {
+                        object->OnGetAttribute(attr, value);
+                        converted.WriteVariantData(value);
+                    }
+                }
+
+                converted.Seek(0);
+                if (type.isNode_)
+                    object->Serializable::Load(converted, setInstanceDefault);
+                else
+                    object->Load(converted, setInstanceDefault);
+            }
+        }
+    }
+
+    resolver.Resolve();
+    ApplyAttributes();
+    return true;
+}
+
 bool Scene::LoadXML(const XMLElement& source, bool setInstanceDefault)
 {
     URHO3D_PROFILE(LoadSceneXML);
 
     StopAsyncLoading();
 
-    // Load the whole scene, then perform post-load if successfully loaded
+    // Load the whole scene, then perform post-load if successfully loaded. When worker threads are available, convert the attribute
+    // values in parallel before creating the nodes and components
     // Note: the scene filename and checksum can not be set, as we only used an XML element
-    if (Node::LoadXML(source, setInstanceDefault))
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    bool success;
+    if (queue && queue->GetNumThreads())
+    {
+        Vector<StagedSceneObject> objects;
+        CollectStagedXML(source, M_MAX_UNSIGNED, context_->GetAttributes(GetType()), context_->GetAttributes(Node::GetTypeStatic()),
+            objects);
+        success = LoadStaged(objects, source.GetFile(), setInstanceDefault);
+    }
+    else
+        success = Node::LoadXML(source, setInstanceDefault);
+
+    if (success)
     {
         FinishLoading(0);
         return true;
@@ -185,9 +885,22 @@ bool Scene::LoadJSON(const JSONValue& source, bool setInstanceDefault)
 
     StopAsyncLoading();
 
-    // Load the whole scene, then perform post-load if successfully loaded
-    // Note: the scene filename and checksum can not be set, as we only used an XML element
-    if (Node::LoadJSON(source, setInstanceDefault))
+    // Load the whole scene, then perform post-load if successfully loaded. When worker threads are available, convert the attribute
+    // values in parallel before creating the nodes and components
+    // Note: the scene filename and checksum can not be set, as we only used a JSON value
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    bool success;
+    if (queue && queue->GetNumThreads())
+    {
+        Vector<StagedSceneObject> objects;
+        CollectStagedJSON(source, M_MAX_UNSIGNED, context_->GetAttributes(GetType()), context_->GetAttributes(Node::GetTypeStatic()),
+            objects);
+        success = LoadStaged(objects, 0, setInstanceDefault);
+    }
+    else
+        success = Node::LoadJSON(source, setInstanceDefault);
+
+    if (success)
     {
         FinishLoading(0);
         return true;
@@ -210,8 +923,8 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
-        state->sceneState_->dirtyNodes_.Insert(i->first_);
+    for (IDTable<Node>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+        state->sceneState_->dirtyNodes_.Insert(i.GetID());
 }
 
 bool Scene::LoadXML(Deserializer& source)
@@ -317,7 +1030,13 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
     StopAsyncLoading();
 
     // Check ID
-    bool isSceneFile = file->ReadFileID() == "USCN";
+    String fileID = file->ReadFileID();
+    if (fileID == "USC2")
+    {
+        URHO3D_LOGERROR("Asynchronous loading of packed scene files is not supported, use Load() instead");
+        return false;
+    }
+    bool isSceneFile = fileID == "USCN";
     if (!isSceneFile)
     {
         // In resource load mode can load also object prefabs, which have no identifier
@@ -669,6 +1388,47 @@ void Scene::SetAsyncLoadingMs(int ms)
     asyncLoadingMs_ = Max(ms, 1);
 }
 
+void Scene::SetTransformStoreEnabled(bool enable)
+{
+    if (enable == transformStore_.NotNull())
+        return;
+
+    // Keep the old store alive until the nodes have detached from it
+    SharedPtr<TransformStore> oldStore = transformStore_;
+    if (enable)
+        transformStore_ = new TransformStore(this);
+    else
+    {
+        // Apply pending changes before returning to recursive dirty marking
+        transformStore_->Update();
+        transformStore_.Reset();
+    }
+
+    // Reassigning the scene updates the nodes' transform store pointers
+    for (IDTable<Node>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    {
+        if (*i != this)
+            i->SetScene(this);
+    }
+    for (IDTable<Node>::ConstIterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+        i->SetScene(this);
+
+    // The nodes were stored in ID order. Store them in hierarchy order once for better memory locality
+    if (transformStore_)
+        transformStore_->Rebuild();
+}
+
+void Scene::SetDeferredDirtyEnabled(bool enable)
+{
+    if (enable == deferredDirty_)
+        return;
+
+    // Send the queued notifications before returning to immediate notification
+    if (!enable)
+        UpdateTransforms();
+    deferredDirty_ = enable;
+}
+
 void Scene::SetElapsedTime(float time)
 {
     elapsedTime_ = time;
@@ -705,42 +1465,63 @@ void Scene::UnregisterAllVars()
 
 Node* Scene::GetNode(unsigned id) const
 {
-    if (id < FIRST_LOCAL_ID)
-    {
-        HashMap<unsigned, Node*>::ConstIterator i = replicatedNodes_.Find(id);
-        return i != replicatedNodes_.End() ? i->second_ : 0;
-    }
-    else
-    {
-        HashMap<unsigned, Node*>::ConstIterator i = localNodes_.Find(id);
-        return i != localNodes_.End() ? i->second_ : 0;
-    }
+    return id < FIRST_LOCAL_ID ? replicatedNodes_.Find(id) : localNodes_.Find(id);
 }
 
 bool Scene::GetNodesWithTag(PODVector<Node*>& dest, const String& tag) const
 {
     dest.Clear();
-    HashMap<StringHash, PODVector<Node*> >::ConstIterator it = taggedNodes_.Find(tag);
-    if (it != taggedNodes_.End())
+    HashMap<StringHash, unsigned>::ConstIterator it = tagIndices_.Find(tag);
+    if (it != tagIndices_.End())
     {
-        dest = it->second_;
+        dest = taggedNodes_[it->second_];
         return true;
     }
     else
         return false;
 }
 
+unsigned Scene::GetTagIndex(const String& tag)
+{
+    HashMap<StringHash, unsigned>::ConstIterator it = tagIndices_.Find(tag);
+    if (it != tagIndices_.End())
+        return it->second_;
+
+    unsigned index = tagNames_.Size();
+    tagIndices_[tag] = index;
+    tagNames_.Push(tag);
+    taggedNodes_.Resize(index + 1);
+    return index;
+}
+
+const String& Scene::GetTagName(unsigned index) const
+{
+    return index < tagNames_.Size() ? tagNames_[index] : String::EMPTY;
+}
+
 Component* Scene::GetComponent(unsigned id) const
 {
-    if (id < FIRST_LOCAL_ID)
-    {
-        HashMap<unsigned, Component*>::ConstIterator i = replicatedComponents_.Find(id);
-        return i != replicatedComponents_.End() ? i->second_ : 0;
-    }
-    else
+    return id < FIRST_LOCAL_ID ? replicatedComponents_.Find(id) : localComponents_.Find(id);
+}
+
+const PODVector<Component*>& Scene::GetComponentsByType(StringHash type) const
+{
+    static const PODVector<Component*> noComponents;
+
+    HashMap<StringHash, PODVector<Component*> >::ConstIterator i = typedComponents_.Find(type);
+    return i != typedComponents_.End() ? i->second_ : noComponents;
+}
+
+void Scene::GetDerivedComponentsByType(PODVector<Component*>& dest, StringHash type) const
+{
+    dest.Clear();
+
+    // All components in a list have the same type, so test only the first
+    for (HashMap<StringHash, PODVector<Component*> >::ConstIterator i = typedComponents_.Begin(); i != typedComponents_.End(); ++i)
     {
-        HashMap<unsigned, Component*>::ConstIterator i = localComponents_.Find(id);
-        return i != localComponents_.End() ? i->second_ : 0;
+        const PODVector<Component*>& components = i->second_;
+        if (!components.Empty() && components.Front()->GetTypeInfo()->IsTypeOf(type))
+            dest.Push(components);
     }
 }
 
@@ -759,6 +1540,8 @@ const String& Scene::GetVarName(StringHash hash) const
 
 void Scene::Update(float timeStep)
 {
+    URHO3D_MEMORY_CATEGORY(MC_SCENE);
+
     if (asyncLoading_)
     {
         UpdateAsyncLoading();
@@ -771,20 +1554,31 @@ void Scene::Update(float timeStep)
 
     timeStep *= timeScale_;
 
-    using namespace SceneUpdate;
+    // Update variable timestep logic
+    SceneUpdate::Data updateData;
+    updateData.scene_ = this;
+    updateData.timeStep_ = timeStep;
+    SendTypedEvent(updateData);
 
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_SCENE] = this;
-    eventData[P_TIMESTEP] = timeStep;
+    // Update logic components that have declared their update thread-safe
+    UpdateParallelLogic(parallelUpdates_, UpdateLogicWork, timeStep, parallelUpdateStats_);
 
-    // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
+    // Update scene attribute animation. Nodes and components are updated in one batch, other animated objects such as materials
+    // through the event
+    UpdateAttributeAnimationTargets(timeStep);
+    AttributeAnimationUpdate::Data animationData;
+    animationData.scene_ = this;
+    animationData.timeStep_ = timeStep;
+    SendTypedEvent(animationData);
 
-    // Update scene attribute animation.
-    SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
+    // Apply batched transform changes before the subsystems, such as physics, read the moved nodes
+    UpdateTransforms();
 
     // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
-    SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
+    SceneSubsystemUpdate::Data subsystemData;
+    subsystemData.scene_ = this;
+    subsystemData.timeStep_ = timeStep;
+    SendTypedEvent(subsystemData);
 
     // Update transform smoothing
     {
@@ -800,8 +1594,15 @@ void Scene::Update(float timeStep)
         SendEvent(E_UPDATESMOOTHING, smoothingData_);
     }
 
+    UpdateTransforms();
+
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    ScenePostUpdate::Data postUpdateData;
+    postUpdateData.scene_ = this;
+    postUpdateData.timeStep_ = timeStep;
+    SendTypedEvent(postUpdateData);
+
+    UpdateParallelLogic(parallelPostUpdates_, PostUpdateLogicWork, timeStep, parallelPostUpdateStats_);
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -809,10 +1610,49 @@ void Scene::Update(float timeStep)
     elapsedTime_ += timeStep;
 }
 
+void Scene::UpdateTransforms()
+{
+    if (transformStore_ && transformStore_->HasPendingChanges())
+    {
+        URHO3D_PROFILE(UpdateTransforms);
+        transformStore_->Update();
+    }
+
+    if (!markedDirtyNodes_.Empty())
+    {
+        URHO3D_PROFILE(SendMarkedDirty);
+
+        // Listeners may mark more nodes dirty, which are appended and sent in the same pass
+        for (unsigned i = 0; i < markedDirtyNodes_.Size(); ++i)
+        {
+            Node* node = markedDirtyNodes_[i];
+            if (node)
+            {
+                node->markedDirtyIndex_ = M_MAX_UNSIGNED;
+                node->SendMarkedDirty();
+            }
+        }
+        markedDirtyNodes_.Clear();
+    }
+}
+
+void Scene::QueueMarkedDirty(Node* node)
+{
+    node->markedDirtyIndex_ = markedDirtyNodes_.Size();
+    markedDirtyNodes_.Push(node);
+}
+
+void Scene::CancelMarkedDirty(Node* node)
+{
+    markedDirtyNodes_[node->markedDirtyIndex_] = 0;
+    node->markedDirtyIndex_ = M_MAX_UNSIGNED;
+}
+
 void Scene::BeginThreadedUpdate()
 {
     // Check the work queue subsystem whether it actually has created worker threads. If not, do not enter threaded mode.
-    if (GetSubsystem<WorkQueue>()->GetNumThreads())
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (queue && queue->GetNumThreads())
         threadedUpdate_ = true;
 }
 
@@ -839,6 +1679,122 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.Push(component);
 }
 
+void Scene::DelayedAddChild(Node* parent, Node* child)
+{
+    if (!parent || !child)
+        return;
+
+    DelayedChange change;
+    change.type_ = DELAYED_ADD_CHILD;
+    change.node_ = parent;
+    change.child_ = child;
+
+    MutexLock lock(sceneMutex_);
+    delayedChanges_.Push(change);
+}
+
+void Scene::DelayedRemoveNode(Node* node)
+{
+    if (!node)
+        return;
+
+    DelayedChange change;
+    change.type_ = DELAYED_REMOVE_NODE;
+    change.node_ = node;
+
+    MutexLock lock(sceneMutex_);
+    delayedChanges_.Push(change);
+}
+
+void Scene::DelayedCreateComponent(Node* node, StringHash type, CreateMode mode)
+{
+    if (!node)
+        return;
+
+    DelayedChange change;
+    change.type_ = DELAYED_CREATE_COMPONENT;
+    change.node_ = node;
+    change.componentType_ = type;
+    change.mode_ = mode;
+
+    MutexLock lock(sceneMutex_);
+    delayedChanges_.Push(change);
+}
+
+void Scene::DelayedRemoveComponent(Component* component)
+{
+    if (!component)
+        return;
+
+    DelayedChange change;
+    change.type_ = DELAYED_REMOVE_COMPONENT;
+    change.component_ = component;
+
+    MutexLock lock(sceneMutex_);
+    delayedChanges_.Push(change);
+}
+
+void Scene::AddParallelUpdate(LogicComponent* component, unsigned char mask)
+{
+    if (parallelLogicUpdating_)
+    {
+        DelayParallelUpdate(component);
+        return;
+    }
+
+    if (mask & USE_UPDATE)
+        AddToParallelList(parallelUpdates_, &LogicComponent::parallelUpdateIndex_, component);
+    if (mask & USE_POSTUPDATE)
+        AddToParallelList(parallelPostUpdates_, &LogicComponent::parallelPostUpdateIndex_, component);
+}
+
+void Scene::RemoveParallelUpdate(LogicComponent* component, unsigned char mask)
+{
+    if (parallelLogicUpdating_)
+    {
+        DelayParallelUpdate(component);
+        return;
+    }
+
+    if (mask & USE_UPDATE)
+        RemoveFromParallelList(parallelUpdates_, &LogicComponent::parallelUpdateIndex_, component);
+    if (mask & USE_POSTUPDATE)
+        RemoveFromParallelList(parallelPostUpdates_, &LogicComponent::parallelPostUpdateIndex_, component);
+}
+
+void Scene::AddAttributeAnimationTarget(Animatable* target)
+{
+    unsigned index = target->attributeAnimationIndex_;
+    if (index < attributeAnimationTargets_.Size() && attributeAnimationTargets_[index] == target)
+        return;
+
+    target->attributeAnimationIndex_ = attributeAnimationTargets_.Size();
+    attributeAnimationTargets_.Push(target);
+}
+
+void Scene::RemoveAttributeAnimationTarget(Animatable* target)
+{
+    unsigned index = target->attributeAnimationIndex_;
+    if (index < attributeAnimationTargets_.Size() && attributeAnimationTargets_[index] == target)
+    {
+        if (attributeAnimationsUpdating_)
+        {
+            attributeAnimationTargets_[index] = 0;
+            attributeAnimationTargetsRemoved_ = true;
+        }
+        else
+        {
+            // Move the last target into the freed slot
+            Animatable* last = attributeAnimationTargets_.Back();
+            attributeAnimationTargets_[index] = last;
+            last->attributeAnimationIndex_ = index;
+            attributeAnimationTargets_.Pop();
+        }
+    }
+
+    target->attributeAnimationIndex_ = M_MAX_UNSIGNED;
+}
+
 unsigned Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -915,6 +1871,9 @@ void Scene::NodeAdded(Node* node)
 
     node->SetScene(this);
 
+    if (node->HasAttributeAnimations())
+        AddAttributeAnimationTarget(node);
+
     // If the new node has an ID of zero (default), assign a replicated ID now
     unsigned id = node->GetID();
     if (!id)
@@ -926,27 +1885,27 @@ void Scene::NodeAdded(Node* node)
     // If node with same ID exists, remove the scene reference from it and overwrite with the new node
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Find(id);
-        if (i != replicatedNodes_.End() && i->second_ != node)
+        Node* existing = replicatedNodes_.Find(id);
+        if (existing && existing != node)
         {
             URHO3D_LOGWARNING("Overwriting node with ID " + String(id));
-            NodeRemoved(i->second_);
+            NodeRemoved(existing);
         }
 
-        replicatedNodes_[id] = node;
+        replicatedNodes_.Insert(id, node);
 
         MarkNetworkUpdate(node);
         MarkReplicationDirty(node);
     }
     else
     {
-        HashMap<unsigned, Node*>::Iterator i = localNodes_.Find(id);
-        if (i != localNodes_.End() && i->second_ != node)
+        Node* existing = localNodes_.Find(id);
+        if (existing && existing != node)
         {
             URHO3D_LOGWARNING("Overwriting node with ID " + String(id));
-            NodeRemoved(i->second_);
+            NodeRemoved(existing);
         }
-        localNodes_[id] = node;
+        localNodes_.Insert(id, node);
     }
 
     // Cache tag if already tagged.
@@ -954,7 +1913,7 @@ void Scene::NodeAdded(Node* node)
     {
         const StringVector& tags = node->GetTags();
         for (unsigned i = 0; i < tags.Size(); ++i)
-            taggedNodes_[tags[i]].Push(node);
+            NodeTagAdded(node, tags[i]);
     }
 
     // Add already created components and child nodes now
@@ -968,12 +1927,29 @@ void Scene::NodeAdded(Node* node)
 
 void Scene::NodeTagAdded(Node* node, const String& tag)
 {
-    taggedNodes_[tag].Push(node);
+    unsigned index = GetTagIndex(tag);
+    taggedNodes_[index].Push(node);
+
+    unsigned word = index >> 5;
+    PODVector<unsigned>& tagBits = node->tagBits_;
+    while (tagBits.Size() <= word)
+        tagBits.Push(0);
+    tagBits[word] |= 1u << (index & 31);
 }
 
 void Scene::NodeTagRemoved(Node* node, const String& tag)
 {
-    taggedNodes_[tag].Remove(node);
+    HashMap<StringHash, unsigned>::ConstIterator it = tagIndices_.Find(tag);
+    if (it == tagIndices_.End())
+        return;
+
+    unsigned index = it->second_;
+    taggedNodes_[index].Remove(node);
+
+    unsigned word = index >> 5;
+    PODVector<unsigned>& tagBits = node->tagBits_;
+    if (word < tagBits.Size())
+        tagBits[word] &= ~(1u << (index & 31));
 }
 
 void Scene::NodeRemoved(Node* node)
@@ -991,13 +1967,15 @@ void Scene::NodeRemoved(Node* node)
         localNodes_.Erase(id);
 
     node->ResetScene();
+    RemoveAttributeAnimationTarget(node);
 
     // Remove node from tag cache
     if (!node->GetTags().Empty())
     {
         const StringVector& tags = node->GetTags();
         for (unsigned i = 0; i < tags.Size(); ++i)
-            taggedNodes_[tags[i]].Remove(node);
+            NodeTagRemoved(node, tags[i]);
+        node->tagBits_.Clear();
     }
 
     // Remove components and child nodes as well
@@ -1025,27 +2003,38 @@ void Scene::ComponentAdded(Component* component)
 
     if (id < FIRST_LOCAL_ID)
     {
-        HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Find(id);
-        if (i != replicatedComponents_.End() && i->second_ != component)
+        Component* existing = replicatedComponents_.Find(id);
+        if (existing && existing != component)
         {
             URHO3D_LOGWARNING("Overwriting component with ID " + String(id));
-            ComponentRemoved(i->second_);
+            ComponentRemoved(existing);
         }
 
-        replicatedComponents_[id] = component;
+        replicatedComponents_.Insert(id, component);
     }
     else
     {
-        HashMap<unsigned, Component*>::Iterator i = localComponents_.Find(id);
-        if (i != localComponents_.End() && i->second_ != component)
+        Component* existing = localComponents_.Find(id);
+        if (existing && existing != component)
         {
             URHO3D_LOGWARNING("Overwriting component with ID " + String(id));
-            ComponentRemoved(i->second_);
+            ComponentRemoved(existing);
         }
 
-        localComponents_[id] = component;
+        localComponents_.Insert(id, component);
+    }
+
+    // Register by type unless already registered
+    PODVector<Component*>& typed = typedComponents_[component->GetType()];
+    if (component->typeIndex_ >= typed.Size() || typed[component->typeIndex_] != component)
+    {
+        component->typeIndex_ = typed.Size();
+        typed.Push(component);
     }
 
+    if (component->HasAttributeAnimations())
+        AddAttributeAnimationTarget(component);
+
     component->OnSceneSet(this);
 }
 
@@ -1060,6 +2049,23 @@ void Scene::ComponentRemoved(Component* component)
     else
         localComponents_.Erase(id);
 
+    // Unregister by type by moving the last component of the type into the freed slot
+    HashMap<StringHash, PODVector<Component*> >::Iterator i = typedComponents_.Find(component->GetType());
+    if (i != typedComponents_.End())
+    {
+        PODVector<Component*>& typed = i->second_;
+        unsigned index = component->typeIndex_;
+        if (index < typed.Size() && typed[index] == component)
+        {
+            Component* last = typed.Back();
+            typed[index] = last;
+            last->typeIndex_ = index;
+            typed.Pop();
+        }
+    }
+    component->typeIndex_ = M_MAX_UNSIGNED;
+    RemoveAttributeAnimationTarget(component);
+
     component->SetID(0);
     component->OnSceneSet(0);
 }
@@ -1112,11 +2118,11 @@ void Scene::CleanupConnection(Connection* connection)
 {
     Node::CleanupConnection(connection);
 
-    for (HashMap<unsigned, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
-        i->second_->CleanupConnection(connection);
+    for (IDTable<Node>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+        i->CleanupConnection(connection);
 
-    for (HashMap<unsigned, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
-        i->second_->CleanupConnection(connection);
+    for (IDTable<Component>::ConstIterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+        i->CleanupConnection(connection);
 }
 
 void Scene::MarkNetworkUpdate(Node* node)
@@ -1270,6 +2276,64 @@ void Scene::FinishAsyncLoading()
     SendEvent(E_ASYNCLOADFINISHED, eventData);
 }
 
+bool Scene::LoadStaged(Vector<StagedSceneObject>& objects, XMLFile* xmlFile, bool setInstanceDefault)
+{
+    URHO3D_PROFILE(LoadStagedScene);
+
+    // Read the IDs and convert the attribute values of all objects on the worker threads
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    StagedSceneConversion conversion;
+    conversion.context_ = context_;
+    if (xmlFile)
+    {
+        conversion.proxyFiles_.Resize(queue->GetNumThreads() + 1);
+        for (unsigned i = 0; i < conversion.proxyFiles_.Size(); ++i)
+            conversion.proxyFiles_[i] = new XMLFile(context_);
+    }
+    queue->ParallelFor(objects.Begin(), objects.End(), ConvertStagedAttributesWork, &conversion);
+
+    // Then create the nodes and components in file order and apply the converted values
+    RemoveAllChildren();
+    RemoveAllComponents();
+
+    SceneResolver resolver;
+    PODVector<Node*> nodes(objects.Size());
+    for (unsigned i = 0; i < objects.Size(); ++i)
+    {
+        StagedSceneObject& object = objects[i];
+        CreateMode mode = object.id_ < FIRST_LOCAL_ID ? REPLICATED : LOCAL;
+        XMLElement element = xmlFile ? XMLElement(xmlFile, object.xmlNode_) : XMLElement();
+
+        if (object.isNode_)
+        {
+            Node* node = object.parent_ == M_MAX_UNSIGNED ? this : nodes[object.parent_]->CreateChild(object.id_, mode);
+            nodes[i] = node;
+            resolver.AddNode(object.id_, node);
+            node->SetConvertedAttributes(&object.converted_);
+            if (!(xmlFile ? node->Animatable::LoadXML(element, setInstanceDefault) :
+                node->Animatable::LoadJSON(*object.jsonValue_, setInstanceDefault)))
+                return false;
+        }
+        else
+        {
+            Component* newComponent = nodes[object.parent_]->SafeCreateComponent(object.typeName_, StringHash(object.typeName_), mode,
+                object.id_);
+            if (newComponent)
+            {
+                resolver.AddComponent(object.id_, newComponent);
+                newComponent->SetConvertedAttributes(&object.converted_);
+                if (!(xmlFile ? newComponent->LoadXML(element, setInstanceDefault) :
+                    newComponent->LoadJSON(*object.jsonValue_, setInstanceDefault)))
+                    return false;
+            }
+        }
+    }
+
+    resolver.Resolve();
+    ApplyAttributes();
+    return true;
+}
+
 void Scene::FinishLoading(Deserializer* source)
 {
     if (source)
@@ -1528,6 +2592,162 @@ void Scene::PreloadResourcesJSON(const JSONValue& value)
 #endif
 }
 
+void Scene::UpdateParallelLogic(PODVector<LogicComponent*>& components, void (*workFunction)(const WorkItem*, unsigned), float timeStep,
+    ParallelForStats& stats)
+{
+    if (!components.Empty())
+    {
+        URHO3D_PROFILE(UpdateParallelLogic);
+
+        // Transform changes and dirty notifications inside the phase are handled as in the threaded octree update. The
+        // component lists must not change while they are being iterated, so registration changes are delayed as well
+        parallelLogicUpdating_ = true;
+        BeginThreadedUpdate();
+        WorkQueue* queue = GetSubsystem<WorkQueue>();
+        if (queue)
+            queue->ParallelFor(components.Begin(), components.End(), workFunction, &timeStep, &stats);
+        else
+        {
+            WorkItem item;
+            item.start_ = components.Begin().ptr_;
+            item.end_ = components.End().ptr_;
+            item.aux_ = &timeStep;
+            workFunction(&item, 0);
+        }
+        EndThreadedUpdate();
+        parallelLogicUpdating_ = false;
+    }
+
+    ApplyDelayedChanges();
+}
+
+void Scene::UpdateAttributeAnimationTargets(float timeStep)
+{
+    if (attributeAnimationTargets_.Empty())
+        return;
+
+    URHO3D_PROFILE(UpdateAttributeAnimations);
+
+    // If worker threads are available, evaluate all animations in parallel first. The spline tangents, which are otherwise
+    // calculated on demand, must be up to date beforehand
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    bool evaluated = false;
+    if (queue && queue->GetNumThreads() && attributeAnimationTargets_.Size() > 1)
+    {
+        for (PODVector<Animatable*>::ConstIterator i = attributeAnimationTargets_.Begin(); i != attributeAnimationTargets_.End(); ++i)
+            (*i)->PrepareAttributeAnimations();
+        queue->ParallelFor(attributeAnimationTargets_.Begin(), attributeAnimationTargets_.End(), EvaluateAttributeAnimationsWork,
+            &timeStep, &attributeAnimationStats_);
+        evaluated = true;
+    }
+
+    // Apply the values and send the event frames on the main thread. Without worker threads, evaluate in the same pass to touch
+    // each target only once. Targets added meanwhile are updated from the next frame
+    attributeAnimationsUpdating_ = true;
+    unsigned numTargets = attributeAnimationTargets_.Size();
+    for (unsigned i = 0; i < numTargets; ++i)
+    {
+        Animatable* target = attributeAnimationTargets_[i];
+        if (target)
+        {
+            if (!evaluated)
+                target->EvaluateAttributeAnimations(timeStep);
+            target->ApplyAttributeAnimations();
+        }
+    }
+    attributeAnimationsUpdating_ = false;
+
+    if (attributeAnimationTargetsRemoved_)
+    {
+        unsigned numRemaining = 0;
+        for (unsigned i = 0; i < attributeAnimationTargets_.Size(); ++i)
+        {
+            Animatable* target = attributeAnimationTargets_[i];
+            if (target)
+            {
+                target->attributeAnimationIndex_ = numRemaining;
+                attributeAnimationTargets_[numRemaining++] = target;
+            }
+        }
+        attributeAnimationTargets_.Resize(numRemaining);
+        attributeAnimationTargetsRemoved_ = false;
+    }
+}
+
+void Scene::ApplyDelayedChanges()
+{
+    if (delayedChanges_.Empty())
+        return;
+
+    URHO3D_PROFILE(ApplyDelayedChanges);
+
+    // Take weak references first, as an earlier change may destroy the node or component of a later one
+    Vector<WeakPtr<Node> > nodes(delayedChanges_.Size());
+    Vector<WeakPtr<Component> > components(delayedChanges_.Size());
+    for (unsigned i = 0; i < delayedChanges_.Size(); ++i)
+    {
+        nodes[i] = delayedChanges_[i].node_;
+        if (delayedChanges_[i].type_ == DELAYED_REMOVE_COMPONENT || delayedChanges_[i].type_ == DELAYED_PARALLEL_UPDATE)
+            components[i] = delayedChanges_[i].component_;
+    }
+
+    // Changes made by the node and component callbacks below are applied on the next call
+    Vector<DelayedChange> changes;
+    changes.Swap(delayedChanges_);
+
+    for (unsigned i = 0; i < changes.Size(); ++i)
+    {
+        const DelayedChange& change = changes[i];
+        Node* node = nodes[i];
+
+        switch (change.type_)
+        {
+        case DELAYED_ADD_CHILD:
+            if (node)
+                node->AddChild(change.child_);
+            break;
+
+        case DELAYED_REMOVE_NODE:
+            if (node)
+                node->Remove();
+            break;
+
+        case DELAYED_CREATE_COMPONENT:
+            if (node)
+                node->CreateComponent(change.componentType_, change.mode_);
+            break;
+
+        case DELAYED_REMOVE_COMPONENT:
+            if (components[i])
+                components[i]->Remove();
+            break;
+
+        case DELAYED_PARALLEL_UPDATE:
+            if (components[i])
+                SyncParallelUpdate(static_cast<LogicComponent*>(components[i].Get()));
+            break;
+        }
+    }
+}
+
+void Scene::DelayParallelUpdate(LogicComponent* component)
+{
+    DelayedChange change;
+    change.type_ = DELAYED_PARALLEL_UPDATE;
+    change.component_ = component;
+
+    MutexLock lock(sceneMutex_);
+    delayedChanges_.Push(change);
+}
+
+void Scene::SyncParallelUpdate(LogicComponent* component)
+{
+    // The component may have changed its mask several times or left the scene since the change was queued
+    unsigned char mask = component->parallelScene_ == this ? component->parallelMask_ : 0;
+    AddParallelUpdate(component, mask);
+    RemoveParallelUpdate(component, (unsigned char)((USE_UPDATE | USE_POSTUPDATE) & ~mask));
+}
+
 void RegisterSceneLibrary(Context* context)
 {
     ValueAnimation::RegisterObject(context);
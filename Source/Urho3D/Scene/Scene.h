@@ -23,17 +23,21 @@
 #pragma once
 
 #include "../Container/HashSet.h"
+#include "../Container/IDTable.h"
 #include "../Core/Mutex.h"
 #include "../Resource/XMLElement.h"
 #include "../Resource/JSONFile.h"
 #include "../Scene/Node.h"
 #include "../Scene/SceneResolver.h"
+#include "../Scene/TagQuery.h"
 
 namespace Urho3D
 {
 
 class File;
+class LogicComponent;
 class PackageFile;
+struct StagedSceneObject;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -51,6 +55,41 @@ enum LoadMode
     LOAD_SCENE_AND_RESOURCES
 };
 
+/// Type of a structural change delayed until the end of a parallel logic update.
+enum DelayedChangeType
+{
+    DELAYED_ADD_CHILD = 0,
+    DELAYED_REMOVE_NODE,
+    DELAYED_CREATE_COMPONENT,
+    DELAYED_REMOVE_COMPONENT,
+    DELAYED_PARALLEL_UPDATE
+};
+
+/// Structural change delayed until the end of a parallel logic update.
+struct DelayedChange
+{
+    /// Construct.
+    DelayedChange() :
+        node_(0),
+        component_(0),
+        mode_(REPLICATED)
+    {
+    }
+
+    /// Change type.
+    DelayedChangeType type_;
+    /// Parent node to add to, node to remove or node to create the component to.
+    Node* node_;
+    /// New child node to add.
+    SharedPtr<Node> child_;
+    /// Component to remove, or logic component whose parallel update registration changed.
+    Component* component_;
+    /// Type of component to create.
+    StringHash componentType_;
+    /// Create mode of the component.
+    CreateMode mode_;
+};
+
 /// Asynchronous loading progress of a scene.
 struct AsyncProgress
 {
@@ -119,6 +158,12 @@ public:
     bool SaveXML(Serializer& dest, const String& indentation = "\t") const;
     /// Save to a JSON file. Return true if successful.
     bool SaveJSON(Serializer& dest, const String& indentation = "\t") const;
+    /// Save to a packed binary file (scene format version 2), which has a string table and stores attributes in blocks by object type. Return true if successful.
+    bool SavePacked(Serializer& dest) const;
+    /// Load from a packed binary file by memory-mapping it. Packed files can also be loaded with Load(). Removes all existing child nodes and components first. Return true if successful.
+    bool LoadPacked(const String& fileName, bool setInstanceDefault = false);
+    /// Load from packed binary data in memory, starting with the file ID. The data is read in place. Removes all existing child nodes and components first. Return true if successful.
+    bool LoadPacked(const void* data, unsigned size, bool setInstanceDefault = false);
     /// Load from a binary file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
     bool LoadAsync(File* file, LoadMode mode = LOAD_SCENE_AND_RESOURCES);
     /// Load from an XML file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
@@ -154,6 +199,10 @@ public:
     void SetSnapThreshold(float threshold);
     /// Set maximum milliseconds per frame to spend on async scene loading.
     void SetAsyncLoadingMs(int ms);
+    /// Enable or disable the transform store for batched world transform updates. Suited to moving nodes with two or more levels of descendants. Gives no gain on flat scenes.
+    void SetTransformStoreEnabled(bool enable);
+    /// Enable or disable deferred dirty notifications. When enabled, a moved node's listener components are notified once in the next UpdateTransforms() instead of on every change.
+    void SetDeferredDirtyEnabled(bool enable);
     /// Add a required package file for networking. To be called on the server.
     void AddRequiredPackageFile(PackageFile* package);
     /// Clear required package files.
@@ -171,6 +220,20 @@ public:
     Component* GetComponent(unsigned id) const;
     /// Get nodes with specific tag from the whole scene, return false if empty.
     bool GetNodesWithTag(PODVector<Node*>& dest, const String& tag)  const;
+    /// Return the interned index of a tag for tag queries, registering the tag if not used yet. Indices stay valid for the scene's lifetime.
+    unsigned GetTagIndex(const String& tag);
+    /// Return a tag by interned index, or empty if not registered.
+    const String& GetTagName(unsigned index) const;
+    /// Return an iterator over the nodes matching a tag query. The query must outlive the iterator.
+    TagQueryIterator QueryTags(const TagQuery& query) const { return TagQueryIterator(taggedNodes_, query); }
+    /// Return all components of an exact type in the scene, including disabled ones. Components of derived types are not included. Removing a component changes the order.
+    const PODVector<Component*>& GetComponentsByType(StringHash type) const;
+    /// Return all components of a type or its derived types in the scene, including disabled ones.
+    void GetDerivedComponentsByType(PODVector<Component*>& dest, StringHash type) const;
+    /// Call a functor for each component of the exact type T in the scene and return the functor. Components of derived types are not included. The functor must not add or remove components of that type.
+    template <class T, class F> F ForEachComponent(F functor) const;
+    /// Call a functor for each component of type T or its derived types in the scene and return the functor. The functor must not add or remove components.
+    template <class T, class F> F ForEachDerivedComponent(F functor) const;
 
     /// Return whether updates are enabled.
     bool IsUpdateEnabled() const { return updateEnabled_; }
@@ -205,6 +268,15 @@ public:
     /// Return maximum milliseconds per frame to spend on async loading.
     int GetAsyncLoadingMs() const { return asyncLoadingMs_; }
 
+    /// Return whether the transform store is enabled.
+    bool IsTransformStoreEnabled() const { return transformStore_.NotNull(); }
+
+    /// Return the transform store, or null if not enabled.
+    TransformStore* GetTransformStore() const { return transformStore_; }
+
+    /// Return whether dirty notifications are deferred.
+    bool IsDeferredDirtyEnabled() const { return deferredDirty_; }
+
     /// Return required package files.
     const Vector<SharedPtr<PackageFile> >& GetRequiredPackageFiles() const { return requiredPackageFiles_; }
 
@@ -219,6 +291,28 @@ public:
     void EndThreadedUpdate();
     /// Add a component to the delayed dirty notify queue. Is thread-safe.
     void DelayedMarkedDirty(Component* component);
+    /// Queue a new node to be added as a child of the parent after the parallel logic update. The node must have been created outside the scene; the scene takes ownership of it. Is thread-safe.
+    void DelayedAddChild(Node* parent, Node* child);
+    /// Queue a node to be removed after the parallel logic update. Is thread-safe.
+    void DelayedRemoveNode(Node* node);
+    /// Queue a component to be created after the parallel logic update. Is thread-safe.
+    void DelayedCreateComponent(Node* node, StringHash type, CreateMode mode = REPLICATED);
+    /// Queue a component to be removed after the parallel logic update. Is thread-safe.
+    void DelayedRemoveComponent(Component* component);
+    /// Add a logic component to the parallel update or post-update phase. Called by LogicComponent. During a parallel phase the change is applied after it.
+    void AddParallelUpdate(LogicComponent* component, unsigned char mask);
+    /// Remove a logic component from the parallel update or post-update phase. Called by LogicComponent. During a parallel phase the change is applied after it.
+    void RemoveParallelUpdate(LogicComponent* component, unsigned char mask);
+    /// Add a node or component with attribute animations to the scene's animation update. Called by Node and Component.
+    void AddAttributeAnimationTarget(Animatable* target);
+    /// Remove a node or component from the scene's animation update. Called by Node and Component.
+    void RemoveAttributeAnimationTarget(Animatable* target);
+    /// Apply pending world transform changes of the transform store and send deferred dirty notifications, if enabled. Called during scene update and by the octree before rendering.
+    void UpdateTransforms();
+    /// Queue a node for deferred dirty notification. Called by Node.
+    void QueueMarkedDirty(Node* node);
+    /// Remove a node from the deferred dirty notification queue. Called by Node.
+    void CancelMarkedDirty(Node* node);
 
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
@@ -265,6 +359,8 @@ private:
     void UpdateAsyncLoading();
     /// Finish asynchronous loading.
     void FinishAsyncLoading();
+    /// Convert the attributes of staged XML or JSON scene objects on the worker threads, then create the nodes and components. When setInstanceDefault is set to true, store the loaded values as the instances' default values. Return true if successful.
+    bool LoadStaged(Vector<StagedSceneObject>& objects, XMLFile* xmlFile, bool setInstanceDefault);
     /// Finish loading. Sets the scene filename and checksum.
     void FinishLoading(Deserializer* source);
     /// Finish saving. Sets the scene filename and checksum.
@@ -275,17 +371,34 @@ private:
     void PreloadResourcesXML(const XMLElement& element);
     /// Preload resources from a JSON scene or object prefab file.
     void PreloadResourcesJSON(const JSONValue& value);
+    /// Run a parallel logic update phase and apply the structural changes queued during it.
+    void UpdateParallelLogic(PODVector<LogicComponent*>& components, void (*workFunction)(const WorkItem*, unsigned), float timeStep,
+        ParallelForStats& stats);
+    /// Apply the queued structural changes.
+    void ApplyDelayedChanges();
+    /// Queue a parallel update registration change made during a parallel phase.
+    void DelayParallelUpdate(LogicComponent* component);
+    /// Match the parallel update registration of a logic component to its current parallel mask.
+    void SyncParallelUpdate(LogicComponent* component);
+    /// Evaluate the attribute animations of all nodes and components, in parallel if possible, then apply the values.
+    void UpdateAttributeAnimationTargets(float timeStep);
 
     /// Replicated scene nodes by ID.
-    HashMap<unsigned, Node*> replicatedNodes_;
+    IDTable<Node> replicatedNodes_;
     /// Local scene nodes by ID.
-    HashMap<unsigned, Node*> localNodes_;
+    IDTable<Node> localNodes_;
     /// Replicated components by ID.
-    HashMap<unsigned, Component*> replicatedComponents_;
+    IDTable<Component> replicatedComponents_;
     /// Local components by ID.
-    HashMap<unsigned, Component*> localComponents_;
-    /// Cached tagged nodes by tag.
-    HashMap<StringHash, PODVector<Node*> > taggedNodes_;
+    IDTable<Component> localComponents_;
+    /// Interned tag indices by tag.
+    HashMap<StringHash, unsigned> tagIndices_;
+    /// Interned tags by index.
+    StringVector tagNames_;
+    /// Cached tagged nodes by tag index.
+    Vector<PODVector<Node*> > taggedNodes_;
+    /// Components by exact type.
+    HashMap<StringHash, PODVector<Component*> > typedComponents_;
     /// Asynchronous loading progress.
     AsyncProgress asyncProgress_;
     /// Node and component ID resolver for asynchronous loading.
@@ -300,10 +413,28 @@ private:
     HashSet<unsigned> networkUpdateNodes_;
     /// Components to check for attribute changes on the next network update.
     HashSet<unsigned> networkUpdateComponents_;
+    /// Transform store for batched world transform updates.
+    SharedPtr<TransformStore> transformStore_;
+    /// Deferred dirty notification queue for nodes. Removed nodes leave a null entry.
+    PODVector<Node*> markedDirtyNodes_;
     /// Delayed dirty notification queue for components.
     PODVector<Component*> delayedDirtyComponents_;
-    /// Mutex for the delayed dirty notification queue.
+    /// Structural changes queued during the parallel logic update.
+    Vector<DelayedChange> delayedChanges_;
+    /// Mutex for the delayed dirty notification and structural change queues.
     Mutex sceneMutex_;
+    /// Logic components updated in parallel.
+    PODVector<LogicComponent*> parallelUpdates_;
+    /// Logic components post-updated in parallel.
+    PODVector<LogicComponent*> parallelPostUpdates_;
+    /// Work splitting statistics for the parallel update.
+    ParallelForStats parallelUpdateStats_;
+    /// Work splitting statistics for the parallel post-update.
+    ParallelForStats parallelPostUpdateStats_;
+    /// Nodes and components with attribute animations.
+    PODVector<Animatable*> attributeAnimationTargets_;
+    /// Work splitting statistics for the attribute animation evaluation.
+    ParallelForStats attributeAnimationStats_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
     /// Next free non-local node ID.
@@ -332,8 +463,38 @@ private:
     bool asyncLoading_;
     /// Threaded update flag.
     bool threadedUpdate_;
+    /// Parallel logic update phase flag. Registration changes made meanwhile are delayed.
+    bool parallelLogicUpdating_;
+    /// Deferred dirty notifications flag.
+    bool deferredDirty_;
+    /// Applying attribute animations flag. Targets removed meanwhile are cleared and compacted afterward.
+    bool attributeAnimationsUpdating_;
+    /// Attribute animation targets removed during the update flag.
+    bool attributeAnimationTargetsRemoved_;
 };
 
+template <class T, class F> F Scene::ForEachComponent(F functor) const
+{
+    const PODVector<Component*>& components = GetComponentsByType(T::GetTypeStatic());
+    for (PODVector<Component*>::ConstIterator i = components.Begin(); i != components.End(); ++i)
+        functor(static_cast<T*>(*i));
+    return functor;
+}
+
+template <class T, class F> F Scene::ForEachDerivedComponent(F functor) const
+{
+    // All components in a list have the same type, so test only the first
+    for (HashMap<StringHash, PODVector<Component*> >::ConstIterator i = typedComponents_.Begin(); i != typedComponents_.End(); ++i)
+    {
+        const PODVector<Component*>& components = i->second_;
+        if (components.Empty() || !dynamic_cast<T*>(components.Front()))
+            continue;
+        for (PODVector<Component*>::ConstIterator j = components.Begin(); j != components.End(); ++j)
+            functor(static_cast<T*>(*j));
+    }
+    return functor;
+}
+
 /// Register Scene library objects.
 void URHO3D_API RegisterSceneLibrary(Context* context);
 
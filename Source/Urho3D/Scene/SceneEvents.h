@@ -27,11 +27,14 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
 {
     URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    URHO3D_EVENT_DATA_2(E_SCENEUPDATE, Scene*, scene_, P_SCENE, float, timeStep_, P_TIMESTEP);
 }
 
 /// Scene subsystem update.
@@ -39,6 +42,7 @@ URHO3D_EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
 {
     URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    URHO3D_EVENT_DATA_2(E_SCENESUBSYSTEMUPDATE, Scene*, scene_, P_SCENE, float, timeStep_, P_TIMESTEP);
 }
 
 /// Scene transform smoothing update.
@@ -70,6 +74,7 @@ URHO3D_EVENT(E_ATTRIBUTEANIMATIONUPDATE, AttributeAnimationUpdate)
 {
     URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    URHO3D_EVENT_DATA_2(E_ATTRIBUTEANIMATIONUPDATE, Scene*, scene_, P_SCENE, float, timeStep_, P_TIMESTEP);
 }
 
 /// Attribute animation added to object animation.
@@ -91,6 +96,7 @@ URHO3D_EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
 {
     URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+    URHO3D_EVENT_DATA_2(E_SCENEPOSTUPDATE, Scene*, scene_, P_SCENE, float, timeStep_, P_TIMESTEP);
 }
 
 /// Asynchronous scene loading progress.
@@ -55,10 +55,114 @@ static unsigned RemapAttributeIndex(const Vector<AttributeInfo>* attributes, con
     return netAttrIndex; // Could not remap
 }
 
+static unsigned FindFileAttribute(const Vector<AttributeInfo>* attributes, const String& name, unsigned& startIndex)
+{
+    // Start from the attribute after the previous match, as attributes are usually saved in order
+    unsigned i = startIndex;
+    for (unsigned attempts = attributes->Size(); attempts; --attempts)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if ((attr.mode_ & AM_FILE) && !attr.name_.Compare(name, true))
+        {
+            startIndex = (i + 1) % attributes->Size();
+            return i;
+        }
+        i = (i + 1) % attributes->Size();
+    }
+
+    return M_MAX_UNSIGNED;
+}
+
+static Variant GetEnumValue(const AttributeInfo& attr, const String& value)
+{
+    int enumValue = 0;
+    for (const char** enumPtr = attr.enumNames_; *enumPtr; ++enumPtr, ++enumValue)
+    {
+        if (!value.Compare(*enumPtr, false))
+            return enumValue;
+    }
+
+    URHO3D_LOGWARNING("Unknown enum value " + value + " in attribute " + attr.name_);
+    return Variant::EMPTY;
+}
+
+void ConvertedAttributes::ConvertXML(const XMLElement& source, const Vector<AttributeInfo>* attributes)
+{
+    Clear();
+    attributes_ = attributes;
+    if (!attributes)
+        return;
+
+    XMLElement attrElem = source.GetChild("attribute");
+    unsigned startIndex = 0;
+
+    while (attrElem)
+    {
+        String name = attrElem.GetAttribute("name");
+        unsigned index = FindFileAttribute(attributes, name, startIndex);
+        if (index != M_MAX_UNSIGNED)
+        {
+            const AttributeInfo& attr = attributes->At(index);
+            Variant value = attr.enumNames_ ? GetEnumValue(attr, attrElem.GetAttribute("value")) :
+                attrElem.GetVariantValue(attr.type_);
+            if (!value.IsEmpty())
+            {
+                indices_.Push(index);
+                values_.Push(value);
+            }
+        }
+        else
+            URHO3D_LOGWARNING("Unknown attribute " + name + " in XML data");
+
+        attrElem = attrElem.GetNext("attribute");
+    }
+}
+
+void ConvertedAttributes::ConvertJSON(const JSONValue& source, const Vector<AttributeInfo>* attributes)
+{
+    Clear();
+    attributes_ = attributes;
+    if (!attributes)
+        return;
+
+    const JSONValue& attributesValue = source.Get("attributes");
+    if (!attributesValue.IsObject())
+        return;
+
+    const JSONObject& attributesObject = attributesValue.GetObject();
+    unsigned startIndex = 0;
+
+    for (JSONObject::ConstIterator it = attributesObject.Begin(); it != attributesObject.End(); ++it)
+    {
+        unsigned index = FindFileAttribute(attributes, it->first_, startIndex);
+        if (index != M_MAX_UNSIGNED)
+        {
+            const AttributeInfo& attr = attributes->At(index);
+            Variant value = attr.enumNames_ ? GetEnumValue(attr, it->second_.GetString()) :
+                it->second_.GetVariantValue(attr.type_);
+            if (!value.IsEmpty())
+            {
+                indices_.Push(index);
+                values_.Push(value);
+            }
+        }
+        else
+            URHO3D_LOGWARNING("Unknown attribute " + it->first_ + " in JSON data");
+    }
+}
+
+void ConvertedAttributes::Clear()
+{
+    attributes_ = 0;
+    indices_.Clear();
+    values_.Clear();
+}
+
 Serializable::Serializable(Context* context) :
     Object(context),
     networkState_(0),
     instanceDefaultValues_(0),
+    convertedAttributes_(0),
     temporary_(false)
 {
 }
@@ -333,6 +437,9 @@ bool Serializable::Save(Serializer& dest) const
 
 bool Serializable::LoadXML(const XMLElement& source, bool setInstanceDefault)
 {
+    const ConvertedAttributes* converted = convertedAttributes_;
+    convertedAttributes_ = 0;
+
     if (source.IsNull())
     {
         URHO3D_LOGERROR("Could not load " + GetTypeName() + ", null source element");
@@ -343,66 +450,35 @@ bool Serializable::LoadXML(const XMLElement& source, bool setInstanceDefault)
     if (!attributes)
         return true;
 
+    if (converted && converted->attributes_ == attributes)
+    {
+        ApplyConvertedAttributes(*converted, setInstanceDefault);
+        return true;
+    }
+
     XMLElement attrElem = source.GetChild("attribute");
     unsigned startIndex = 0;
 
     while (attrElem)
     {
         String name = attrElem.GetAttribute("name");
-        unsigned i = startIndex;
-        unsigned attempts = attributes->Size();
-
-        while (attempts)
+        unsigned index = FindFileAttribute(attributes, name, startIndex);
+        if (index != M_MAX_UNSIGNED)
         {
-            const AttributeInfo& attr = attributes->At(i);
-            if ((attr.mode_ & AM_FILE) && !attr.name_.Compare(name, true))
-            {
-                Variant varValue;
-
-                // If enums specified, do enum lookup and int assignment. Otherwise assign the variant directly
-                if (attr.enumNames_)
-                {
-                    String value = attrElem.GetAttribute("value");
-                    bool enumFound = false;
-                    int enumValue = 0;
-                    const char** enumPtr = attr.enumNames_;
-                    while (*enumPtr)
-                    {
-                        if (!value.Compare(*enumPtr, false))
-                        {
-                            enumFound = true;
-                            break;
-                        }
-                        ++enumPtr;
-                        ++enumValue;
-                    }
-                    if (enumFound)
-                        varValue = enumValue;
-                    else
-                        URHO3D_LOGWARNING("Unknown enum value " + value + " in attribute " + attr.name_);
-                }
-                else
-                    varValue = attrElem.GetVariantValue(attr.type_);
-
-                if (!varValue.IsEmpty())
-                {
-                    OnSetAttribute(attr, varValue);
-
-                    if (setInstanceDefault)
-                        SetInstanceDefault(attr.name_, varValue);
-                }
-
-                startIndex = (i + 1) % attributes->Size();
-                break;
-            }
-            else
+            const AttributeInfo& attr = attributes->At(index);
+
+            // If enums specified, do enum lookup and int assignment. Otherwise assign the variant directly
+            Variant varValue = attr.enumNames_ ? GetEnumValue(attr, attrElem.GetAttribute("value")) :
+                attrElem.GetVariantValue(attr.type_);
+            if (!varValue.IsEmpty())
             {
-                i = (i + 1) % attributes->Size();
-                --attempts;
+                OnSetAttribute(attr, varValue);
+
+                if (setInstanceDefault)
+                    SetInstanceDefault(attr.name_, varValue);
             }
         }
-
-        if (!attempts)
+        else
             URHO3D_LOGWARNING("Unknown attribute " + name + " in XML data");
 
         attrElem = attrElem.GetNext("attribute");
@@ -413,6 +489,9 @@ bool Serializable::LoadXML(const XMLElement& source, bool setInstanceDefault)
 
 bool Serializable::LoadJSON(const JSONValue& source, bool setInstanceDefault)
 {
+    const ConvertedAttributes* converted = convertedAttributes_;
+    convertedAttributes_ = 0;
+
     if (source.IsNull())
     {
         URHO3D_LOGERROR("Could not load " + GetTypeName() + ", null JSON source element");
@@ -434,76 +513,53 @@ bool Serializable::LoadJSON(const JSONValue& source, bool setInstanceDefault)
         return true;
     }
 
-    const JSONObject& attributesObject = attributesValue.GetObject();
+    if (converted && converted->attributes_ == attributes)
+    {
+        ApplyConvertedAttributes(*converted, setInstanceDefault);
+        return true;
+    }
 
+    const JSONObject& attributesObject = attributesValue.GetObject();
     unsigned startIndex = 0;
 
-    for (JSONObject::ConstIterator it = attributesObject.Begin(); it != attributesObject.End();)
+    for (JSONObject::ConstIterator it = attributesObject.Begin(); it != attributesObject.End(); ++it)
     {
-        String name = it->first_;
+        const String& name = it->first_;
         const JSONValue& value = it->second_;
-        unsigned i = startIndex;
-        unsigned attempts = attributes->Size();
-
-        while (attempts)
+        unsigned index = FindFileAttribute(attributes, name, startIndex);
+        if (index != M_MAX_UNSIGNED)
         {
-            const AttributeInfo& attr = attributes->At(i);
-            if ((attr.mode_ & AM_FILE) && !attr.name_.Compare(name, true))
-            {
-                Variant varValue;
-
-                // If enums specified, do enum lookup ad int assignment. Otherwise assign variant directly
-                if (attr.enumNames_)
-                {
-                    String valueStr = value.GetString();
-                    bool enumFound = false;
-                    int enumValue = 0;
-                    const char** enumPtr = attr.enumNames_;
-                    while (*enumPtr)
-                    {
-                        if (!valueStr.Compare(*enumPtr, false))
-                        {
-                            enumFound = true;
-                            break;
-                        }
-                        ++enumPtr;
-                        ++enumValue;
-                    }
-                    if (enumFound)
-                        varValue = enumValue;
-                    else
-                        URHO3D_LOGWARNING("Unknown enum value " + valueStr + " in attribute " + attr.name_);
-                }
-                else
-                    varValue = value.GetVariantValue(attr.type_);
-
-                if (!varValue.IsEmpty())
-                {
-                    OnSetAttribute(attr, varValue);
-
-                    if (setInstanceDefault)
-                        SetInstanceDefault(attr.name_, varValue);
-                }
-
-                startIndex = (i + 1) % attributes->Size();
-                break;
-            }
-            else
+            const AttributeInfo& attr = attributes->At(index);
+
+            // If enums specified, do enum lookup and int assignment. Otherwise assign the variant directly
+            Variant varValue = attr.enumNames_ ? GetEnumValue(attr, value.GetString()) : value.GetVariantValue(attr.type_);
+            if (!varValue.IsEmpty())
             {
-                i = (i + 1) % attributes->Size();
-                --attempts;
+                OnSetAttribute(attr, varValue);
+
+                if (setInstanceDefault)
+                    SetInstanceDefault(attr.name_, varValue);
             }
         }
-
-        if (!attempts)
+        else
             URHO3D_LOGWARNING("Unknown attribute " + name + " in JSON data");
-
-        it++;
     }
 
     return true;
 }
 
+void Serializable::ApplyConvertedAttributes(const ConvertedAttributes& converted, bool setInstanceDefault)
+{
+    for (unsigned i = 0; i < converted.indices_.Size(); ++i)
+    {
+        const AttributeInfo& attr = converted.attributes_->At(converted.indices_[i]);
+        OnSetAttribute(attr, converted.values_[i]);
+
+        if (setInstanceDefault)
+            SetInstanceDefault(attr.name_, converted.values_[i]);
+    }
+}
+
 bool Serializable::SaveXML(XMLElement& dest) const
 {
     if (dest.IsNull())
@@ -624,22 +680,22 @@ bool Serializable::SetAttribute(const String& name, const Variant& value)
         return false;
     }
 
-    for (Vector<AttributeInfo>::ConstIterator i = attributes->Begin(); i != attributes->End(); ++i)
+    unsigned index = GetAttributeIndex(name);
+    if (index != M_MAX_UNSIGNED)
     {
-        if (!i->name_.Compare(name, true))
+        const AttributeInfo& attr = attributes->At(index);
+
+        // Check that the new value's type matches the attribute type
+        if (value.GetType() == attr.type_)
         {
-            // Check that the new value's type matches the attribute type
-            if (value.GetType() == i->type_)
-            {
-                OnSetAttribute(*i, value);
-                return true;
-            }
-            else
-            {
-                URHO3D_LOGERROR("Could not set attribute " + i->name_ + ": expected type " + Variant::GetTypeName(i->type_)
-                         + " but got " + value.GetTypeName());
-                return false;
-            }
+            OnSetAttribute(attr, value);
+            return true;
+        }
+        else
+        {
+            URHO3D_LOGERROR("Could not set attribute " + attr.name_ + ": expected type " + Variant::GetTypeName(attr.type_)
+                     + " but got " + value.GetTypeName());
+            return false;
         }
     }
 
@@ -916,13 +972,11 @@ Variant Serializable::GetAttribute(const String& name) const
         return ret;
     }
 
-    for (Vector<AttributeInfo>::ConstIterator i = attributes->Begin(); i != attributes->End(); ++i)
+    unsigned index = GetAttributeIndex(name);
+    if (index != M_MAX_UNSIGNED)
     {
-        if (!i->name_.Compare(name, true))
-        {
-            OnGetAttribute(*i, ret);
-            return ret;
-        }
+        OnGetAttribute(attributes->At(index), ret);
+        return ret;
     }
 
     URHO3D_LOGERROR("Could not find attribute " + name + " in " + GetTypeName());
@@ -943,7 +997,7 @@ Variant Serializable::GetAttributeDefault(unsigned index) const
         return Variant::EMPTY;
     }
 
-    AttributeInfo attr = attributes->At(index);
+    const AttributeInfo& attr = attributes->At(index);
     Variant defaultValue = GetInstanceDefault(attr.name_);
     return defaultValue.IsEmpty() ? attr.defaultValue_ : defaultValue;
 }
@@ -961,16 +1015,37 @@ Variant Serializable::GetAttributeDefault(const String& name) const
         return Variant::EMPTY;
     }
 
-    for (Vector<AttributeInfo>::ConstIterator i = attributes->Begin(); i != attributes->End(); ++i)
-    {
-        if (!i->name_.Compare(name, true))
-            return i->defaultValue_;
-    }
+    unsigned index = GetAttributeIndex(name);
+    if (index != M_MAX_UNSIGNED)
+        return attributes->At(index).defaultValue_;
 
     URHO3D_LOGERROR("Could not find attribute " + name + " in " + GetTypeName());
     return Variant::EMPTY;
 }
 
+unsigned Serializable::GetAttributeIndex(const String& name) const
+{
+    const Vector<AttributeInfo>* attributes = GetAttributes();
+    if (!attributes)
+        return M_MAX_UNSIGNED;
+
+    // Registered attributes are indexed by name hash. Objects with their own attribute descriptions are searched linearly
+    if (attributes == context_->GetAttributes(GetType()))
+    {
+        unsigned index = context_->GetAttributeIndex(GetType(), StringHash(name));
+        if (index == M_MAX_UNSIGNED || !attributes->At(index).name_.Compare(name, true))
+            return index;
+    }
+
+    for (unsigned i = 0; i < attributes->Size(); ++i)
+    {
+        if (!attributes->At(i).name_.Compare(name, true))
+            return i;
+    }
+
+    return M_MAX_UNSIGNED;
+}
+
 unsigned Serializable::GetNumAttributes() const
 {
     const Vector<AttributeInfo>* attributes = GetAttributes();
@@ -40,6 +40,30 @@ struct DirtyBits;
 struct NetworkState;
 struct ReplicationState;
 
+/// Attribute values converted from XML or JSON data ahead of loading. Converting only reads the source data and the attribute descriptions, so it can be done on a worker thread.
+struct URHO3D_API ConvertedAttributes
+{
+    /// Construct.
+    ConvertedAttributes() :
+        attributes_(0)
+    {
+    }
+
+    /// Convert the attribute elements of an XML element.
+    void ConvertXML(const XMLElement& source, const Vector<AttributeInfo>* attributes);
+    /// Convert the attributes object of a JSON value.
+    void ConvertJSON(const JSONValue& source, const Vector<AttributeInfo>* attributes);
+    /// Clear the values.
+    void Clear();
+
+    /// Attribute descriptions the values were converted for.
+    const Vector<AttributeInfo>* attributes_;
+    /// Attribute description index of each value.
+    PODVector<unsigned> indices_;
+    /// Converted values.
+    Vector<Variant> values_;
+};
+
 /// Base class for objects with automatic serialization through attributes.
 class URHO3D_API Serializable : public Object
 {
@@ -91,6 +115,8 @@ public:
     void RemoveInstanceDefault();
     /// Set temporary flag. Temporary objects will not be saved.
     void SetTemporary(bool enable);
+    /// Set attribute values converted in advance for the next LoadXML() or LoadJSON() call, which applies them instead of converting the source. They are ignored if converted for other attribute descriptions. The values must stay valid until the call.
+    void SetConvertedAttributes(const ConvertedAttributes* attributes) { convertedAttributes_ = attributes; }
     /// Enable interception of an attribute from network updates. Intercepted attributes are sent as events instead of applying directly. This can be used to implement client side prediction.
     void SetInterceptNetworkUpdate(const String& attributeName, bool enable);
     /// Allocate network attribute state.
@@ -114,6 +140,8 @@ public:
     Variant GetAttributeDefault(unsigned index) const;
     /// Return attribute default value by name. Return empty if not found.
     Variant GetAttributeDefault(const String& name) const;
+    /// Return attribute index by name, or M_MAX_UNSIGNED if not found.
+    unsigned GetAttributeIndex(const String& name) const;
     /// Return number of attributes.
     unsigned GetNumAttributes() const;
     /// Return number of network replication attributes.
@@ -137,9 +165,13 @@ private:
     void SetInstanceDefault(const String& name, const Variant& defaultValue);
     /// Get instance-level default value.
     Variant GetInstanceDefault(const String& name) const;
+    /// Apply converted attribute values.
+    void ApplyConvertedAttributes(const ConvertedAttributes& converted, bool setInstanceDefault);
 
     /// Attribute default value at each instance level.
     VariantMap* instanceDefaultValues_;
+    /// Attribute values converted in advance for the next load.
+    const ConvertedAttributes* convertedAttributes_;
     /// Temporary flag.
     bool temporary_;
 };
@@ -250,12 +282,12 @@ public:
         dest = (classPtr->*getFunction_)();
     }
 
-    /// Invoke setter function.
+    /// Invoke setter function. Values passed by reference are taken from the variant without a copy.
     virtual void Set(Serializable* ptr, const Variant& value)
     {
         assert(ptr);
         T* classPtr = static_cast<T*>(ptr);
-        (classPtr->*setFunction_)(value.Get < U > ());
+        (classPtr->*setFunction_)(value.Get<typename Trait::ParameterType>());
     }
 
     /// Class-specific pointer to getter function.
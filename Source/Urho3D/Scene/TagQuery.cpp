@@ -0,0 +1,209 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Scene/Node.h"
+#include "../Scene/TagQuery.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static inline bool HasBit(const PODVector<unsigned>& bits, unsigned tag)
+{
+    unsigned word = tag >> 5;
+    return word < bits.Size() && (bits[word] & (1u << (tag & 31)));
+}
+
+TagQuery::TagQuery()
+{
+}
+
+TagQuery& TagQuery::Require(unsigned tag)
+{
+    requiredTags_.Push(tag);
+    SetBit(requiredMask_, tag);
+    return *this;
+}
+
+TagQuery& TagQuery::Optional(unsigned tag)
+{
+    optionalTags_.Push(tag);
+    SetBit(optionalMask_, tag);
+    return *this;
+}
+
+TagQuery& TagQuery::Exclude(unsigned tag)
+{
+    SetBit(excludedMask_, tag);
+    return *this;
+}
+
+void TagQuery::Clear()
+{
+    requiredTags_.Clear();
+    optionalTags_.Clear();
+    requiredMask_.Clear();
+    optionalMask_.Clear();
+    excludedMask_.Clear();
+}
+
+bool TagQuery::Matches(const PODVector<unsigned>& tagBits) const
+{
+    unsigned numBits = tagBits.Size();
+
+    for (unsigned i = 0; i < requiredMask_.Size(); ++i)
+    {
+        unsigned bits = i < numBits ? tagBits[i] : 0;
+        if ((bits & requiredMask_[i]) != requiredMask_[i])
+            return false;
+    }
+
+    if (!optionalMask_.Empty())
+    {
+        bool found = false;
+        for (unsigned i = 0; i < optionalMask_.Size() && i < numBits; ++i)
+        {
+            if (tagBits[i] & optionalMask_[i])
+            {
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            return false;
+    }
+
+    for (unsigned i = 0; i < excludedMask_.Size() && i < numBits; ++i)
+    {
+        if (tagBits[i] & excludedMask_[i])
+            return false;
+    }
+
+    return true;
+}
+
+void TagQuery::SetBit(PODVector<unsigned>& mask, unsigned tag)
+{
+    unsigned word = tag >> 5;
+    while (mask.Size() <= word)
+        mask.Push(0);
+    mask[word] |= 1u << (tag & 31);
+}
+
+TagQueryIterator::TagQueryIterator(const Vector<PODVector<Node*> >& taggedNodes, const TagQuery& query) :
+    taggedNodes_(&taggedNodes),
+    query_(&query),
+    list_(0),
+    optionalIndex_(M_MAX_UNSIGNED),
+    position_(0)
+{
+    const PODVector<unsigned>& requiredTags = query.GetRequiredTags();
+    if (!requiredTags.Empty())
+    {
+        // Walk the shortest list of the required tags and test the rest of the query on each node
+        for (unsigned i = 0; i < requiredTags.Size(); ++i)
+        {
+            if (requiredTags[i] >= taggedNodes.Size())
+            {
+                list_ = 0;
+                return;
+            }
+            const PODVector<Node*>& list = taggedNodes[requiredTags[i]];
+            if (!list_ || list.Size() < list_->Size())
+                list_ = &list;
+        }
+    }
+    else if (!NextOptionalList())
+        return;
+
+    SkipNonMatching();
+}
+
+TagQueryIterator& TagQueryIterator::operator ++()
+{
+    ++position_;
+    SkipNonMatching();
+    return *this;
+}
+
+void TagQueryIterator::SkipNonMatching()
+{
+    while (list_)
+    {
+        if (position_ >= list_->Size())
+        {
+            if (optionalIndex_ == M_MAX_UNSIGNED || !NextOptionalList())
+            {
+                list_ = 0;
+                return;
+            }
+            continue;
+        }
+
+        const PODVector<unsigned>& tagBits = (*list_)[position_]->GetTagBits();
+        if (query_->Matches(tagBits))
+        {
+            // When walking the optional tags' lists in turn, a node with an earlier optional tag was already visited
+            bool visited = false;
+            if (optionalIndex_ != M_MAX_UNSIGNED)
+            {
+                const PODVector<unsigned>& optionalTags = query_->GetOptionalTags();
+                for (unsigned i = 0; i < optionalIndex_; ++i)
+                {
+                    if (HasBit(tagBits, optionalTags[i]))
+                    {
+                        visited = true;
+                        break;
+                    }
+                }
+            }
+            if (!visited)
+                return;
+        }
+
+        ++position_;
+    }
+}
+
+bool TagQueryIterator::NextOptionalList()
+{
+    const PODVector<unsigned>& optionalTags = query_->GetOptionalTags();
+    for (unsigned i = optionalIndex_ + 1; i < optionalTags.Size(); ++i)
+    {
+        if (optionalTags[i] < taggedNodes_->Size())
+        {
+            optionalIndex_ = i;
+            list_ = &(*taggedNodes_)[optionalTags[i]];
+            position_ = 0;
+            return true;
+        }
+    }
+
+    list_ = 0;
+    return false;
+}
+
+}
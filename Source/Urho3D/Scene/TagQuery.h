@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Vector.h"
+
+namespace Urho3D
+{
+
+class Node;
+
+/// Node query by interned scene tag indices, see Scene::GetTagIndex(). A node matches if it has all of the required tags, at least one of the optional tags if any are given, and none of the excluded tags. At least one required or optional tag must be given; otherwise the query matches nothing.
+class URHO3D_API TagQuery
+{
+public:
+    /// Construct empty.
+    TagQuery();
+
+    /// Require a tag (AND.)
+    TagQuery& Require(unsigned tag);
+    /// Add an optional tag, of which at least one must be present (OR.)
+    TagQuery& Optional(unsigned tag);
+    /// Exclude a tag (NOT.)
+    TagQuery& Exclude(unsigned tag);
+    /// Remove all tags from the query.
+    void Clear();
+
+    /// Return whether a node's tag bits match the query.
+    bool Matches(const PODVector<unsigned>& tagBits) const;
+
+    /// Return required tag indices.
+    const PODVector<unsigned>& GetRequiredTags() const { return requiredTags_; }
+
+    /// Return optional tag indices.
+    const PODVector<unsigned>& GetOptionalTags() const { return optionalTags_; }
+
+private:
+    /// Set a bit in a mask, growing it as necessary.
+    static void SetBit(PODVector<unsigned>& mask, unsigned tag);
+
+    /// Required tag indices.
+    PODVector<unsigned> requiredTags_;
+    /// Optional tag indices.
+    PODVector<unsigned> optionalTags_;
+    /// Required tag bits.
+    PODVector<unsigned> requiredMask_;
+    /// Optional tag bits.
+    PODVector<unsigned> optionalMask_;
+    /// Excluded tag bits.
+    PODVector<unsigned> excludedMask_;
+};
+
+/// Iterator over the nodes matching a tag query, see Scene::QueryTags(). Walks the scene's tagged node lists in place without copying or allocating. Adding or removing tags or nodes in the scene invalidates the iterator.
+class URHO3D_API TagQueryIterator
+{
+public:
+    /// Construct over the scene's tagged node lists.
+    TagQueryIterator(const Vector<PODVector<Node*> >& taggedNodes, const TagQuery& query);
+
+    /// Return the current node.
+    Node* operator *() const { return (*list_)[position_]; }
+    /// Point to the current node.
+    Node* operator ->() const { return (*list_)[position_]; }
+    /// Advance to the next matching node.
+    TagQueryIterator& operator ++();
+
+    /// Return whether all matching nodes have been iterated.
+    bool IsEnd() const { return !list_; }
+
+private:
+    /// Skip to the first matching node at or after the current position.
+    void SkipNonMatching();
+    /// Move to the node list of the next optional tag. Return false if none left.
+    bool NextOptionalList();
+
+    /// Scene's tagged node lists by tag index.
+    const Vector<PODVector<Node*> >* taggedNodes_;
+    /// Query.
+    const TagQuery* query_;
+    /// Current node list, null when at end.
+    const PODVector<Node*>* list_;
+    /// Index of the current list in the query's optional tags, or M_MAX_UNSIGNED when iterating a required tag's list.
+    unsigned optionalIndex_;
+    /// Position in the current list.
+    unsigned position_;
+};
+
+}
@@ -0,0 +1,412 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Scene/Scene.h"
+#include "../Scene/TransformStore.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Node has been marked dirty and its children not yet.
+static const unsigned char TRANSFORM_PENDING = 1;
+/// Node's parent has been updated in this pass.
+static const unsigned char TRANSFORM_INHERITED = 2;
+/// Pending node has been updated in this pass.
+static const unsigned char TRANSFORM_UPDATED = 3;
+/// Minimum number of nodes on a hierarchy level to split the update to worker threads.
+static const unsigned MIN_PARALLEL_NODES = 256;
+
+TransformStore::TransformStore(Scene* scene) :
+    scene_(scene)
+{
+    levels_.Push(0);
+}
+
+TransformStore::~TransformStore()
+{
+}
+
+void TransformStore::AddNode(Node* node)
+{
+    PlaceNode(node);
+}
+
+void TransformStore::RemoveNode(Node* node)
+{
+    UnplaceNode(node);
+}
+
+void TransformStore::ReparentNode(Node* node)
+{
+    unsigned index = node->transformIndex_;
+    if (index != M_MAX_UNSIGNED)
+    {
+        // If the depth stays the same, only the parent index changes. Otherwise the subtree moves to other levels
+        Node* parent = node->parent_;
+        if (parent == scene_ && GetLevel(index) == 0)
+        {
+            parents_[index] = M_MAX_UNSIGNED;
+            return;
+        }
+        if (parent && parent->transformIndex_ != M_MAX_UNSIGNED && GetLevel(index) == GetLevel(parent->transformIndex_) + 1)
+        {
+            parents_[index] = parent->transformIndex_;
+            return;
+        }
+
+        UnplaceNode(node);
+    }
+
+    PlaceNode(node);
+}
+
+void TransformStore::MarkPending(Node* node)
+{
+    if (node->transformPendingIndex_ != M_MAX_UNSIGNED)
+        return;
+
+    node->transformPendingIndex_ = pendingNodes_.Size();
+    pendingNodes_.Push(node);
+    flags_[node->transformIndex_] = TRANSFORM_PENDING;
+}
+
+void TransformStore::ResolvePending(Node* node)
+{
+    unsigned pendingIndex = node->transformPendingIndex_;
+    if (pendingIndex == M_MAX_UNSIGNED)
+        return;
+
+    // Swap with the last pending node to avoid O(n^2) behavior
+    Node* last = pendingNodes_.Back();
+    pendingNodes_[pendingIndex] = last;
+    last->transformPendingIndex_ = pendingIndex;
+    pendingNodes_.Pop();
+    node->transformPendingIndex_ = M_MAX_UNSIGNED;
+    flags_[node->transformIndex_] = 0;
+
+    const Vector<SharedPtr<Node> >& children = node->children_;
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        (*i)->MarkDirtyRecursive();
+}
+
+void TransformStore::Rebuild()
+{
+    // Pending changes do not survive the rebuild, so resolve them first
+    while (pendingNodes_.Size())
+        ResolvePending(pendingNodes_.Back());
+
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+        nodes_[i]->transformIndex_ = M_MAX_UNSIGNED;
+    nodes_.Clear();
+    parents_.Clear();
+    levels_.Clear();
+
+    const Vector<SharedPtr<Node> >& rootChildren = scene_->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = rootChildren.Begin(); i != rootChildren.End(); ++i)
+    {
+        nodes_.Push(*i);
+        parents_.Push(M_MAX_UNSIGNED);
+    }
+
+    // Append the children of each level to form the next level
+    unsigned start = 0;
+    while (start < nodes_.Size())
+    {
+        unsigned end = nodes_.Size();
+        levels_.Push(start);
+        for (unsigned i = start; i < end; ++i)
+        {
+            const Vector<SharedPtr<Node> >& children = nodes_[i]->children_;
+            for (Vector<SharedPtr<Node> >::ConstIterator j = children.Begin(); j != children.End(); ++j)
+            {
+                nodes_.Push(*j);
+                parents_.Push(i);
+            }
+        }
+        start = end;
+    }
+    levels_.Push(nodes_.Size());
+
+    flags_.Resize(nodes_.Size());
+    worldTransforms_.Resize(nodes_.Size());
+    worldRotations_.Resize(nodes_.Size());
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+    {
+        nodes_[i]->transformIndex_ = i;
+        flags_[i] = 0;
+    }
+}
+
+void TransformStore::Update()
+{
+    if (pendingNodes_.Empty())
+        return;
+
+    // Take the pending nodes first so that world transform queries inside the update need not check the parent chain
+    updatingNodes_.Swap(pendingNodes_);
+
+    // A pending node whose parent is not updated in this pass has no pending ancestors, so the parent's cached world
+    // transform is valid. Copy it for the linear pass to read
+    unsigned firstLevel = M_MAX_UNSIGNED;
+    unsigned lastPendingLevel = 0;
+    for (unsigned i = 0; i < updatingNodes_.Size(); ++i)
+    {
+        Node* node = updatingNodes_[i];
+        unsigned level = GetLevel(node->transformIndex_);
+        firstLevel = Min(firstLevel, level);
+        lastPendingLevel = Max(lastPendingLevel, level);
+
+        Node* parent = node->parent_;
+        if (parent != scene_ && !node->IsParentTransformPending())
+        {
+            unsigned parentIndex = parent->transformIndex_;
+            worldTransforms_[parentIndex] = parent->GetWorldTransform();
+            worldRotations_[parentIndex] = parent->GetWorldRotation();
+        }
+    }
+
+    WorkQueue* queue = scene_->GetSubsystem<WorkQueue>();
+    bool threaded = queue && queue->GetNumThreads();
+    inheritedNodes_.Resize(threaded ? queue->GetNumThreads() + 1 : 1);
+
+    // Parents are on the previous level, so each level can be split freely once the previous one has finished. Stop when
+    // no node was updated on a level below the pending nodes
+    unsigned numInherited = 0;
+    for (unsigned i = firstLevel; i + 1 < levels_.Size(); ++i)
+    {
+        unsigned start = levels_[i];
+        unsigned end = levels_[i + 1];
+        if (threaded && end - start >= MIN_PARALLEL_NODES)
+            queue->ParallelFor(nodes_.Begin() + start, nodes_.Begin() + end, UpdateTransformsWork, this, &updateStats_);
+        else
+            UpdateTransforms(start, end, 0);
+
+        unsigned newNumInherited = 0;
+        for (unsigned j = 0; j < inheritedNodes_.Size(); ++j)
+            newNumInherited += inheritedNodes_[j].Size();
+        if (i > lastPendingLevel && newNumInherited == numInherited)
+            break;
+        numInherited = newNumInherited;
+    }
+
+    // Clear the flags of the updated nodes before notifying, as a listener may change the hierarchy. A listener may mark
+    // more nodes pending, which are left for the next update
+    for (unsigned i = 0; i < updatingNodes_.Size(); ++i)
+        flags_[updatingNodes_[i]->transformIndex_] = 0;
+    for (unsigned i = 0; i < inheritedNodes_.Size(); ++i)
+    {
+        const PODVector<Node*>& nodes = inheritedNodes_[i];
+        for (unsigned j = 0; j < nodes.Size(); ++j)
+            flags_[nodes[j]->transformIndex_] = 0;
+    }
+    updatingNodes_.Clear();
+
+    for (unsigned i = 0; i < inheritedNodes_.Size(); ++i)
+    {
+        PODVector<Node*>& nodes = inheritedNodes_[i];
+        for (unsigned j = 0; j < nodes.Size(); ++j)
+            nodes[j]->NotifyListeners();
+        nodes.Clear();
+    }
+}
+
+void TransformStore::PlaceNode(Node* node)
+{
+    if (node->transformIndex_ != M_MAX_UNSIGNED)
+        return;
+
+    Node* parent = node->parent_;
+    if (parent == scene_)
+        InsertEntry(node, 0, M_MAX_UNSIGNED);
+    else if (parent && parent->transformStore_ == this && parent->transformIndex_ != M_MAX_UNSIGNED)
+        InsertEntry(node, GetLevel(parent->transformIndex_) + 1, parent->transformIndex_);
+    else
+        return;
+
+    // Children may have been added to the scene before their parent was stored
+    const Vector<SharedPtr<Node> >& children = node->children_;
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        if ((*i)->transformStore_ == this)
+            PlaceNode(*i);
+    }
+}
+
+void TransformStore::UnplaceNode(Node* node)
+{
+    if (node->transformIndex_ == M_MAX_UNSIGNED)
+        return;
+
+    ResolvePending(node);
+
+    const Vector<SharedPtr<Node> >& children = node->children_;
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        if ((*i)->transformStore_ == this)
+            UnplaceNode(*i);
+    }
+
+    // The new parent of a reparented node may move while closing the gap, so clear the index first
+    unsigned index = node->transformIndex_;
+    node->transformIndex_ = M_MAX_UNSIGNED;
+    RemoveEntry(index);
+}
+
+void TransformStore::InsertEntry(Node* node, unsigned level, unsigned parent)
+{
+    unsigned numLevels = levels_.Size() - 1;
+    unsigned numNodes = nodes_.Size();
+    for (; numLevels <= level; ++numLevels)
+        levels_.Push(numNodes);
+
+    unsigned index = nodes_.Size();
+    nodes_.Resize(index + 1);
+    parents_.Resize(index + 1);
+    flags_.Resize(index + 1);
+    worldTransforms_.Resize(index + 1);
+    worldRotations_.Resize(index + 1);
+
+    // Open a slot at the end of the level by moving the first node of each deeper level to the end of its level
+    for (unsigned i = numLevels - 1; i > level; --i)
+    {
+        unsigned first = levels_[i];
+        if (first != index)
+            MoveEntry(first, index);
+        index = first;
+        ++levels_[i];
+    }
+    ++levels_.Back();
+
+    nodes_[index] = node;
+    parents_[index] = parent;
+    flags_[index] = 0;
+    node->transformIndex_ = index;
+}
+
+void TransformStore::RemoveEntry(unsigned index)
+{
+    // Fill the gap with the last node of the level, then move the gap through the deeper levels to the end
+    unsigned level = GetLevel(index);
+    for (unsigned i = level + 1; i < levels_.Size(); ++i)
+    {
+        unsigned last = levels_[i] - 1;
+        if (last != index)
+            MoveEntry(last, index);
+        index = last;
+        --levels_[i];
+    }
+
+    nodes_.Resize(index);
+    parents_.Resize(index);
+    flags_.Resize(index);
+    worldTransforms_.Resize(index);
+    worldRotations_.Resize(index);
+
+    // Remove the empty deepest levels
+    while (levels_.Size() > 1 && levels_[levels_.Size() - 2] == levels_.Back())
+        levels_.Pop();
+}
+
+void TransformStore::MoveEntry(unsigned from, unsigned to)
+{
+    Node* node = nodes_[from];
+    nodes_[to] = node;
+    parents_[to] = parents_[from];
+    flags_[to] = flags_[from];
+    node->transformIndex_ = to;
+
+    const Vector<SharedPtr<Node> >& children = node->children_;
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        Node* child = *i;
+        if (child->transformStore_ == this && child->transformIndex_ != M_MAX_UNSIGNED)
+            parents_[child->transformIndex_] = to;
+    }
+}
+
+unsigned TransformStore::GetLevel(unsigned index) const
+{
+    // Levels are few, so search from the start
+    unsigned level = 0;
+    while (levels_[level + 1] <= index)
+        ++level;
+    return level;
+}
+
+void TransformStore::UpdateTransforms(unsigned start, unsigned end, unsigned threadIndex)
+{
+    unsigned char* flags = &flags_[0];
+    const unsigned* parents = &parents_[0];
+    Node** nodes = &nodes_[0];
+    Matrix3x4* worldTransforms = &worldTransforms_[0];
+    Quaternion* worldRotations = &worldRotations_[0];
+    PODVector<Node*>& inheritedNodes = inheritedNodes_[threadIndex];
+
+    for (unsigned i = start; i < end; ++i)
+    {
+        unsigned parent = parents[i];
+        bool parentUpdated = parent != M_MAX_UNSIGNED && flags[parent];
+        if (flags[i])
+            flags[i] = TRANSFORM_UPDATED;
+        else if (parentUpdated)
+            flags[i] = TRANSFORM_INHERITED;
+        else
+            continue;
+
+        // A pending node notified its listeners when marked, but if its parent has moved since, notify them again
+        Node* node = nodes[i];
+        if (parentUpdated)
+            inheritedNodes.Push(node);
+
+        // Read the parent's world transform from the arrays instead of through the parent node
+        if (parent == M_MAX_UNSIGNED)
+        {
+            worldTransforms[i] = Matrix3x4(node->position_, node->rotation_, node->scale_);
+            worldRotations[i] = node->rotation_;
+        }
+        else
+        {
+            worldTransforms[i] = worldTransforms[parent] * Matrix3x4(node->position_, node->rotation_, node->scale_);
+            worldRotations[i] = worldRotations[parent] * node->rotation_;
+        }
+
+        node->worldTransform_ = worldTransforms[i];
+        node->worldRotation_ = worldRotations[i];
+        node->transformPendingIndex_ = M_MAX_UNSIGNED;
+        node->dirty_ = false;
+    }
+}
+
+void TransformStore::UpdateTransformsWork(const WorkItem* item, unsigned threadIndex)
+{
+    TransformStore* store = reinterpret_cast<TransformStore*>(item->aux_);
+    Node** base = &store->nodes_[0];
+    store->UpdateTransforms((unsigned)(reinterpret_cast<Node**>(item->start_) - base),
+        (unsigned)(reinterpret_cast<Node**>(item->end_) - base), threadIndex);
+}
+
+}
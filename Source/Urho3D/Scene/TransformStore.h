@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/RefCounted.h"
+#include "../Core/WorkQueue.h"
+#include "../Math/Matrix3x4.h"
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+
+/// Scene-owned array storage of the node hierarchy for batched world transform updates. Nodes are grouped by hierarchy depth, with parent indices and world transform matrices in parallel arrays indexed by the node's transform index, so that world transforms can be updated one hierarchy level at a time in a linear pass, splitting each level to worker threads. When enabled, a moved node only marks itself dirty; its children are reached in the next Update() instead of by recursion.
+class URHO3D_API TransformStore : public RefCounted
+{
+public:
+    /// Construct.
+    TransformStore(Scene* scene);
+    /// Destruct.
+    ~TransformStore();
+
+    /// Add a node. It is stored once its parent is. Called by Node.
+    void AddNode(Node* node);
+    /// Remove a node and its stored children. Called by Node.
+    void RemoveNode(Node* node);
+    /// Move a node and its children to the depth of their new parent. Called by Node.
+    void ReparentNode(Node* node);
+    /// Mark a stored node whose children have not been marked dirty yet. Called by Node.
+    void MarkPending(Node* node);
+    /// Mark a pending node's children dirty immediately and remove it from the pending nodes. Called by Node.
+    void ResolvePending(Node* node);
+    /// Rebuild the storage from the scene hierarchy. Called by Scene when the store is enabled.
+    void Rebuild();
+    /// Update world transforms of the pending nodes' children and notify their listeners. Must be called from the main thread.
+    void Update();
+
+    /// Return whether there are nodes with unresolved children.
+    bool HasPendingChanges() const { return !pendingNodes_.Empty(); }
+    /// Return number of stored nodes.
+    unsigned GetNumNodes() const { return nodes_.Size(); }
+
+private:
+    /// Store a node and its children if its parent is stored.
+    void PlaceNode(Node* node);
+    /// Remove a stored node and its stored children. Resolve the pending ones first.
+    void UnplaceNode(Node* node);
+    /// Insert a node at the end of a hierarchy level, moving one node of each deeper level to make room.
+    void InsertEntry(Node* node, unsigned level, unsigned parent);
+    /// Remove the node at an index, moving one node of each deeper level to close the gap.
+    void RemoveEntry(unsigned index);
+    /// Move the node at an index to another, free index.
+    void MoveEntry(unsigned from, unsigned to);
+    /// Return the hierarchy level of an index.
+    unsigned GetLevel(unsigned index) const;
+    /// Update world transforms in a range of one hierarchy level.
+    void UpdateTransforms(unsigned start, unsigned end, unsigned threadIndex);
+    /// Work function for updating a range of one hierarchy level in a worker thread.
+    static void UpdateTransformsWork(const WorkItem* item, unsigned threadIndex);
+
+    /// Scene.
+    Scene* scene_;
+    /// Nodes grouped by hierarchy level.
+    PODVector<Node*> nodes_;
+    /// Parent indices, M_MAX_UNSIGNED for children of the scene.
+    PODVector<unsigned> parents_;
+    /// Update flags.
+    PODVector<unsigned char> flags_;
+    /// World transforms. Valid for the nodes updated in the current pass and the parents of the pending nodes.
+    PODVector<Matrix3x4> worldTransforms_;
+    /// World rotations. Valid like the world transforms.
+    PODVector<Quaternion> worldRotations_;
+    /// Start indices of hierarchy levels, followed by the total node count.
+    PODVector<unsigned> levels_;
+    /// Nodes whose children have not been marked dirty. Nodes store their index to this list.
+    PODVector<Node*> pendingNodes_;
+    /// Pending nodes being updated in the current pass.
+    PODVector<Node*> updatingNodes_;
+    /// Nodes updated through their parents in the current pass, per thread.
+    Vector<PODVector<Node*> > inheritedNodes_;
+    /// Work splitting statistics for the parallel update.
+    ParallelForStats updateStats_;
+};
+
+}
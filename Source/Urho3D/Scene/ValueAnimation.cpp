@@ -351,11 +351,16 @@ bool ValueAnimation::IsValid() const
 
 Variant ValueAnimation::GetAnimationValue(float scaledTime)
 {
+    // Binary search for the first key frame after the time, starting from the second
     unsigned index = 1;
-    for (; index < keyFrames_.Size(); ++index)
+    unsigned end = keyFrames_.Size();
+    while (index < end)
     {
-        if (scaledTime < keyFrames_[index].time_)
-            break;
+        unsigned middle = (index + end) >> 1;
+        if (scaledTime < keyFrames_[middle].time_)
+            end = middle;
+        else
+            index = middle + 1;
     }
 
     if (index >= keyFrames_.Size() || !interpolatable_)
@@ -369,6 +374,12 @@ Variant ValueAnimation::GetAnimationValue(float scaledTime)
     }
 }
 
+void ValueAnimation::PrepareEvaluation()
+{
+    if (splineTangentsDirty_ && interpolationMethod_ == IM_SPLINE)
+        UpdateSplineTangents();
+}
+
 void ValueAnimation::GetEventFrames(float beginTime, float endTime, PODVector<const VAnimEventFrame*>& eventFrames) const
 {
     for (unsigned i = 0; i < eventFrames_.Size(); ++i)
@@ -123,6 +123,8 @@ public:
 
     /// Return animation value.
     Variant GetAnimationValue(float scaledTime);
+    /// Calculate spline tangents now if they are out of date. After this, GetAnimationValue() only reads the animation, so it can be called from several threads until the animation is modified.
+    void PrepareEvaluation();
 
     /// Has event frames.
     bool HasEventFrames() const { return !eventFrames_.Empty(); }
@@ -36,7 +36,11 @@ ValueAnimationInfo::ValueAnimationInfo(ValueAnimation* animation, WrapMode wrapM
     wrapMode_(wrapMode),
     speed_(speed),
     currentTime_(0.0f),
-    lastScaledTime_(0.0f)
+    lastScaledTime_(0.0f),
+    evaluatedScaledTime_(0.0f),
+    evaluated_(false),
+    evaluatedValid_(false),
+    evaluatedFinished_(false)
 {
     speed_ = Max(0.0f, speed_);
 }
@@ -47,7 +51,11 @@ ValueAnimationInfo::ValueAnimationInfo(Object* target, ValueAnimation* animation
     wrapMode_(wrapMode),
     speed_(speed),
     currentTime_(0.0f),
-    lastScaledTime_(0.0f)
+    lastScaledTime_(0.0f),
+    evaluatedScaledTime_(0.0f),
+    evaluated_(false),
+    evaluatedValid_(false),
+    evaluatedFinished_(false)
 {
     speed_ = Max(0.0f, speed_);
 }
@@ -58,7 +66,11 @@ ValueAnimationInfo::ValueAnimationInfo(const ValueAnimationInfo& other) :
     wrapMode_(other.wrapMode_),
     speed_(other.speed_),
     currentTime_(0.0f),
-    lastScaledTime_(0.0f)
+    lastScaledTime_(0.0f),
+    evaluatedScaledTime_(0.0f),
+    evaluated_(false),
+    evaluatedValid_(false),
+    evaluatedFinished_(false)
 {
 }
 
@@ -68,10 +80,8 @@ ValueAnimationInfo::~ValueAnimationInfo()
 
 bool ValueAnimationInfo::Update(float timeStep)
 {
-    if (!animation_ || !target_)
-        return true;
-
-    return SetTime(currentTime_ + timeStep * speed_);
+    Evaluate(timeStep);
+    return ApplyEvaluated();
 }
 
 bool ValueAnimationInfo::SetTime(float time)
@@ -80,31 +90,56 @@ bool ValueAnimationInfo::SetTime(float time)
         return true;
 
     currentTime_ = time;
+    Evaluate(0.0f);
+    return ApplyEvaluated();
+}
 
-    if (!animation_->IsValid())
-        return true;
+void ValueAnimationInfo::Evaluate(float timeStep)
+{
+    evaluated_ = true;
+    evaluatedValid_ = false;
+    evaluatedFinished_ = true;
+
+    if (!animation_ || !target_)
+        return;
+
+    currentTime_ += timeStep * speed_;
 
-    bool finished = false;
+    if (!animation_->IsValid())
+        return;
 
     // Calculate scale time by wrap mode
-    float scaledTime = CalculateScaledTime(currentTime_, finished);
+    evaluatedFinished_ = false;
+    evaluatedScaledTime_ = CalculateScaledTime(currentTime_, evaluatedFinished_);
+    evaluatedValue_ = animation_->GetAnimationValue(evaluatedScaledTime_);
+    evaluatedValid_ = true;
+}
+
+bool ValueAnimationInfo::ApplyEvaluated()
+{
+    if (!evaluated_)
+        return false;
+
+    evaluated_ = false;
+    if (!evaluatedValid_ || !target_)
+        return true;
 
     // Apply to the target object
-    ApplyValue(animation_->GetAnimationValue(scaledTime));
+    ApplyValue(evaluatedValue_);
 
     // Send keyframe event if necessary
     if (animation_->HasEventFrames())
     {
         PODVector<const VAnimEventFrame*> eventFrames;
-        GetEventFrames(lastScaledTime_, scaledTime, eventFrames);
+        GetEventFrames(lastScaledTime_, evaluatedScaledTime_, eventFrames);
 
         for (unsigned i = 0; i < eventFrames.Size(); ++i)
             target_->SendEvent(eventFrames[i]->eventType_, const_cast<VariantMap&>(eventFrames[i]->eventData_));
     }
 
-    lastScaledTime_ = scaledTime;
+    lastScaledTime_ = evaluatedScaledTime_;
 
-    return finished;
+    return evaluatedFinished_;
 }
 
 Object* ValueAnimationInfo::GetTarget() const
@@ -49,6 +49,10 @@ public:
     bool Update(float timeStep);
     /// Set time position and apply. Return true when the animation is finished. No-op when the target object is not defined.
     bool SetTime(float time);
+    /// Advance time position and calculate the new value without applying it. Does not modify the target object or send events, so it can be called from a worker thread after ValueAnimation::PrepareEvaluation().
+    void Evaluate(float timeStep);
+    /// Apply the value calculated by Evaluate() and send the event frames passed. Return true when the animation is finished. No-op if not evaluated.
+    bool ApplyEvaluated();
 
     /// Set wrap mode.
     void SetWrapMode(WrapMode wrapMode) { wrapMode_ = wrapMode; }
@@ -91,6 +95,16 @@ protected:
     float currentTime_;
     /// Last scaled time.
     float lastScaledTime_;
+    /// Value calculated by Evaluate().
+    Variant evaluatedValue_;
+    /// Scaled time calculated by Evaluate().
+    float evaluatedScaledTime_;
+    /// Evaluated, waiting to be applied flag.
+    bool evaluated_;
+    /// Evaluated value valid flag.
+    bool evaluatedValid_;
+    /// Finished on evaluation flag.
+    bool evaluatedFinished_;
 };
 
 }
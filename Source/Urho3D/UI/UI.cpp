@@ -301,6 +301,7 @@ void UI::Update(float timeStep)
     assert(rootElement_ && rootModalElement_);
 
     URHO3D_PROFILE(UpdateUI);
+    URHO3D_MEMORY_CATEGORY(MC_UI);
 
     // Expire hovers
     for (HashMap<WeakPtr<UIElement>, bool>::Iterator i = hoveredElements_.Begin(); i != hoveredElements_.End(); ++i)
@@ -398,6 +399,7 @@ void UI::RenderUpdate()
     assert(rootElement_ && rootModalElement_ && graphics_);
 
     URHO3D_PROFILE(GetUIBatches);
+    URHO3D_MEMORY_CATEGORY(MC_UI);
 
     uiRendered_ = false;
 
@@ -435,6 +437,7 @@ void UI::Render(bool resetRenderTargets)
         return;
 
     URHO3D_PROFILE(RenderUI);
+    URHO3D_MEMORY_CATEGORY(MC_UI);
 
     // If the OS cursor is visible, apply its shape now if changed
     bool osCursorVisible = GetSubsystem<Input>()->IsMouseVisible();
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Drawable.h"
 #include "../Math/Frustum.h"
 
@@ -127,6 +128,8 @@ private:
     Frustum frustum_;
     /// View mask of current camera for visibility checking.
     unsigned viewMask_;
+    /// Chunking state for the threaded visibility check.
+    ParallelForStats checkVisibilityStats_;
     /// Cached materials.
     HashMap<Texture2D*, HashMap<int, SharedPtr<Material> > > cachedMaterials_;
     /// Cached techniques per blend mode.